@@ -107,6 +107,9 @@ FL_EXPORT int fl_wcwidth_(unsigned int ucs);
  * depending on original build options */
 FL_EXPORT int fl_wcwidth(const char *src);
 
+/* return width of UTF-8 string of srclen bytes in columns, or -1 */
+FL_EXPORT int fl_wcswidth(const char *src, int srclen);
+
 /* OD: Return true if the character is non-spacing */
 FL_EXPORT unsigned int fl_nonspacing(unsigned int ucs);
 
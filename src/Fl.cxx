@@ -141,6 +141,8 @@ int             Fl::damage_,
                 Fl::scrollbar_size_ = 16,
                 Fl::menu_linespacing_ = 4;      // 4: was a local macro in Fl_Menu.cxx called "LEADING"
 
+double          Fl::max_fps_ = 0;
+
 char            *Fl::e_text = (char *)"";
 int             Fl::e_length;
 const char      *Fl::e_clipboard_type = "";
@@ -686,6 +688,47 @@ void Fl::redraw() {
   for (Fl_X* i = Fl_X::first; i; i = i->next) i->w->redraw();
 }
 
+// Returns the current time in seconds
+static double frame_clock() {
+  time_t sec;
+  int usec;
+  Fl::system_driver()->gettime(&sec, &usec);
+  return double(sec) + usec / 1000000.0;
+}
+
+// Wakes up Fl::wait() when a deferred window can be drawn
+// Deferred windows do not keep Fl::damage() set, so that the event loop can
+// sleep until their next frame is due. This wakes it up and lets Fl::flush()
+// look at them again.
+static void frame_timeout(void *) { Fl::damage(FL_DAMAGE_CHILD); }
+
+/**
+  Sets the maximum number of times per second that a window is drawn.
+
+  By default Fl::flush() draws each damaged window immediately. When
+  redraw() is called much more often than the screen can show, e.g. by
+  a fast data feed, most of the frames are never seen and drawing them
+  slows down the handling of user input.
+
+  When \p fps is positive, Fl::flush() draws a window at most once per
+  1/\p fps seconds. Damage that occurs earlier is accumulated and drawn
+  together in the next frame, and the time in between is used to handle
+  events. Fl_Window::frame_stats() tells how many frames were drawn,
+  skipped or drawn late.
+
+  Note that this also delays the drawing by explicit Fl::flush() calls.
+
+  \param[in] fps maximum frame rate, 0 (the default) for no limit.
+  \since 1.4.0
+*/
+void Fl::max_fps(double fps) {
+  max_fps_ = fps > 0 ? fps : 0;
+  if (!max_fps_ && Fl::has_timeout(frame_timeout)) {
+    Fl::remove_timeout(frame_timeout);
+    damage_ = FL_DAMAGE_CHILD;  // draw the deferred windows now
+  }
+}
+
 /**
   Causes all the windows that need it to be redrawn and graphics forced
   out through the pipes.
@@ -700,13 +743,36 @@ void Fl::redraw() {
 void Fl::flush() {
   if (damage()) {
     damage_ = 0;
+    double now = 0, interval = 0, wakeup = FOREVER;
+    if (max_fps_ > 0) {
+      interval = 1.0 / max_fps_;
+      now = frame_clock();
+    }
     for (Fl_X* i = Fl_X::first; i; i = i->next) {
       Fl_Window* wi = i->w;
-      if (Fl_Window_Driver::driver(wi)->wait_for_expose_value) {damage_ = 1; continue;}
+      Fl_Window_Driver *d = Fl_Window_Driver::driver(wi);
+      if (d->wait_for_expose_value) {damage_ = 1; continue;}
       if (!wi->visible_r()) continue;
       if (wi->damage()) {
-        Fl_Window_Driver::driver(wi)->flush();
+        if (interval > 0) {
+          if (d->frame_due - now > interval) d->frame_due = now; // clock was set back
+          if (now < d->frame_due) {
+            // too early: keep the damage, it is drawn with later damage
+            // when frame_timeout() wakes up the event loop
+            if (!d->frame_deferred) {
+              d->frame_deferred = 1;
+              d->frames_skipped++;
+            }
+            if (d->frame_due - now < wakeup) wakeup = d->frame_due - now;
+            continue;
+          }
+          if (d->frame_deferred && now > d->frame_due + interval) d->frames_late++;
+          d->frame_deferred = 0;
+          d->frame_due = now + interval;
+        }
+        d->flush();
         wi->clear_damage();
+        d->frames_drawn++;
       }
       // destroy damage regions for windows that don't use them:
       if (i->region) {
@@ -714,6 +780,10 @@ void Fl::flush() {
         i->region = 0;
       }
     }
+    if (wakeup < FOREVER) {
+      Fl::remove_timeout(frame_timeout);
+      Fl::add_timeout(wakeup, frame_timeout);
+    }
   }
   screen_driver()->flush();
 }
@@ -20,6 +20,8 @@
 //   Fl_File_Browser::item_height()     - Return the height of a list item.
 //   Fl_File_Browser::item_width()      - Return the width of a list item.
 //   Fl_File_Browser::item_draw()       - Draw a list item.
+//   Fl_File_Browser::find_icon()       - Find the icon of a list item.
+//   Fl_File_Browser::find_icons()      - Find the icons of some list items.
 //   Fl_File_Browser::Fl_File_Browser() - Create a Fl_File_Browser widget.
 //   Fl_File_Browser::load()            - Load a directory into the browser.
 //   Fl_File_Browser::filter()          - Set the filename filter.
@@ -63,6 +65,17 @@ struct FL_BLINE                 // data is in a linked list of these
   char          txt[1];         // start of allocated array
 };
 
+//
+// Flag (unused by Fl_Browser) of lines whose icon has not been looked up
+// yet. Their data() stays NULL until then, so it is always either NULL or
+// an Fl_File_Icon pointer.
+//
+
+#define ICON_PENDING 4
+
+// Number of icons looked up each time the application is idle
+#define ICONS_PER_IDLE 64
+
 
 //
 // 'Fl_File_Browser::full_height()' - Return the height of the list.
@@ -269,6 +282,10 @@ Fl_File_Browser::item_draw(void *p,     // I - List item data
   }
   else
   {
+    // Look up the icon if not yet done...
+    if (line->flags & ICON_PENDING)
+      find_icon(line);
+
     // Draw the icon if it is set...
     if (line->data)
       ((Fl_File_Icon *)line->data)->draw(X, Y, iconsize_, iconsize_,
@@ -355,6 +372,58 @@ Fl_File_Browser::item_draw(void *p,     // I - List item data
 }
 
 
+//
+// 'Fl_File_Browser::find_icon()' - Find the icon of a list item.
+//
+
+void
+Fl_File_Browser::find_icon(void *p) const       // I - List item data
+{
+  FL_BLINE      *line = (FL_BLINE *)p;          // Pointer to line
+  char          filename[4096];                 // Current file
+
+  line->flags &= ~ICON_PENDING;
+  if (line->data) return;                       // set by the application
+
+  fl_snprintf(filename, sizeof(filename), "%s/%s", icon_dir_, line->txt);
+  line->data = Fl_File_Icon::find(filename);
+}
+
+
+//
+// 'Fl_File_Browser::find_icons()' - Find the icons of some list items.
+//
+// Looks up the icons of the next n lines that don't have one yet, and
+// stops the idle callback when all lines are done.
+//
+
+void
+Fl_File_Browser::find_icons(int n)              // I - Number of lines
+{
+  int           num_lines = size();             // Number of lines
+
+  for (; icon_line_ <= num_lines && n > 0; icon_line_ ++) {
+    void *line = item_at(icon_line_);
+    if (((FL_BLINE *)line)->flags & ICON_PENDING) {
+      find_icon(line);
+      n --;
+    }
+  }
+
+  if (icon_line_ > num_lines) {
+    Fl::remove_idle(find_icons_cb, this);
+    icon_line_ = 0;
+  }
+}
+
+
+void
+Fl_File_Browser::find_icons_cb(void *v)         // I - File browser
+{
+  ((Fl_File_Browser *)v)->find_icons(ICONS_PER_IDLE);
+}
+
+
 /**
   The constructor creates the Fl_File_Browser widget at the specified position and size.
   The destructor destroys the widget and frees all memory that has been allocated.
@@ -372,12 +441,16 @@ Fl_File_Browser::Fl_File_Browser(int        X,  // I - Upper-lefthand X coordina
   iconsize_  = (uchar)(3 * textsize() / 2);
   filetype_  = FILES;
   errmsg_    = NULL;
+  icon_dir_  = NULL;
+  icon_line_ = 0;
 }
 
 
 // DTOR
 Fl_File_Browser::~Fl_File_Browser() {
   errmsg(NULL);       // free()s prev errmsg, if any
+  Fl::remove_idle(find_icons_cb, this);
+  free(icon_dir_);
 }
 
 
@@ -396,6 +469,14 @@ void Fl_File_Browser::errmsg(const char* emsg) {
   Loads the specified directory into the browser. If icons have been
   loaded then the correct icon is associated with each file in the list.
 
+  Looking up the icon of a file requires information about the file from
+  the file system, which can be slow for large or remote directories.
+  Therefore the icons of the visible lines are looked up when they are
+  drawn, and the icons of all other lines are looked up in small batches
+  whenever the application is idle. Until then, the data() of these lines
+  is NULL; afterwards it is the Fl_File_Icon of the file, or NULL if there
+  is none. A non-NULL data() set by the application is left unchanged.
+
   If directory is "", all mount points (unix) or drive letters (Windows)
   are listed.
 
@@ -421,6 +502,10 @@ Fl_File_Browser::load(const char     *directory,// I - Directory to load
 
   clear();
 
+  // Stop looking up the icons of the previous directory...
+  Fl::remove_idle(find_icons_cb, this);
+  icon_line_ = 0;
+
   directory_ = directory;
 
   if (!directory) {
@@ -452,13 +537,16 @@ Fl_File_Browser::load(const char     *directory,// I - Directory to load
       return 0;
     }
 
+    // The icons are looked up later, see find_icons()...
+    icon = NULL;
+    free(icon_dir_);
+    icon_dir_ = fl_strdup(directory_);
+
     for (i = 0, num_dirs = 0; i < num_files; i ++) {
       if (strcmp(files[i]->d_name, "./")) {
         fl_snprintf(filename, sizeof(filename), "%s/%s", directory_, files[i]->d_name);
 
-        icon = Fl_File_Icon::find(filename);
-        if ((icon && icon->type() == Fl_File_Icon::DIRECTORY) ||
-            Fl::system_driver()->filename_isdir_quick(filename)) {
+        if (Fl::system_driver()->filename_isdir_quick(filename)) {
           num_dirs ++;
           insert(num_dirs, files[i]->d_name, icon);
         } else if (filetype_ == FILES &&
@@ -471,6 +559,13 @@ Fl_File_Browser::load(const char     *directory,// I - Directory to load
     }
 
     free(files);
+
+    if (Fl_File_Icon::first()) {
+      for (void *line = item_first(); line; line = item_next(line))
+        ((FL_BLINE *)line)->flags |= ICON_PENDING;
+      icon_line_ = 1;
+      Fl::add_idle(find_icons_cb, this);
+    }
   }
 
   return (num_files);
@@ -32,6 +32,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <ctype.h>
+#include <limits.h>
 #include <FL/fl_utf8.h>
 #include "flstring.h"
 #include <FL/Fl.H>
@@ -48,6 +50,164 @@
 Fl_File_Icon    *Fl_File_Icon::first_ = (Fl_File_Icon *)0;
 
 
+//
+// Compiled icon patterns...
+//
+// Most patterns only match file name extensions, like "*.png",
+// "*.{htm|html}" or "{*.gif|*.GIF}". The extensions of these patterns
+// are kept in a hash table, so find() can look up the first icon that
+// matches an extension without testing all patterns. Only the other
+// patterns that come before that icon in the list are still tested
+// with fl_filename_match(). The table is built by the first call of
+// find() and rebuilt after icons are created or destroyed.
+//
+
+#define MAX_EXT 64                      // Maximum length of an extension + 1
+
+struct Icon_Pattern {                   // Icon with an extension or another pattern
+  const char    *ext;                   // Lowercase extension or NULL
+  int           pos;                    // Position in the list of icons
+  Fl_File_Icon  *icon;                  // Icon
+};
+
+static Icon_Pattern     *ext_patterns_ = 0;     // Extensions, sorted by ext and pos
+static int              num_ext_patterns_ = 0;
+static Icon_Pattern     *other_patterns_ = 0;   // Other patterns, sorted by pos
+static int              num_other_patterns_ = 0;
+static int              *ext_hash_ = 0;         // Index+1 of the first ext_patterns_ of an ext
+static int              ext_hash_size_ = 0;
+static char             *ext_names_ = 0;        // Storage of all extensions
+static int              patterns_compiled_ = 0;
+
+
+// FNV-1a hash of an extension
+static unsigned ext_hash(const char *ext) {
+  unsigned h = 2166136261U;
+  for (; *ext; ext ++)
+    h = (h ^ (unsigned char)*ext) * 16777619U;
+  return h;
+}
+
+
+// Copies a plain extension of n characters in lowercase to ext, returns
+// 0 if it contains pattern or path characters.
+static int copy_ext(char *ext, const char *p, int n) {
+  if (n >= MAX_EXT) return 0;
+  for (int i = 0; i < n; i ++) {
+    if (strchr("*?[]{}|,\\./", p[i])) return 0;
+    ext[i] = (char)tolower((unsigned char)p[i]);
+  }
+  ext[n] = '\0';
+  return 1;
+}
+
+
+// Stores the extensions matched by pattern p in exts, separated by nul
+// characters, and returns their number, or 0 if p is not of the form
+// "*.ext", "*.{ext1|ext2|...}" or "{*.ext1|*.ext2|...}".
+static int pattern_exts(const char *p, char *exts) {
+  int   n = 0;                          // Number of extensions
+  int   braces;                         // Alternatives are in braces
+  int   stars;                          // Alternatives start with "*."
+
+  if (p[0] == '*' && p[1] == '.') {
+    p += 2;
+    if (*p != '{')
+      return copy_ext(exts, p, (int)strlen(p));
+    braces = 1;
+    stars  = 0;
+  } else if (p[0] == '{') {
+    braces = 1;
+    stars  = 1;
+  } else
+    return 0;
+
+  for (p ++;; p ++) {
+    if (stars) {
+      if (p[0] != '*' || p[1] != '.') return 0;
+      p += 2;
+    }
+    int len = (int)strcspn(p, "|,}");
+    if (!copy_ext(exts, p, len)) return 0;
+    exts += len + 1;
+    n ++;
+    p += len;
+    if (*p == '}') break;
+    if (*p == '\0') return 0;
+  }
+
+  return (braces && p[1] == '\0') ? n : 0;
+}
+
+
+// Sorts extension patterns by extension and position
+static int compare_patterns(const void *a, const void *b) {
+  const Icon_Pattern *pa = (const Icon_Pattern *)a;
+  const Icon_Pattern *pb = (const Icon_Pattern *)b;
+  int c = strcmp(pa->ext, pb->ext);
+  return c ? c : pa->pos - pb->pos;
+}
+
+
+// Builds the extension hash table and the list of other patterns
+static void compile_patterns() {
+  Fl_File_Icon  *current;               // Current icon in list
+  int           pos, num_icons = 0, num_exts = 0;
+  size_t        names_size = 0;
+  char          exts[1024];             // Extensions of the current pattern
+
+  free(ext_patterns_);
+  free(other_patterns_);
+  free(ext_hash_);
+  free(ext_names_);
+
+  for (current = Fl_File_Icon::first(); current; current = current->next()) {
+    num_icons ++;
+    names_size += strlen(current->pattern()) + 1;
+  }
+
+  ext_patterns_   = (Icon_Pattern *)malloc((names_size + 1) * sizeof(Icon_Pattern));
+  other_patterns_ = (Icon_Pattern *)malloc((num_icons + 1) * sizeof(Icon_Pattern));
+  ext_names_      = (char *)malloc(names_size + 1);
+  num_ext_patterns_ = num_other_patterns_ = 0;
+
+  char *name = ext_names_;
+  for (current = Fl_File_Icon::first(), pos = 0; current; current = current->next(), pos ++) {
+    const char *pattern = current->pattern();
+    int n = strlen(pattern) < sizeof(exts) ? pattern_exts(pattern, exts) : 0;
+    if (n == 0) {
+      Icon_Pattern &o = other_patterns_[num_other_patterns_ ++];
+      o.ext  = NULL;
+      o.pos  = pos;
+      o.icon = current;
+      continue;
+    }
+    for (const char *ext = exts; n > 0; n --, ext += strlen(ext) + 1) {
+      Icon_Pattern &e = ext_patterns_[num_ext_patterns_ ++];
+      strcpy(name, ext);
+      e.ext  = name;
+      e.pos  = pos;
+      e.icon = current;
+      name  += strlen(name) + 1;
+      num_exts ++;
+    }
+  }
+
+  qsort(ext_patterns_, num_ext_patterns_, sizeof(Icon_Pattern), compare_patterns);
+
+  for (ext_hash_size_ = 16; ext_hash_size_ < num_exts * 2; ext_hash_size_ *= 2) {/*empty*/}
+  ext_hash_ = (int *)calloc(ext_hash_size_, sizeof(int));
+  for (int i = 0; i < num_ext_patterns_; i ++) {
+    if (i > 0 && !strcmp(ext_patterns_[i].ext, ext_patterns_[i - 1].ext)) continue;
+    unsigned h = ext_hash(ext_patterns_[i].ext) & (ext_hash_size_ - 1);
+    while (ext_hash_[h]) h = (h + 1) & (ext_hash_size_ - 1);
+    ext_hash_[h] = i + 1;
+  }
+
+  patterns_compiled_ = 1;
+}
+
+
 // Registers the FL_ICON_LABEL drawing function
 Fl_Labeltype fl_define_FL_ICON_LABEL() {
   Fl::set_labeltype(_FL_ICON_LABEL, Fl_File_Icon::labeltype, 0);
@@ -88,6 +248,7 @@ Fl_File_Icon::Fl_File_Icon(const char *p,       /* I - Filename pattern */
   // And add the icon to the list of icons...
   next_  = first_;
   first_ = this;
+  patterns_compiled_ = 0;
 }
 
 
@@ -113,6 +274,7 @@ Fl_File_Icon::~Fl_File_Icon() {
     else
       first_ = current->next_;
   }
+  patterns_compiled_ = 0;
 
   // Free any memory used...
   if (alloc_data_)
@@ -156,6 +318,8 @@ Fl_File_Icon::add(short d)      // I - Data to add
 
 /**
   Finds an icon that matches the given filename and file type.
+
+  The first icon in the list whose type and pattern match is returned.
   \param[in] filename name of file
   \param[in] filetype enumerated file type
   \return matching file icon or NULL
@@ -164,8 +328,11 @@ Fl_File_Icon *                          // O - Matching file icon or NULL
 Fl_File_Icon::find(const char *filename,// I - Name of file */
                    int        filetype) // I - Enumerated file type
 {
-  Fl_File_Icon  *current;               // Current file in list
+  Fl_File_Icon  *current = 0;           // Matching icon
   const char    *name;                  // Base name of filename
+  const char    *dot;                   // Start of the extension
+  char          ext[MAX_EXT];           // Lowercase extension
+  int           pos = INT_MAX;          // Position of the matching icon
 
 
   // Get file information if needed...
@@ -173,16 +340,42 @@ Fl_File_Icon::find(const char *filename,// I - Name of file */
     filetype = Fl::system_driver()->file_type(filename);
   }
 
+  if (!patterns_compiled_)
+    compile_patterns();
+
+  // Look up the first icon that matches the extension, if any. An
+  // extension pattern matches the filename if and only if it matches the
+  // base name, because it only looks at the end of the name.
+  dot = strrchr(filename, '.');
+  if (dot && copy_ext(ext, dot + 1, (int)strlen(dot + 1))) {
+    unsigned h = ext_hash(ext) & (ext_hash_size_ - 1);
+    for (; ext_hash_[h]; h = (h + 1) & (ext_hash_size_ - 1)) {
+      int i = ext_hash_[h] - 1;
+      if (strcmp(ext_patterns_[i].ext, ext)) continue;
+      for (; i < num_ext_patterns_ && !strcmp(ext_patterns_[i].ext, ext); i ++) {
+        int t = ext_patterns_[i].icon->type_;
+        if (t == filetype || t == ANY) {
+          current = ext_patterns_[i].icon;
+          pos     = ext_patterns_[i].pos;
+          break;
+        }
+      }
+      break;
+    }
+  }
+
   // Look at the base name in the filename
   name = fl_filename_name(filename);
 
-  // Loop through the available file types and return any match that
-  // is found...
-  for (current = first_; current != (Fl_File_Icon *)0; current = current->next_)
-    if ((current->type_ == filetype || current->type_ == ANY) &&
-        (fl_filename_match(filename, current->pattern_) ||
-         fl_filename_match(name, current->pattern_)))
-      break;
+  // Then test the other patterns of the icons before that one, and return
+  // the first match that is found...
+  for (int i = 0; i < num_other_patterns_ && other_patterns_[i].pos < pos; i ++) {
+    Fl_File_Icon *icon = other_patterns_[i].icon;
+    if ((icon->type_ == filetype || icon->type_ == ANY) &&
+        (fl_filename_match(filename, icon->pattern_) ||
+         fl_filename_match(name, icon->pattern_)))
+      return (icon);
+  }
 
   // Return the match (if any)...
   return (current);
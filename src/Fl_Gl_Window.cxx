@@ -37,6 +37,7 @@ extern int fl_gl_load_plugin;
 
 #ifdef FL_CFG_GFX_OPENGL
 #include "drivers/OpenGL/Fl_OpenGL_Display_Device.H"
+#include "drivers/OpenGL/Fl_OpenGL_Graphics_Driver.H"
 #endif
 
 ////////////////////////////////////////////////////////////////
@@ -413,6 +414,7 @@ void Fl_Gl_Window::draw() {
   glEnable(GL_BLEND); // FIXME: push on state stack
 
   Fl_Window::draw();
+  ((Fl_OpenGL_Graphics_Driver*)Fl_OpenGL_Display_Device::display_device()->driver())->flush_vertices();
 
   glPopMatrix();
   glPopAttrib();
@@ -525,6 +525,12 @@ void Fl_Graphics_Driver::pie(int x, int y, int w, int h, double a1, double a2) {
 /** see fl_line_style() */
 void Fl_Graphics_Driver::line_style(int style, int width, char* dashes) {}
 
+/** see fl_antialias(int) */
+void Fl_Graphics_Driver::antialias(int state) {}
+
+/** see fl_antialias() */
+int Fl_Graphics_Driver::antialias() { return 0; }
+
 /** see fl_color(Fl_Color) */
 void Fl_Graphics_Driver::color(Fl_Color c) { color_ = c; }
 
@@ -22,6 +22,7 @@
 #include <FL/Fl_Group.H>
 #include "Fl_Window_Driver.H"
 #include <FL/Fl_Rect.H>
+#include <FL/Fl_Image_Surface.H>
 #include <FL/fl_draw.H>
 
 #include <stdlib.h> // malloc etc.
@@ -366,6 +367,8 @@ Fl_Group::Fl_Group(int X,int Y,int W,int H,const char *l)
   resizable_ = this;
   bounds_ = 0; // this is allocated when first resize() is done
   sizes_ = 0; // see bounds_ (FLTK 1.3 compatibility)
+  cache_ = 0; // this is allocated when first drawn with cached() set
+  cache_scale_ = 1;
 
   // Subclasses may want to construct child objects as part of their
   // constructor, so make sure they are add()'d to this object.
@@ -453,6 +456,7 @@ Fl_Group::~Fl_Group() {
   if (current_ == this)
     end();
   clear();
+  delete cache_;
 }
 
 /**
@@ -801,19 +805,135 @@ void Fl_Group::draw_children() {
                  h() - Fl::box_dh(box()));
   }
 
+  // children before the last opaque child may be hidden by it or by
+  // other opaque children, see Fl_Widget::opaque()
+  int last_opaque = children_;
+  while (last_opaque-- > 0 && !hides_others(*a[last_opaque])) {}
+
   if (damage() & ~FL_DAMAGE_CHILD) { // redraw the entire thing:
-    for (int i=children_; i--;) {
-      Fl_Widget& o = **a++;
-      draw_child(o);
+    for (int i = 0; i < children_; i++) {
+      Fl_Widget& o = *a[i];
+      if (i < last_opaque && is_hidden(i)) o.clear_damage();
+      else draw_child(o);
       draw_outside_label(o);
     }
   } else {      // only redraw the children that need it:
-    for (int i=children_; i--;) update_child(**a++);
+    for (int i = 0; i < children_; i++) {
+      Fl_Widget& o = *a[i];
+      if (i < last_opaque && o.damage() && is_hidden(i)) o.clear_damage();
+      else update_child(o);
+    }
   }
 
   if (clip_children()) fl_pop_clip();
 }
 
+// Returns non-zero if the widget hides the widgets under it
+int Fl_Group::hides_others(const Fl_Widget& o) {
+  return o.opaque() && o.visible() && o.type() < FL_WINDOW;
+}
+
+// Returns non-zero if child i lies entirely inside an opaque later child.
+// Subwindows are never hidden: they are drawn by their own flush() and
+// their damage must not be cleared here.
+int Fl_Group::is_hidden(int i) const {
+  Fl_Widget*const* a = array();
+  const Fl_Widget& o = *a[i];
+  if (o.type() >= FL_WINDOW) return 0;
+  for (int j = i + 1; j < children_; j++) {
+    const Fl_Widget& p = *a[j];
+    if (hides_others(p) &&
+        o.x() >= p.x() && o.y() >= p.y() &&
+        o.x() + o.w() <= p.x() + p.w() && o.y() + o.h() <= p.y() + p.h())
+      return 1;
+  }
+  return 0;
+}
+
+/**
+  Sets whether the group keeps a copy of its drawing in an offscreen buffer.
+
+  A cached group is drawn into an Fl_Image_Surface, and its parent copies
+  this image to the window. When the parent is redrawn, e.g. after an
+  expose event or when scrolling, the image is copied again without
+  calling the draw() method of the group or of its children. This saves
+  a lot of time for complex groups that seldom change, like tool bars,
+  status panels or the pages of an Fl_Tabs.
+
+  The group and the damaged children are drawn into the image again when
+  the group or one of its children calls redraw(), so a child whose
+  appearance changes must call redraw() as usual. Subwindows and
+  Fl_Gl_Window children are not cached. Areas of the group that are not
+  painted by its box or its children show the color() of the nearest
+  parent with a box. The image is only used when drawing to the display,
+  not when printing.
+
+  The image uses as much memory as an Fl_Double_Window of the same size.
+  It is deleted when \p c is 0.
+
+  The default is not to cache (0).
+  \param[in] c set or clear the cached flag
+  \see cached()
+  \version 1.4.0
+*/
+void Fl_Group::cached(int c) {
+  if (c) {
+    set_flag(CACHED);
+  } else {
+    clear_flag(CACHED);
+    delete cache_;
+    cache_ = 0;
+  }
+}
+
+// Returns the widget as a group if its parent must draw it with draw_cached()
+Fl_Group *Fl_Group::cached_group(Fl_Widget& o) {
+  if (!(o.flags() & CACHED) || o.type() >= FL_WINDOW ||
+      Fl_Surface_Device::surface() != Fl_Display_Device::display_device())
+    return 0;
+  return o.as_group();
+}
+
+// Draws what is damaged in the group into cache_, then copies cache_
+// to the current window. The damage bits are cleared.
+void Fl_Group::draw_cached() {
+  uchar d = damage();
+  float s = fl_graphics_driver->scale();
+  if (cache_) {
+    int cw, ch;
+    cache_->printable_rect(&cw, &ch);
+    if (cw != w() || ch != h() || cache_scale_ != s) {
+      delete cache_;
+      cache_ = 0;
+    }
+  }
+  if (!cache_) {
+    if (w() <= 0 || h() <= 0) {
+      clear_damage();
+      return;
+    }
+    cache_ = new Fl_Image_Surface(w(), h(), 1);
+    cache_scale_ = s;
+    d = FL_DAMAGE_ALL;
+  }
+  if (d) {
+    Fl_Surface_Device::push_current(cache_);
+    cache_->translate(-x(), -y());
+    if (d & ~FL_DAMAGE_CHILD) {
+      // fill what the box of the group may not paint
+      Fl_Widget *p = this;
+      while (p->parent() && p->box() == FL_NO_BOX) p = p->parent();
+      fl_rectf(x(), y(), w(), h(), p->color());
+    }
+    clear_damage(d);
+    draw();
+    cache_->untranslate();
+    Fl_Surface_Device::pop_current();
+  }
+  fl_copy_offscreen(x(), y(), w(), h(), cache_->offscreen(), 0, 0);
+  clear_damage();
+}
+
 void Fl_Group::draw() {
   if (damage() & ~FL_DAMAGE_CHILD) { // redraw the entire thing:
     draw_box();
@@ -833,6 +953,11 @@ void Fl_Group::draw() {
 void Fl_Group::update_child(Fl_Widget& widget) const {
   if (widget.damage() && widget.visible() && widget.type() < FL_WINDOW &&
       fl_not_clipped(widget.x(), widget.y(), widget.w(), widget.h())) {
+    Fl_Group *g = cached_group(widget);
+    if (g) {
+      g->draw_cached();
+      return;
+    }
     widget.draw();
     widget.clear_damage();
   }
@@ -847,6 +972,11 @@ void Fl_Group::update_child(Fl_Widget& widget) const {
 void Fl_Group::draw_child(Fl_Widget& widget) const {
   if (widget.visible() && widget.type() < FL_WINDOW &&
       fl_not_clipped(widget.x(), widget.y(), widget.w(), widget.h())) {
+    Fl_Group *g = cached_group(widget);
+    if (g) { // the cached image is still valid unless the group is damaged
+      g->draw_cached();
+      return;
+    }
     widget.clear_damage(FL_DAMAGE_ALL);
     widget.draw();
     widget.clear_damage();
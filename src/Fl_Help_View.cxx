@@ -22,11 +22,14 @@
 //   Fl_Help_View::add_block()       - Add a text block to the list.
 //   Fl_Help_View::add_link()        - Add a new link to the list.
 //   Fl_Help_View::add_target()      - Add a new target to the list.
+//   Fl_Help_View::append()          - Append text and format it progressively.
 //   Fl_Help_View::compare_targets() - Compare two targets.
 //   Fl_Help_View::do_align()        - Compute the alignment for a line in
 //                                     a block.
 //   Fl_Help_View::draw()            - Draw the Fl_Help_View widget.
+//   Fl_Help_View::end_append()      - Finish appending text.
 //   Fl_Help_View::format()          - Format the help text.
+//   Fl_Help_View::format_scrollbars() - Update the scrollbars after formatting.
 //   Fl_Help_View::format_table()    - Format a table...
 //   Fl_Help_View::free_data()       - Free memory used for the document.
 //   Fl_Help_View::get_align()       - Get an alignment attribute.
@@ -36,7 +39,9 @@
 //   Fl_Help_View::Fl_Help_View()    - Build a Fl_Help_View widget.
 //   Fl_Help_View::~Fl_Help_View()   - Destroy a Fl_Help_View widget.
 //   Fl_Help_View::load()            - Load the specified file.
+//   Fl_Help_View::load_fd()         - Load a file descriptor progressively.
 //   Fl_Help_View::resize()          - Resize the help widget.
+//   Fl_Help_View::scan_images()     - Load or release the images of a document.
 //   Fl_Help_View::topline()         - Set the top line to the named target.
 //   Fl_Help_View::topline()         - Set the top line by number.
 //   Fl_Help_View::value()           - Set the help text directly.
@@ -61,6 +66,11 @@
 #include <ctype.h>
 #include <errno.h>
 #include <math.h>
+#ifdef _WIN32
+#  include <winsock2.h>         // recv()
+#else
+#  include <unistd.h>           // read()
+#endif
 
 #define MAX_COLUMNS     200
 
@@ -656,6 +666,8 @@ Fl_Help_View::draw()
 
   DEBUG_FUNCTION(__LINE__,__FUNCTION__);
 
+  update_format();
+
   // Draw the scrollbar(s) and box first...
   ww = w();
   hh = h();
@@ -1199,6 +1211,8 @@ Fl_Help_View::find(const char *s,               // I - String to find
   // Range check input and value...
   if (!s || !value_) return -1;
 
+  update_format();
+
   if (p < 0 || p >= (int)strlen(value_)) p = 0;
   else if (p > 0) p ++;
 
@@ -1290,9 +1304,22 @@ void Fl_Help_View::format() {
 
   DEBUG_FUNCTION(__LINE__,__FUNCTION__);
 
-  // Reset document width...
+  reformat_ = 0;
+
+  // The layout only depends on the text, fonts, colors and width, so if
+  // none of them changed (e.g. the widget was moved or only its height
+  // changed), just update the scrollbars...
   int scrollsize = scrollbar_size_ ? scrollbar_size_ : Fl::scrollbar_size();
-  hsize_ = w() - scrollsize - Fl::box_dw(b);
+  int layout_w = w() - scrollsize - Fl::box_dw(b);
+  if (value_ && layout_w == format_w_ &&
+      color() == format_bgcolor_ && defcolor_ == format_textcolor_) {
+    format_scrollbars();
+    return;
+  }
+
+  // Reset document width...
+  hsize_ = layout_w;
+  format_w_ = -1;
 
   done = 0;
   while (!done)
@@ -2007,6 +2034,17 @@ void Fl_Help_View::format() {
     qsort(targets_, ntargets_, sizeof(Fl_Help_Target),
           (compare_func_t)compare_targets);
 
+  format_w_         = layout_w;
+  format_bgcolor_   = color();
+  format_textcolor_ = defcolor_;
+
+  format_scrollbars();
+}
+
+
+/** Shows or hides the scrollbars for the current document size and scrolls into range. */
+void Fl_Help_View::format_scrollbars() {
+  Fl_Boxtype b = box() ? box() : FL_DOWN_BOX;
   int dx = Fl::box_dw(b) - Fl::box_dx(b);
   int dy = Fl::box_dh(b) - Fl::box_dy(b);
   int ss = scrollbar_size_ ? scrollbar_size_ : Fl::scrollbar_size();
@@ -2481,71 +2519,19 @@ Fl_Help_View::format_table(int        *table_width,     // O - Total table width
 /** Frees memory used for the document. */
 void
 Fl_Help_View::free_data() {
+  format_w_ = -1;               // layout must be redone
+
+  if (stream_alloc_) {
+    // Only images in the scanned part of an appended document were loaded...
+    stream_stop();
+    ((char *)value_)[stream_scanned_] = '\0';
+  }
+
   // Release all images...
   if (value_) {
-    const char  *ptr,           // Pointer into block
-                *attrs;         // Pointer to start of element attributes
-    HV_Edit_Buffer buf;         // Text buffer
-    char        attr[1024],     // Attribute buffer
-                wattr[1024],    // Width attribute buffer
-                hattr[1024];    // Height attribute buffer
-
     DEBUG_FUNCTION(__LINE__,__FUNCTION__);
 
-    for (ptr = value_; *ptr;)
-    {
-      if (*ptr == '<')
-      {
-        ptr ++;
-
-        if (strncmp(ptr, "!--", 3) == 0)
-        {
-          // Comment...
-          ptr += 3;
-          if ((ptr = strstr(ptr, "-->")) != NULL)
-          {
-            ptr += 3;
-            continue;
-          }
-          else
-            break;
-        }
-
-        buf.clear();
-
-        while (*ptr && *ptr != '>' && !isspace((*ptr)&255))
-          buf.add(*ptr++);
-
-        attrs = ptr;
-        while (*ptr && *ptr != '>')
-          ptr ++;
-
-        if (*ptr == '>')
-          ptr ++;
-
-        if (buf.cmp("IMG"))
-        {
-          Fl_Shared_Image       *img;
-          int           width;
-          int           height;
-
-          get_attr(attrs, "WIDTH", wattr, sizeof(wattr));
-          get_attr(attrs, "HEIGHT", hattr, sizeof(hattr));
-          width  = get_length(wattr);
-          height = get_length(hattr);
-
-          if (get_attr(attrs, "SRC", attr, sizeof(attr))) {
-            // Get and release the image to free it from memory...
-            img = get_image(attr, width, height);
-            if ((void*)img != &broken_image) {
-              img->release();
-            }
-          }
-        }
-      }
-      else
-        ptr ++;
-    }
+    scan_images(value_, 0);
 
     free((void *)value_);
     value_ = 0;
@@ -2577,6 +2563,89 @@ Fl_Help_View::free_data() {
   }
 } // free_data()
 
+/** Loads (\p acquire = 1) or releases (\p acquire = 0) the images of all IMG elements in \p p.
+
+  With \p acquire = -1 no images are loaded or released.
+
+  Returns the start of an unterminated comment at the end of \p p, or the
+  end of \p p. Scanning the rest of the text from there later gives the
+  same IMG elements as scanning the whole text at once.
+*/
+const char *
+Fl_Help_View::scan_images(const char *p, int acquire) {
+  const char  *ptr,           // Pointer into block
+              *start,         // Pointer to start of element
+              *attrs;         // Pointer to start of element attributes
+  HV_Edit_Buffer buf;         // Text buffer
+  char        attr[1024],     // Attribute buffer
+              wattr[1024],    // Width attribute buffer
+              hattr[1024];    // Height attribute buffer
+
+  for (ptr = p; *ptr;)
+  {
+    if (*ptr == '<')
+    {
+      start = ptr ++;
+
+      if (strncmp(ptr, "!--", 3) == 0)
+      {
+        // Comment...
+        ptr += 3;
+        if ((ptr = strstr(ptr, "-->")) != NULL)
+        {
+          ptr += 3;
+          continue;
+        }
+        else
+          return start;
+      }
+
+      buf.clear();
+
+      while (*ptr && *ptr != '>' && !isspace((*ptr)&255))
+        buf.add(*ptr++);
+
+      attrs = ptr;
+      while (*ptr && *ptr != '>')
+        ptr ++;
+
+      if (*ptr == '>')
+        ptr ++;
+
+      if (acquire >= 0 && buf.cmp("IMG"))
+      {
+        Fl_Shared_Image       *img;
+        int           width;
+        int           height;
+
+        get_attr(attrs, "WIDTH", wattr, sizeof(wattr));
+        get_attr(attrs, "HEIGHT", hattr, sizeof(hattr));
+        width  = get_length(wattr);
+        height = get_length(hattr);
+
+        if (get_attr(attrs, "SRC", attr, sizeof(attr))) {
+          if (acquire) {
+            // Load the image, it is released by free_data()...
+            initial_load = 1;
+            get_image(attr, width, height);
+            initial_load = 0;
+          } else {
+            // Get and release the image to free it from memory...
+            img = get_image(attr, width, height);
+            if ((void*)img != &broken_image) {
+              img->release();
+            }
+          }
+        }
+      }
+    }
+    else
+      ptr ++;
+  }
+
+  return ptr;
+}
+
 /** Gets an alignment attribute. */
 int                                     // O - Alignment
 Fl_Help_View::get_align(const char *p,  // I - Pointer to start of attrs
@@ -3122,6 +3191,8 @@ Fl_Help_View::handle(int event) // I - Event to handle
 {
   static Fl_Help_Link *linkp;   // currently clicked link
 
+  update_format();
+
   int xx = Fl::event_x() - x() + leftline_;
   int yy = Fl::event_y() - y() + topline_;
 
@@ -3249,6 +3320,17 @@ Fl_Help_View::Fl_Help_View(int        xx,       // I - Left position
   size_         = 0;
   hsize_        = 0;
   scrollbar_size_ = 0;
+  format_w_     = -1;
+  format_bgcolor_   = 0;
+  format_textcolor_ = 0;
+  reformat_     = 0;
+  stream_len_   = 0;
+  stream_alloc_ = 0;
+  stream_end_   = 0;
+  stream_formatted_ = 0;
+  stream_scanned_ = 0;
+  stream_fd_    = -1;
+  stream_save_  = '\0';
 
   scrollbar_.value(0, hh, 0, 1);
   scrollbar_.step(8.0);
@@ -3422,7 +3504,14 @@ int Fl_Help_View::load(const char *f)
 }
 
 
-/** Resizes the help widget. */
+/**
+  Resizes the help widget.
+
+  The text is formatted again the next time the layout is needed. A change
+  of the width formats the whole document again, since table column widths
+  and the document width affect the layout of all blocks; moving the widget
+  or changing only its height keeps the current layout.
+*/
 
 void
 Fl_Help_View::resize(int xx,    // I - New left position
@@ -3443,7 +3532,11 @@ Fl_Help_View::resize(int xx,    // I - New left position
                      y() + h() - scrollsize - Fl::box_dh(b) + Fl::box_dy(b),
                      w() - scrollsize - Fl::box_dw(b), scrollsize);
 
-  format();
+  // Format when the layout is needed next (usually in draw()), so that
+  // a series of resizes (e.g. while the user drags the window border)
+  // formats the text only once
+  reformat_ = 1;
+  redraw();
 }
 
 
@@ -3457,6 +3550,7 @@ Fl_Help_View::topline(const char *n)    // I - Target name
   Fl_Help_Target key,                   // Target name key
                 *target;                // Pointer to matching target
 
+  update_format();
 
   if (ntargets_ == 0)
     return;
@@ -3484,6 +3578,8 @@ Fl_Help_View::topline(int top)  // I - Top line number
   if (!value_)
     return;
 
+  update_format();
+
   int scrollsize = scrollbar_size_ ? scrollbar_size_ : Fl::scrollbar_size();
   if (size_ < (h() - scrollsize) || top < 0)
     top = 0;
@@ -3513,6 +3609,8 @@ Fl_Help_View::leftline(int left)        // I - Left position
   if (!value_)
     return;
 
+  update_format();
+
   int scrollsize = scrollbar_size_ ? scrollbar_size_ : Fl::scrollbar_size();
   if (hsize_ < (w() - scrollsize) || left < 0)
     left = 0;
@@ -3555,6 +3653,205 @@ Fl_Help_View::value(const char *val)    // I - Text to view
 }
 
 
+/** Appends HTML text to the document and displays it progressively.
+
+  This can be used to show a large or slowly generated document while
+  it is being loaded: the text is formatted and displayed up to the last
+  complete element as it arrives, and the scrollbar grows with the document.
+  To keep the total formatting time proportional to the document size,
+  the text is formatted again only when it has doubled in size since the
+  last time, or when no more text arrived for a short time.
+
+  When all text has been appended, end_append() must be called to
+  format the remainder of the document.
+
+  If the widget is not already appending text, the new text is added
+  to the current value(), if any. Call value(0) before the first append()
+  to start a new document.
+
+  \param[in] text HTML text to add
+  \param[in] len  length of \p text in bytes, or -1 to use strlen(text)
+
+  \see end_append(), load_fd(), appending()
+  \version 1.4.0
+*/
+void
+Fl_Help_View::append(const char *text,  // I - Text to add
+                     int        len)    // I - Length of text
+{
+  if (!text) return;
+  if (len < 0) len = (int) strlen(text);
+
+  char *buf = (char *)value_;
+  if (!stream_alloc_) {
+    // Start appending to the current document...
+    stream_len_       = buf ? (int) strlen(buf) : 0;
+    stream_end_       = stream_len_;
+    stream_formatted_ = buf ? stream_len_ : 0;     // images are already loaded
+    stream_scanned_   = buf ? (int)(scan_images(buf, -1) - buf) : 0;
+    stream_save_      = '\0';
+    stream_alloc_     = stream_len_ + 1;
+    if (!buf) {
+      buf = (char *)calloc(1, 1);
+      value_ = buf;
+      set_changed();
+    }
+  } else if (stream_end_ < stream_len_) {
+    buf[stream_end_] = stream_save_;                // undo the cut
+  }
+
+  // Make room for the new text...
+  if (stream_len_ + len + 1 > stream_alloc_) {
+    int newalloc = stream_alloc_ * 2;
+    if (newalloc < stream_len_ + len + 1) newalloc = stream_len_ + len + 1;
+    if (newalloc < 4096) newalloc = 4096;
+    char *newbuf = (char *)malloc(newalloc);
+    memcpy(newbuf, buf, stream_len_ + 1);
+    // Blocks point into the text, move them to the new buffer...
+    for (int i = 0; i < nblocks_; i ++) {
+      blocks_[i].start = newbuf + (blocks_[i].start - value_);
+      blocks_[i].end   = newbuf + (blocks_[i].end - value_);
+    }
+    free(buf);
+    buf           = newbuf;
+    value_        = buf;
+    stream_alloc_ = newalloc;
+  }
+
+  memcpy(buf + stream_len_, text, len);
+  stream_len_ += len;
+  buf[stream_len_] = '\0';
+
+  // Only show the text up to the last complete element...
+  int end = stream_len_;
+  while (end > stream_end_ && buf[end - 1] != '>') end --;
+  stream_end_  = end;
+  stream_save_ = buf[end];
+  buf[end]     = '\0';
+
+  if (stream_end_ >= 2 * stream_formatted_ + 1024) {
+    Fl::remove_timeout(stream_timeout_cb, this);
+    stream_format();
+  } else if (stream_end_ > stream_formatted_ && !Fl::has_timeout(stream_timeout_cb, this)) {
+    Fl::add_timeout(0.25, stream_timeout_cb, this);
+  }
+}
+
+
+/** Finishes appending text with append() or load_fd(), and formats the complete document.
+
+  \see append()
+  \version 1.4.0
+*/
+void
+Fl_Help_View::end_append()
+{
+  if (!stream_alloc_) return;
+
+  if (stream_fd_ >= 0) Fl::remove_fd(stream_fd_);
+  stream_fd_ = -1;
+  Fl::remove_timeout(stream_timeout_cb, this);
+
+  ((char *)value_)[stream_end_] = stream_save_;
+  stream_end_ = stream_len_;
+  stream_format();
+
+  stream_alloc_ = 0;            // value_ is now a normal document
+}
+
+
+/** Loads and displays a document progressively while it is read from a file descriptor.
+
+  The document is read whenever data is available on \p fd, using Fl::add_fd(),
+  and displayed as described for append(). When the end of the file is
+  reached, end_append() is called and the document is complete.
+  The file descriptor is not closed.
+
+  This is useful for large documents, which are displayed right away
+  instead of after they were read and formatted completely, and for
+  documents generated by another process and read from a pipe.
+  Note that on Windows, like Fl::add_fd(), \p fd must be a socket.
+
+  \param[in] fd file descriptor to read from
+
+  \return 0 on success, -1 on error
+
+  \see append(), appending()
+  \version 1.4.0
+*/
+int
+Fl_Help_View::load_fd(int fd)   // I - File descriptor to read
+{
+  if (fd < 0) return -1;
+
+  clear_selection();
+  free_data();
+  set_changed();
+
+  append("", 0);                // start an empty document
+  stream_fd_ = fd;
+  Fl::add_fd(fd, FL_READ, stream_fd_cb, this);
+
+  topline(0);
+  leftline(0);
+  return 0;
+}
+
+
+// Formats the newly appended complete text...
+void
+Fl_Help_View::stream_format()
+{
+  if (stream_end_ == stream_formatted_ && nblocks_) return;
+
+  // Load the images of the new text, format() only looks them up. Resume
+  // at an unterminated comment, so that the text inside it is skipped like
+  // it is when the images are released...
+  stream_scanned_ = (int)(scan_images(value_ + stream_scanned_, 1) - value_);
+  stream_formatted_ = stream_end_;
+
+  format_w_ = -1;
+  format();
+  redraw();
+}
+
+
+// Stops reading and formatting appended text; the text is left as it is...
+void
+Fl_Help_View::stream_stop()
+{
+  if (stream_fd_ >= 0) Fl::remove_fd(stream_fd_);
+  stream_fd_ = -1;
+  Fl::remove_timeout(stream_timeout_cb, this);
+  stream_alloc_ = 0;
+}
+
+
+// Formats appended text when no more text arrived for a while...
+void
+Fl_Help_View::stream_timeout_cb(void *v)
+{
+  ((Fl_Help_View *)v)->stream_format();
+}
+
+
+// Reads appended text from the file descriptor given to load_fd()...
+void
+Fl_Help_View::stream_fd_cb(int fd, void *v)
+{
+  Fl_Help_View *hv = (Fl_Help_View *)v;
+  char buf[65536];
+#ifdef _WIN32
+  int n = recv((SOCKET)fd, buf, sizeof(buf), 0);
+#else
+  int n = (int) read(fd, buf, sizeof(buf));
+  if (n < 0 && (errno == EINTR || errno == EAGAIN)) return;
+#endif
+  if (n > 0) hv->append(buf, n);
+  else hv->end_append();        // end of file or error
+}
+
+
 /*  Returns the Unicode Code Point associated with a quoted character
     (aka "HTML Entity").
 
@@ -25,6 +25,7 @@
 #include "flstring.h"
 #include <stdlib.h>
 #include <ctype.h>
+#include <limits.h>
 
 #define MAXBUF 1024
 static int l_secret;
@@ -159,29 +160,219 @@ double Fl_Input_::expandpos(
   \param [in] p start of update range
 */
 void Fl_Input_::minimal_update(int p) {
+  minimal_update(p, INT_MAX);
+}
+
+/** \internal
+  Marks a range of characters for update.
+
+  This call marks a text range for update. At least all characters
+  from \p p to \p q will be redrawn in the next update cycle.
+  The lines that start after \p q are not redrawn, so \p q must
+  be \c INT_MAX if the following lines moved.
+
+  \param [in] p start of update range
+  \param [in] q end of update range
+*/
+void Fl_Input_::minimal_update(int p, int q) {
+  if (q < p) {int t = p; p = q; q = t;}
   if (damage() & FL_DAMAGE_ALL) return; // don't waste time if it won't be done
   if (damage() & FL_DAMAGE_EXPOSE) {
     if (p < mu_p) mu_p = p;
+    if (q > mu_q) mu_q = q;
   } else {
     mu_p = p;
+    mu_q = q;
   }
 
   damage(FL_DAMAGE_EXPOSE);
   erase_cursor_only = 0;
 }
 
+////////////////////////////////////////////////////////////////
+
+/*
+  The offsets of the starts of the displayed lines are cached in lines_,
+  so that drawing and mouse handling can go straight to the visible lines
+  instead of expanding all the text above them. The cache is filled
+  lazily from the top of the text by layout_lines(). When the text
+  changes, update_lines() lays out the lines again from the changed line
+  until a line starts at the same place as before, and moves the cached
+  lines after it. Wrapped lines depend on the font and the width of the
+  widget, so the cache is cleared when these change.
+*/
+
+// Returns the index of the last of the n line starts that is <= pos
+static int find_line(const int *lines, int n, int pos) {
+  int lo = 0, hi = n-1;
+  while (lo < hi) {
+    int mid = (lo+hi+1)/2;
+    if (lines[mid] <= pos) lo = mid; else hi = mid-1;
+  }
+  return lo;
+}
+
 /** \internal
-  Marks a range of characters for update.
+  Adds lines to the cache of line starts.
 
-  This call marks a text range for update. At least all characters
-  from \p p to \p q will be redrawn in the next update cycle.
+  Lines are added until the cache holds at least \p n lines and a line
+  that starts after the offset \p pos, or until the end of the text.
+  setfont() must have been called.
 
-  \param [in] p start of update range
-  \param [in] q end of update range
+  \param [in] n number of lines needed
+  \param [in] pos offset in the text that must be inside the cache, or -1
+  \return number of cached lines
 */
-void Fl_Input_::minimal_update(int p, int q) {
-  if (q < p) p = q;
-  minimal_update(p);
+int Fl_Input_::layout_lines(int n, int pos) {
+  int ww = wrap() ? w() - Fl::box_dw(box()) - 2 : 0;
+  float s = fl_graphics_driver->scale();
+  if (lines_type_ != type() ||
+      (wrap() && (lines_w_ != ww || lines_font_ != textfont() ||
+              lines_size_ != textsize() || lines_scale_ != s))) {
+    lines_type_ = type();
+    lines_w_ = ww;
+    lines_font_ = textfont();
+    lines_size_ = textsize();
+    lines_scale_ = s;
+    nlines_ = 0;
+  }
+  if (!nlines_) {
+    if (!alines_) {
+      alines_ = 64;
+      lines_ = (int*)malloc(alines_ * sizeof(int));
+    }
+    lines_[0] = 0;
+    nlines_ = 1;
+    lines_done_ = 0;
+  }
+  char buf[MAXBUF];
+  while (!lines_done_ && (nlines_ < n || lines_[nlines_-1] <= pos)) {
+    const char *e = expand(value()+lines_[nlines_-1], buf);
+    if (e >= value_+size_) {lines_done_ = 1; break;}
+    if (*e == '\n' || *e == ' ') e++;
+    if (nlines_ >= alines_) {
+      alines_ *= 2;
+      lines_ = (int*)realloc(lines_, alines_ * sizeof(int));
+    }
+    lines_[nlines_++] = (int) (e-value());
+  }
+  return nlines_;
+}
+
+/** \internal
+  Returns the index of the displayed line that holds a text offset.
+
+  If the offset is at the end of a line that is followed by a line
+  starting at the same offset, the following line is returned.
+  setfont() must have been called.
+
+  \param [in] pos offset in the text
+  \return line index, counted from 0
+*/
+int Fl_Input_::line_index(int pos) {
+  layout_lines(0, pos);
+  return find_line(lines_, nlines_, pos);
+}
+
+/** \internal
+  Updates the cache of line starts after a part of the text was replaced.
+
+  The text from \p b to \p e was replaced by \p n bytes. The lines are
+  laid out again from the line before the change until a line starts at
+  the same place as before, and the cached lines after it are moved.
+
+  \param [in] b start of the replaced text
+  \param [in] e end of the replaced text, before the change
+  \param [in] n length of the new text
+  \param [out] start start of the first line that may have changed, or -1
+      if the lines were not laid out
+  \return offset in the new text up to which lines changed, or \c INT_MAX
+      if the following lines moved up or down
+*/
+int Fl_Input_::update_lines(int b, int e, int n, int *start) {
+  *start = -1;
+  if (!nlines_) return INT_MAX; // the lines are laid out when they are drawn
+  int delta = n - (e-b);
+  int k = find_line(lines_, nlines_, b);
+  // the first word of the line may now fit at the end of the line before:
+  if (k > 0 && value_[lines_[k]-1] != '\n') k--;
+  if (k+1 >= nlines_ && !lines_done_) { // change is after the cached lines
+    nlines_ = k+1;
+    return INT_MAX;
+  }
+
+  setfont();
+  int old = nlines_;
+  if (layout_lines(0, -1) != old) return INT_MAX; // layout parameters changed
+
+  *start = lines_[k];
+  int tmp[64], *nl = tmp, nn = 0, na = 64; // starts of the new lines
+  int i = k+1;          // next old line to compare
+  int sync = 0;         // set if a new line starts where an old one did
+  int done = 1;         // set if the new lines reach the end of the text
+  int s = lines_[k];
+  char buf[MAXBUF];
+  for (;;) {
+    const char *p = expand(value()+s, buf);
+    if (p >= value_+size_) break;
+    if (*p == '\n' || *p == ' ') p++;
+    s = (int) (p-value());
+    if (s > b+n) {
+      while (i < old && lines_[i]+delta < s) i++;
+      if (i < old && lines_[i] >= e && lines_[i]+delta == s) {sync = 1; break;}
+      if (i >= old && !lines_done_) {done = 0; break;}
+    }
+    if (nn >= na) {
+      int *t = (int*)malloc(2*na*sizeof(int));
+      memcpy(t, nl, nn*sizeof(int));
+      if (nl != tmp) free(nl);
+      nl = t;
+      na *= 2;
+    }
+    nl[nn++] = s;
+  }
+
+  // replace the old lines k+1 to i-1 by the new ones:
+  int tail = sync ? old-i : 0;
+  int need = k+1+nn+tail+(sync || done ? 0 : 1);
+  if (need > alines_) {
+    while (alines_ < need) alines_ *= 2;
+    lines_ = (int*)realloc(lines_, alines_ * sizeof(int));
+  }
+  if (tail) {
+    memmove(lines_+k+1+nn, lines_+i, tail*sizeof(int));
+    for (int j = k+1+nn; j < k+1+nn+tail; j++) lines_[j] += delta;
+  }
+  memcpy(lines_+k+1, nl, nn*sizeof(int));
+  nlines_ = k+1+nn+tail;
+  if (!sync && !done) lines_[nlines_++] = s;
+  if (!sync) lines_done_ = (uchar)done;
+  if (nl != tmp) free(nl);
+
+  if (sync && nn == i-k-1) return s-1; // the following lines did not move
+  return INT_MAX;
+}
+
+/** \internal
+  Removes the lines after a text offset from the cache of line starts.
+
+  The line that holds the offset and the line before it are removed
+  as well, because the text there may now be broken in other lines.
+
+  \param [in] p offset of the first changed byte in the text
+  \return start of the first line that may have changed
+*/
+int Fl_Input_::invalidate_lines(int p) {
+  if (nlines_ <= 1) { // start of the paragraph
+    nlines_ = 0;
+    while (p > 0 && value_[p-1] != '\n') p--;
+    return p;
+  }
+  int n = find_line(lines_, nlines_, p);
+  if (n > 0 && value_[lines_[n]-1] != '\n') n--;
+  nlines_ = n+1;
+  lines_done_ = 0;
+  return lines_[n];
 }
 
 ////////////////////////////////////////////////////////////////
@@ -232,38 +423,31 @@ void Fl_Input_::drawtext(int X, int Y, int W, int H) {
   const char *p, *e;
   char buf[MAXBUF];
 
-  // count how many lines and put the last one into the buffer:
-  // And figure out where the cursor is:
+  // find the line of the cursor and the horizontal scrolling:
   int height = fl_height();
   int threshold = height/2;
-  int lines;
   int curx, cury;
-  for (p=value(), curx=cury=lines=0; ;) {
-    e = expand(p, buf);
-    if (position() >= p-value() && position() <= e-value()) {
-      curx = int(expandpos(p, value()+position(), buf, 0)+.5);
-      if (Fl::focus()==this && !was_up_down) up_down_pos = curx;
-      cury = lines*height;
-      int newscroll = xscroll_;
-      if (curx > newscroll+W-threshold) {
-        // figure out scrolling so there is space after the cursor:
-        newscroll = curx+threshold-W;
-        // figure out the furthest left we ever want to scroll:
-        int ex = int(expandpos(p, e, buf, 0))+4-W;
-        // use minimum of both amounts:
-        if (ex < newscroll) newscroll = ex;
-      } else if (curx < newscroll+threshold) {
-        newscroll = curx-threshold;
-      }
-      if (newscroll < 0) newscroll = 0;
-      if (newscroll != xscroll_) {
-        xscroll_ = newscroll;
-        mu_p = 0; erase_cursor_only = 0;
-      }
-    }
-    lines++;
-    if (e >= value_+size_) break;
-    p = e+1;
+  int cl = line_index(position());
+  p = value()+lines_[cl];
+  e = expand(p, buf);
+  curx = int(expandpos(p, value()+position(), buf, 0)+.5);
+  if (Fl::focus()==this && !was_up_down) up_down_pos = curx;
+  cury = cl*height;
+  int newscroll = xscroll_;
+  if (curx > newscroll+W-threshold) {
+    // figure out scrolling so there is space after the cursor:
+    newscroll = curx+threshold-W;
+    // figure out the furthest left we ever want to scroll:
+    int ex = int(expandpos(p, e, buf, 0))+4-W;
+    // use minimum of both amounts:
+    if (ex < newscroll) newscroll = ex;
+  } else if (curx < newscroll+threshold) {
+    newscroll = curx-threshold;
+  }
+  if (newscroll < 0) newscroll = 0;
+  if (newscroll != xscroll_) {
+    xscroll_ = newscroll;
+    mu_p = 0; mu_q = INT_MAX; erase_cursor_only = 0;
   }
 
   // adjust the scrolling:
@@ -272,7 +456,7 @@ void Fl_Input_::drawtext(int X, int Y, int W, int H) {
     if (cury < newy) newy = cury;
     if (cury > newy+H-height) newy = cury-H+height;
     if (newy < -1) newy = -1;
-    if (newy != yscroll_) {yscroll_ = newy; mu_p = 0; erase_cursor_only = 0;}
+    if (newy != yscroll_) {yscroll_ = newy; mu_p = 0; mu_q = INT_MAX; erase_cursor_only = 0;}
   } else {
     yscroll_ = -(H-height)/2;
   }
@@ -280,21 +464,24 @@ void Fl_Input_::drawtext(int X, int Y, int W, int H) {
   fl_push_clip(X, Y, W, H);
   Fl_Color tc = active_r() ? textcolor() : fl_inactive(textcolor());
 
-  p = value();
+  // start at the first visible line:
+  int line = yscroll_ > 0 ? yscroll_/height : 0;
+  if (layout_lines(line+1, -1) <= line) line = nlines_-1;
+  p = value()+lines_[line];
   // visit each line and draw it:
   int desc = height-fl_descent();
   float xpos = (float)(X - xscroll_ + 1);
-  int ypos = -yscroll_;
+  int ypos = line*height - yscroll_;
   for (; ypos < H;) {
 
-    // re-expand line unless it is the last one calculated above:
-    if (lines>1) e = expand(p, buf);
+    e = expand(p, buf);
 
     if (ypos <= -height) goto CONTINUE; // clipped off top
 
     if (do_mu) {        // for minimal update:
       const char* pp = value()+mu_p; // pointer to where minimal update starts
       if (e < pp) goto CONTINUE2; // this line is before the changes
+      if ((int) (p-value()) > mu_q) goto CONTINUE2; // this line is after them
       if (readonly()) erase_cursor_only = 0; // this isn't the most efficient way
       if (erase_cursor_only && p > pp) goto CONTINUE2; // this line is after
       // calculate area to erase:
@@ -388,7 +575,7 @@ void Fl_Input_::drawtext(int X, int Y, int W, int H) {
 
   // for minimal update, erase all lines below last one if necessary:
   if (input_type()==FL_MULTILINE_INPUT && do_mu && ypos<H
-      && (!erase_cursor_only || p <= value()+mu_p)) {
+      && (!erase_cursor_only || p <= value()+mu_p) && (int) (p-value()) <= mu_q) {
     if (ypos < 0) ypos = 0;
     fl_push_clip(X, Y+ypos, W, H-ypos);
     draw_box(box(), X-Fl::box_dx(box()), Y-Fl::box_dy(box()),
@@ -537,12 +724,10 @@ void Fl_Input_::handle_mouse(int X, int Y, int /*W*/, int /*H*/, int drag) {
     (Fl::event_y()-Y+yscroll_)/fl_height() : 0;
 
   int newpos = 0;
-  for (p=value();; ) {
-    e = expand(p, buf);
-    theline--; if (theline < 0) break;
-    if (e >= value_+size_) break;
-    p = e+1;
-  }
+  if (theline < 0) theline = 0;
+  if (layout_lines(theline+1, -1) <= theline) theline = nlines_-1;
+  p = value()+lines_[theline];
+  e = expand(p, buf);
   const char *l, *r, *t; double f0 = Fl::event_x()-X+xscroll_;
   for (l = p, r = e; l<r; ) {
     double f;
@@ -741,6 +926,24 @@ static void undobuffersize(int n) {
   }
 }
 
+// Returns the offset of text offset i after the text from b to e was
+// replaced by n bytes
+static int moved(int i, int b, int e, int n) {
+  if (i <= b) return i;
+  if (i < e) return b+n;
+  return i+n-(e-b);
+}
+
+// Returns the end of the update range q, extended to the old cursor
+// and mark m and p, after the text from b to e was replaced by n bytes
+static int moved_end(int q, int m, int p, int b, int e, int n) {
+  m = moved(m, b, e, n);
+  p = moved(p, b, e, n);
+  if (m > q) q = m;
+  if (p > q) q = p;
+  return q;
+}
+
 /**
  Append text at the end.
 
@@ -830,30 +1033,24 @@ int Fl_Input_::replace(int b, int e, const char* text, int ilen) {
   if (e<=b && !ilen) return 0; // don't clobber undo for a null operation
 
   // we must count UTF-8 *characters* to determine whether we can insert
-  // the full text or only a part of it (and how much this would be)
-
-  int nchars = 0;       // characters in value() - deleted + inserted
-  const char *p = value_;
-  while (p < (char *)(value_+size_)) {
-    if (p == (char *)(value_+b)) { // skip removed part
-      p = (char *)(value_+e);
-      if (p >= (char *)(value_+size_)) break;
+  // the full text or only a part of it (and how much this would be),
+  // unless the number of bytes shows that it fits
+
+  if (size_-(e-b)+ilen > maximum_size()) {
+    // characters in value() - deleted + inserted
+    int nchars = fl_utf_nb_char((const uchar*)value_, b) +
+                 fl_utf_nb_char((const uchar*)value_+e, size_-e);
+    int nlen = 0;       // length (in bytes) to be inserted
+    const char *p = text;
+    while (p < (char *)(text+ilen) && nchars < maximum_size()) {
+      int ulen = fl_utf8len(*p);
+      if (ulen < 1) ulen = 1; // invalid UTF-8 character: count as 1
+      nchars++;
+      p += ulen;
+      nlen += ulen;
     }
-    int ulen = fl_utf8len(*p);
-    if (ulen < 1) ulen = 1; // invalid UTF-8 character: count as 1
-    nchars++;
-    p += ulen;
+    ilen = nlen;
   }
-  int nlen = 0;         // length (in bytes) to be inserted
-  p = text;
-  while (p < (char *)(text+ilen) && nchars < maximum_size()) {
-    int ulen = fl_utf8len(*p);
-    if (ulen < 1) ulen = 1; // invalid UTF-8 character: count as 1
-    nchars++;
-    p += ulen;
-    nlen += ulen;
-  }
-  ilen = nlen;
 
   put_in_buffer(size_+ilen);
 
@@ -875,8 +1072,6 @@ int Fl_Input_::replace(int b, int e, const char* text, int ilen) {
       undocut = e-b;
       undoinsert = 0;
     }
-    memmove(buffer+b, buffer+e, size_-e+1);
-    size_ -= e-b;
     undowidget = this;
     undoat = b;
     if (input_type() == FL_SECRET_INPUT) yankcut = 0; else yankcut = undocut;
@@ -889,10 +1084,13 @@ int Fl_Input_::replace(int b, int e, const char* text, int ilen) {
       undocut = 0;
       undoinsert = ilen;
     }
-    memmove(buffer+b+ilen, buffer+b, size_-b+1);
-    memcpy(buffer+b, text, ilen);
-    size_ += ilen;
   }
+  // move the tail of the text only once for both the deletion and insertion:
+  if (ilen != e-b) memmove(buffer+b+ilen, buffer+e, size_-e+1);
+  if (ilen) memcpy(buffer+b, text, ilen);
+  size_ += ilen-(e-b);
+  int ls;
+  int q = update_lines(b, e, ilen, &ls);
   undowidget = this;
   om = mark_;
   op = position_;
@@ -902,8 +1100,11 @@ int Fl_Input_::replace(int b, int e, const char* text, int ilen) {
   // wrap to the next line, so we must indicate that the changes may start
   // right after the whitespace before the current word.  This will
   // result in sub-optimal update when such wrapping does not happen
-  // but it is too hard to figure out for now...
-  if (wrap()) {
+  // but it is too hard to figure out for now, unless the lines were laid
+  // out again...
+  if (wrap() && ls >= 0) {
+    if (ls < b) b = ls;
+  } else if (wrap()) {
     // if there is a space in the pasted text, the whole line may have rewrapped
     int i;
     for (i=0; i<ilen; i++)
@@ -917,8 +1118,14 @@ int Fl_Input_::replace(int b, int e, const char* text, int ilen) {
   // make sure we redraw the old selection or cursor:
   if (om < b) b = om;
   if (op < b) b = op;
+  if (q != INT_MAX) {
+    int ob = undoat-ilen;
+    q = moved_end(q, om, op, ob, e, ilen);
+    if ((damage() & FL_DAMAGE_EXPOSE) && mu_q != INT_MAX)
+      mu_q = moved(mu_q, ob, e, ilen);
+  }
 
-  minimal_update(b);
+  minimal_update(b, q);
 
   mark_ = position_ = undoat;
 
@@ -959,6 +1166,15 @@ int Fl_Input_::undo() {
     size_ -= xlen;
   }
 
+  int ls;
+  int q = update_lines(b1, b1+xlen, ilen, &ls);
+  if (q != INT_MAX) {
+    q = moved_end(q, mark_, position_, b1, b1+xlen, ilen);
+    if ((damage() & FL_DAMAGE_EXPOSE) && mu_q != INT_MAX)
+      mu_q = moved(mu_q, b1, b1+xlen, ilen);
+  }
+  int ob = mark_ < position_ ? mark_ : position_;
+
   undocut = xlen;
   if (xlen) yankcut = xlen;
   undoinsert = ilen;
@@ -966,9 +1182,12 @@ int Fl_Input_::undo() {
   mark_ = b /* -ilen */;
   position_ = b;
 
-  if (wrap())
+  if (wrap() && ls >= 0) {
+    if (ls < b1) b1 = ls;
+  } else if (wrap())
     while (b1 > 0 && index(b1)!='\n') b1--;
-  minimal_update(b1);
+  if (ob < b1) b1 = ob;
+  minimal_update(b1, q);
   set_changed();
   if (when()&FL_WHEN_CHANGED) do_callback();
   return 1;
@@ -1147,6 +1366,15 @@ Fl_Input_::Fl_Input_(int X, int Y, int W, int H, const char* l)
   buffer  = 0;
   value_ = "";
   xscroll_ = yscroll_ = 0;
+  mu_p = 0;
+  mu_q = INT_MAX;
+  lines_ = 0;
+  nlines_ = alines_ = 0;
+  lines_done_ = lines_type_ = 0;
+  lines_font_ = 0;
+  lines_size_ = 0;
+  lines_w_ = 0;
+  lines_scale_ = 0;
   maximum_size_ = 32767;
   shortcut_ = 0;
   set_flag(SHORTCUT_LABEL);
@@ -1220,6 +1448,7 @@ int Fl_Input_::static_value(const char* str, int len) {
   if (len) { // non-empty new value:
     if (xscroll_ || yscroll_) {
       xscroll_ = yscroll_ = 0;
+      invalidate_lines(0);
       minimal_update(0);
     } else {
       int i = 0;
@@ -1228,7 +1457,10 @@ int Fl_Input_::static_value(const char* str, int len) {
         for (; i<size_ && i<len && str[i]==value_[i]; i++) {/*empty*/}
         if (i==size_ && i==len) return 0;
       }
+      int ls = invalidate_lines(i);
+      if (wrap() && ls < i) i = ls; // the line before may have been rewrapped
       minimal_update(i);
+      minimal_update(position_, mark_); // erase the old cursor or selection
     }
     value_ = str;
     size_ = len;
@@ -1237,6 +1469,7 @@ int Fl_Input_::static_value(const char* str, int len) {
     size_ = 0;
     value_ = "";
     xscroll_ = yscroll_ = 0;
+    invalidate_lines(0);
     minimal_update(0);
   }
   position(readonly() ? 0 : size());
@@ -1318,6 +1551,7 @@ void Fl_Input_::resize(int X, int Y, int W, int H) {
 Fl_Input_::~Fl_Input_() {
   if (undowidget == this) undowidget = 0;
   if (bufsize) free((void*)buffer);
+  free(lines_);
 }
 
 /** \internal
@@ -149,7 +149,8 @@ unsigned int Fl_Preferences::file_access()
  generating <tt>\<null\>/Library/Preferences/\$(vendor)/\$(application).prefs</tt>, which would silently fail to
  create a preferences file.
 
- \param[in] root can be \c USER or \c SYSTEM for user specific or system wide preferences
+ \param[in] root can be \c USER or \c SYSTEM for user specific or system wide preferences,
+            optionally OR'd with \c JOURNAL, see flush()
  \param[in] vendor unique text describing the company or author of this file, must be a valid filepath segment
  \param[in] application unique text describing the application, must be a valid filepath segment
 
@@ -187,6 +188,23 @@ Fl_Preferences::Fl_Preferences( const char *path, const char *vendor, const char
   node->setRoot(rootNode);
 }
 
+/**
+   \brief Use this constructor to create or read a preferences file at an
+   arbitrary position in the file system with additional flags.
+
+   \param[in] path path to the directory that contains the preferences file
+   \param[in] vendor unique text describing the company or author of this file, must be a valid filepath segment
+   \param[in] application unique text describing the application, must be a valid filepath segment
+   \param[in] flags \c JOURNAL or 0, see flush()
+   \see Fl_Preferences( const char *path, const char *vendor, const char *application )
+   \version 1.4.0
+ */
+Fl_Preferences::Fl_Preferences( const char *path, const char *vendor, const char *application, Root flags ) {
+  node = new Node( "." );
+  rootNode = new RootNode( this, path, vendor, application, flags );
+  node->setRoot(rootNode);
+}
+
 /**
    \brief Generate or read a new group of entries within another group.
 
@@ -839,6 +857,15 @@ char Fl_Preferences::getUserdataPath( char *path, int pathlen ) {
  Writes all preferences to disk. This function works only with
  the base preferences group. This function is rarely used as
  deleting the base preferences flushes automatically.
+
+ Normally the whole file is written again. If the preferences were
+ created with the \c JOURNAL flag, only the groups and entries that
+ were added or changed since the file was read or written are appended
+ to the file. This is much faster for large files. Reading the file
+ applies these changes in order, and older versions of FLTK read the
+ same data. The file is written entirely if entries or groups were
+ deleted, or when the appended changes make the file about twice as
+ large as its last complete version.
  */
 void Fl_Preferences::flush() {
   if ( rootNode && node->dirty() )
@@ -902,6 +929,17 @@ Fl_Preferences::Name::~Name() {
 
 int Fl_Preferences::Node::lastEntrySet = -1;
 
+// groups with at least this many entries use a hash table to find entries
+#define HASH_MIN_ENTRIES 16
+
+// FNV-1a hash of an entry name
+static unsigned hash( const char *name ) {
+  unsigned h = 2166136261U;
+  for ( ; *name; name++ )
+    h = ( h ^ (unsigned char)*name ) * 16777619U;
+  return h;
+}
+
 // create the root node
 // - construct the name of the file that will hold our preferences
 Fl_Preferences::RootNode::RootNode( Fl_Preferences *prefs, Root root, const char *vendor, const char *application )
@@ -909,7 +947,9 @@ Fl_Preferences::RootNode::RootNode( Fl_Preferences *prefs, Root root, const char
   filename_(0L),
   vendor_(0L),
   application_(0L),
-  root_(root)
+  root_(root),
+  base_size_(0),
+  journal_ok_(0)
 {
   char *filename = Fl::system_driver()->preference_rootnode(prefs, root, vendor, application);
   filename_    = filename ? fl_strdup(filename) : 0L;
@@ -920,12 +960,14 @@ Fl_Preferences::RootNode::RootNode( Fl_Preferences *prefs, Root root, const char
 
 // create the root node
 // - construct the name of the file that will hold our preferences
-Fl_Preferences::RootNode::RootNode( Fl_Preferences *prefs, const char *path, const char *vendor, const char *application )
+Fl_Preferences::RootNode::RootNode( Fl_Preferences *prefs, const char *path, const char *vendor, const char *application, Root flags )
 : prefs_(prefs),
   filename_(0L),
   vendor_(0L),
   application_(0L),
-  root_(Fl_Preferences::USER)
+  root_((Root)(Fl_Preferences::USER | (flags & Fl_Preferences::JOURNAL))),
+  base_size_(0),
+  journal_ok_(0)
 {
 
   if (!vendor)
@@ -950,7 +992,9 @@ Fl_Preferences::RootNode::RootNode( Fl_Preferences *prefs )
   filename_(0L),
   vendor_(0L),
   application_(0L),
-  root_(Fl_Preferences::USER)
+  root_(Fl_Preferences::USER),
+  base_size_(0),
+  journal_ok_(0)
 {
 }
 
@@ -990,35 +1034,41 @@ int Fl_Preferences::RootNode::read() {
     prefs_->node->clearDirtyFlags();
     return -1;
   }
-  char buf[1024];
   FILE *f = fl_fopen( filename_, "rb" );
   if ( !f )
     return -1;
-  if (fgets( buf, 1024, f )==0) { /* ignore */ }
-  if (fgets( buf, 1024, f )==0) { /* ignore */ }
-  if (fgets( buf, 1024, f )==0) { /* ignore */ }
+  // read the whole file at once and split it into lines in place
+  long size = 0;
+  if ( fseek( f, 0, SEEK_END ) == 0 ) size = ftell( f );
+  if ( size < 0 || fseek( f, 0, SEEK_SET ) != 0 ) size = 0;
+  char *buf = (char*)malloc( size+1 );
+  size = (long)fread( buf, 1, size, f );
+  buf[size] = 0;
+  fclose( f );
   Node *nd = prefs_->node;
-  for (;;) {
-    if ( !fgets( buf, 1024, f ) ) break;        // EOF or Error
-    if ( buf[0]=='[' ) {                        // read a new group
-      size_t end = strcspn( buf+1, "]\n\r" );
-      buf[ end+1 ] = 0;
-      nd = prefs_->node->find( buf+1 );
-    } else if ( buf[0]=='+' ) {                 // value of previous name/value pair spans multiple lines
-      size_t end = strcspn( buf+1, "\n\r" );
-      if ( end != 0 ) {                         // if entry is not empty
-        buf[ end+1 ] = 0;
-        nd->add( buf+1 );
-      }
-    } else {                                     // read a name/value pair
-      size_t end = strcspn( buf, "\n\r" );
-      if ( end != 0 ) {                         // if entry is not empty
-        buf[ end ] = 0;
-        nd->set( buf );
-      }
+  char *line = buf, *end = buf + size;
+  for (int ln = 0; line < end; ln++) {
+    char *eol = (char*)memchr( line, '\n', end-line );
+    if ( !eol ) eol = end;
+    *eol = 0;
+    if ( eol > line && eol[-1] == '\r' ) eol[-1] = 0;
+    if ( ln < 3 ) {                             // skip the file header
+    } else if ( line[0]=='[' ) {                // read a new group
+      size_t len = strcspn( line+1, "]" );
+      line[ len+1 ] = 0;
+      if ( strcmp( line+1, nd->path() ) != 0 )
+        nd = prefs_->node->find( line+1 );
+    } else if ( line[0]=='+' ) {                // value of previous name/value pair spans multiple lines
+      if ( line[1] )                            // if entry is not empty
+        nd->add( line+1 );
+    } else if ( line[0] ) {                     // read a name/value pair
+      nd->set( line );
     }
+    line = eol + 1;
   }
-  fclose( f );
+  free( buf );
+  base_size_ = size;
+  journal_ok_ = 1;
   prefs_->node->clearDirtyFlags();
   return 0;
 }
@@ -1034,6 +1084,20 @@ int Fl_Preferences::RootNode::write() {
   if ( ((root_&Fl_Preferences::ROOT_MASK)==Fl_Preferences::SYSTEM) && !(fileAccess_ & Fl_Preferences::SYSTEM_WRITE_OK) )
     return -1;
   fl_make_path_for_file(filename_);
+  if ( (root_ & Fl_Preferences::JOURNAL) && journal_ok_ && !prefs_->node->needsRewrite() ) {
+    // append the changes, unless the file has grown too much
+    FILE *f = fl_fopen( filename_, "ab" );
+    if ( f ) {
+      long size = ( fseek( f, 0, SEEK_END ) == 0 ) ? ftell( f ) : -1;
+      if ( size >= 0 && size < 2*base_size_ + 4096 ) {
+        prefs_->node->writeJournal( f );
+        fclose( f );
+        prefs_->node->clearDirtyFlags();
+        return 0;
+      }
+      fclose( f );
+    }
+  }
   FILE *f = fl_fopen( filename_, "wb" );
   if ( !f )
     return -1;
@@ -1041,7 +1105,10 @@ int Fl_Preferences::RootNode::write() {
   fprintf( f, "; vendor: %s\n", vendor_ );
   fprintf( f, "; application: %s\n", application_ );
   prefs_->node->write( f );
+  base_size_ = ftell( f );
   fclose( f );
+  prefs_->node->clearDirtyFlags();
+  journal_ok_ = 1;
   if (Fl::system_driver()->preferences_need_protection_check()) {
     // unix: make sure that system prefs are user-readable
     if (strncmp(filename_, "/etc/fltk/", 10) == 0) {
@@ -1120,11 +1187,15 @@ Fl_Preferences::Node::Node( const char *path ) {
   dirty_ = 0;
   top_ = 0;
   indexed_ = 0;
+  rewrite_ = 0;
   index_ = 0;
   nIndex_ = NIndex_ = 0;
+  hash_ = 0;
+  NHash_ = 0;
 }
 
 void Fl_Preferences::Node::deleteAllChildren() {
+  if ( child_ ) rewrite_ = 1;
   Node *nx;
   for ( Node *nd = child_; nd; nd = nx ) {
     nx = nd->next_;
@@ -1151,7 +1222,9 @@ void Fl_Preferences::Node::deleteAllEntries() {
     entry_ = 0L;
     nEntry_ = 0;
     NEntry_ = 0;
+    rewrite_ = 1;
   }
+  deleteHash();
   dirty_ = 1;
 }
 
@@ -1160,6 +1233,7 @@ Fl_Preferences::Node::~Node() {
   deleteAllChildren();
   deleteAllEntries();
   deleteIndex();
+  deleteHash();
   if ( path_ ) {
     free( path_ );
     path_ = 0L;
@@ -1176,11 +1250,23 @@ char Fl_Preferences::Node::dirty() {
   return 0;
 }
 
+// recursively check if entries or groups were removed since the file was written
+char Fl_Preferences::Node::needsRewrite() {
+  for ( Node *nd = this; nd; nd = nd->next_ ) {
+    if ( nd->rewrite_ ) return 1;
+    if ( nd->child_ && nd->child_->needsRewrite() ) return 1;
+  }
+  return 0;
+}
+
 // recursively clear all dirty flags
 void Fl_Preferences::Node::clearDirtyFlags() {
   Fl_Preferences::Node *nd = this;
   while (nd) {
     nd->dirty_ = 0;
+    nd->rewrite_ = 0;
+    for ( int i = 0; i < nd->nEntry_; i++ )
+      nd->entry_[i].dirty = 0;
     if ( nd->child_ ) nd->child_->clearDirtyFlags();
     nd = nd->next_;
   }
@@ -1192,31 +1278,49 @@ void Fl_Preferences::Node::clearDirtyFlags() {
 int Fl_Preferences::Node::write( FILE *f ) {
   if ( next_ ) next_->write( f );
   fprintf( f, "\n[%s]\n\n", path_ );
-  for ( int i = 0; i < nEntry_; i++ ) {
-    char *src = entry_[i].value;
-    if ( src ) {                // hack it into smaller pieces if needed
-      fprintf( f, "%s:", entry_[i].name );
-      size_t cnt, written = 0;
-      for ( cnt = 0; cnt < 60; cnt++ )
+  for ( int i = 0; i < nEntry_; i++ )
+    writeEntry( f, entry_[i] );
+  if ( child_ ) child_->write( f );
+  dirty_ = 0;
+  return 0;
+}
+
+// write the groups and entries that changed since the file was last written
+// (recursively from the last neighbor back to this)
+int Fl_Preferences::Node::writeJournal( FILE *f ) {
+  if ( next_ ) next_->writeJournal( f );
+  if ( dirty_ ) {
+    fprintf( f, "\n[%s]\n\n", path_ );
+    for ( int i = 0; i < nEntry_; i++ )
+      if ( entry_[i].dirty )
+        writeEntry( f, entry_[i] );
+  }
+  if ( child_ ) child_->writeJournal( f );
+  return 0;
+}
+
+// write a single entry, splitting long values into multiple lines
+void Fl_Preferences::Node::writeEntry( FILE *f, Entry &e ) {
+  char *src = e.value;
+  if ( src ) {                // hack it into smaller pieces if needed
+    fprintf( f, "%s:", e.name );
+    size_t cnt, written = 0;
+    for ( cnt = 0; cnt < 60; cnt++ )
+      if ( src[cnt]==0 ) break;
+    written += fwrite( src, cnt, 1, f );
+    fprintf( f, "\n" );
+    src += cnt;
+    for (;*src;) {
+      for ( cnt = 0; cnt < 80; cnt++ )
         if ( src[cnt]==0 ) break;
+      fputc( '+', f );
       written += fwrite( src, cnt, 1, f );
-      fprintf( f, "\n" );
+      fputc( '\n', f );
       src += cnt;
-      for (;*src;) {
-        for ( cnt = 0; cnt < 80; cnt++ )
-          if ( src[cnt]==0 ) break;
-        fputc( '+', f );
-        written += fwrite( src, cnt, 1, f );
-        fputc( '\n', f );
-        src += cnt;
-      }
     }
-    else
-      fprintf( f, "%s\n", entry_[i].name );
   }
-  if ( child_ ) child_->write( f );
-  dirty_ = 0;
-  return 0;
+  else
+    fprintf( f, "%s\n", e.name );
 }
 
 // set the parent node and create the full path
@@ -1253,18 +1357,18 @@ Fl_Preferences::Node *Fl_Preferences::Node::addChild( const char *path ) {
 // create and set, or change an entry within this node
 void Fl_Preferences::Node::set( const char *name, const char *value )
 {
-  for ( int i=0; i<nEntry_; i++ ) {
-    if ( strcmp( name, entry_[i].name ) == 0 ) {
-      if ( !value ) return; // annotation
-      if ( strcmp( value, entry_[i].value ) != 0 ) {
-        if ( entry_[i].value )
-          free( entry_[i].value );
-        entry_[i].value = fl_strdup( value );
-        dirty_ = 1;
-      }
-      lastEntrySet = i;
-      return;
+  int i = getEntry( name );
+  if ( i >= 0 ) {
+    if ( !value ) return; // annotation
+    if ( !entry_[i].value || strcmp( value, entry_[i].value ) != 0 ) {
+      if ( entry_[i].value )
+        free( entry_[i].value );
+      entry_[i].value = fl_strdup( value );
+      entry_[i].dirty = 1;
+      dirty_ = 1;
     }
+    lastEntrySet = i;
+    return;
   }
   if ( NEntry_==nEntry_ ) {
     NEntry_ = NEntry_ ? NEntry_*2 : 10;
@@ -1272,9 +1376,20 @@ void Fl_Preferences::Node::set( const char *name, const char *value )
   }
   entry_[ nEntry_ ].name = fl_strdup( name );
   entry_[ nEntry_ ].value = value?fl_strdup(value):0;
+  entry_[ nEntry_ ].dirty = 1;
   lastEntrySet = nEntry_;
   nEntry_++;
   dirty_ = 1;
+  if ( hash_ ) {
+    if ( nEntry_*2 > NHash_ ) {
+      deleteHash();             // grow the table
+      createHash();
+    } else {
+      unsigned h = hash( name ) & (NHash_-1);
+      while ( hash_[h] ) h = (h+1) & (NHash_-1);
+      hash_[h] = nEntry_;
+    }
+  }
 }
 
 // create or set a value (or annotation) from a single line in the file buffer
@@ -1317,7 +1432,17 @@ const char *Fl_Preferences::Node::get( const char *name ) {
 }
 
 // find the index of an entry, returns -1 if no such entry
+// - groups with many entries use a hash table of entry indices
 int Fl_Preferences::Node::getEntry( const char *name ) {
+  if ( !hash_ && nEntry_ >= HASH_MIN_ENTRIES ) createHash();
+  if ( hash_ ) {
+    for ( unsigned h = hash( name ) & (NHash_-1); hash_[h]; h = (h+1) & (NHash_-1) ) {
+      int i = hash_[h] - 1;
+      if ( strcmp( name, entry_[i].name ) == 0 )
+        return i;
+    }
+    return -1;
+  }
   for ( int i=0; i<nEntry_; i++ ) {
     if ( strcmp( name, entry_[i].name ) == 0 ) {
       return i;
@@ -1330,12 +1455,47 @@ int Fl_Preferences::Node::getEntry( const char *name ) {
 char Fl_Preferences::Node::deleteEntry( const char *name ) {
   int ix = getEntry( name );
   if ( ix == -1 ) return 0;
+  if ( entry_[ix].name ) free( entry_[ix].name );
+  if ( entry_[ix].value ) free( entry_[ix].value );
   memmove( entry_+ix, entry_+ix+1, (nEntry_-ix-1) * sizeof(Entry) );
   nEntry_--;
+  deleteHash();                 // indices have changed
   dirty_ = 1;
+  rewrite_ = 1;
   return 1;
 }
 
+// build the hash table of entry indices
+// - the table has at least twice as many slots as there are entries
+// - a slot holds the entry index plus one, or 0 if it is empty
+void Fl_Preferences::Node::createHash() {
+  int n = 64;
+  while ( n < nEntry_*4 ) n *= 2;
+  hash_ = (int*)calloc( n, sizeof(int) );
+  NHash_ = n;
+  for ( int i = 0; i < nEntry_; i++ ) {
+    unsigned h = hash( entry_[i].name ) & (n-1);
+    while ( hash_[h] ) h = (h+1) & (n-1);
+    hash_[h] = i+1;
+  }
+}
+
+void Fl_Preferences::Node::deleteHash() {
+  if ( hash_ ) free( hash_ );
+  hash_ = 0;
+  NHash_ = 0;
+}
+
+// return the child with the given name, or NULL
+Fl_Preferences::Node *Fl_Preferences::Node::findChild( const char *name, size_t len ) {
+  for ( Node *nd = child_; nd; nd = nd->next_ ) {
+    const char *n = nd->name();
+    if ( strncmp( n, name, len ) == 0 && n[len] == 0 )
+      return nd;
+  }
+  return 0;
+}
+
 // find a group somewhere in the tree starting here
 // - this method will always return a valid node (except for memory allocation problems)
 // - if the node was not found, 'find' will create the required branch
@@ -1345,18 +1505,17 @@ Fl_Preferences::Node *Fl_Preferences::Node::find( const char *path ) {
     if ( path[ len ] == 0 )
       return this;
     if ( path[ len ] == '/' ) {
-      Node *nd;
-      for ( nd = child_; nd; nd = nd->next_ ) {
-        Node *nn = nd->find( path );
-        if ( nn ) return nn;
-      }
       const char *s = path+len+1;
       const char *e = strchr( s, '/' );
-      if (e) strlcpy( nameBuffer, s, e-s+1 );
-      else strlcpy( nameBuffer, s, sizeof(nameBuffer));
-      nd = new Node( nameBuffer );
-      nd->setParent( this );
-      dirty_ = 1;
+      size_t n = e ? (size_t)(e-s) : strlen( s );
+      Node *nd = findChild( s, n );
+      if ( !nd ) {
+        strlcpy( nameBuffer, s, n+1 < sizeof(nameBuffer) ? n+1 : sizeof(nameBuffer) );
+        nd = new Node( nameBuffer );
+        nd->setParent( this );
+        nd->dirty_ = 1;
+        dirty_ = 1;
+      }
       return nd->find( path );
     }
   }
@@ -1383,23 +1542,17 @@ Fl_Preferences::Node *Fl_Preferences::Node::search( const char *path, int offset
         return nn->search( path+2, 2 ); // do a relative search on the root node
       }
     }
-    offset = (int) strlen( path_ ) + 1;
   }
-  int len = (int) strlen( path_ );
-  if ( len < offset-1 ) return 0;
-  len -= offset;
-  if ( ( len <= 0 ) || ( strncmp( path, path_+offset, len ) == 0 ) ) {
-    if ( len > 0 && path[ len ] == 0 )
-      return this;
-    if ( len <= 0 || path[ len ] == '/' ) {
-      for ( Node *nd = child_; nd; nd = nd->next_ ) {
-        Node *nn = nd->search( path, offset );
-        if ( nn ) return nn;
-      }
-      return 0;
-    }
+  // walk down the tree, one path segment at a time
+  Node *nd = this;
+  for (;;) {
+    const char *e = strchr( path, '/' );
+    size_t n = e ? (size_t)(e-path) : strlen( path );
+    if ( n == 0 ) return 0;
+    nd = nd->findChild( path, n );
+    if ( !nd || !e ) return nd;
+    path = e+1;
   }
-  return 0;
 }
 
 // return the number of child nodes (groups)
@@ -1467,6 +1620,7 @@ char Fl_Preferences::Node::remove() {
       }
     }
     parent()->dirty_ = 1;
+    parent()->rewrite_ = 1;
     parent()->updateIndex();
   }
   delete this;
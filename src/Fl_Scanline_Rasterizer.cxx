@@ -0,0 +1,380 @@
+//
+// Anti-aliased scanline rasterizer for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2020 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+/**
+ \cond DriverDev
+ \addtogroup DriverDeveloper
+ \{
+ */
+
+#include "Fl_Scanline_Rasterizer.H"
+#include <FL/fl_draw.H>
+#include <FL/math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Miter joins longer than this many times the line width become bevel joins
+static const float miter_limit = 10.0f;
+// Sub-scanlines sampled per pixel row by render()
+static const int sub_rows = 16;
+
+Fl_Scanline_Rasterizer::Fl_Scanline_Rasterizer() {
+  edges_ = 0;
+  nedges_ = edges_alloc_ = 0;
+  xmin_ = ymin_ = xmax_ = ymax_ = 0;
+  cells_ = 0;
+  cells_alloc_ = 0;
+  mask_ = 0;
+  mask_alloc_ = 0;
+  work_ = 0;
+  active_ = 0;
+  work_alloc_ = 0;
+}
+
+Fl_Scanline_Rasterizer::~Fl_Scanline_Rasterizer() {
+  free(edges_);
+  free(cells_);
+  free(mask_);
+  free(work_);
+  free(active_);
+}
+
+/** Adds an edge from x0, y0 to x1, y1. The edges of each contour must be
+ added in order, and each contour must be closed. */
+void Fl_Scanline_Rasterizer::add_edge(float x0, float y0, float x1, float y1) {
+  if (y0 == y1) return; // horizontal edges cover no area
+  if (nedges_ == edges_alloc_) {
+    edges_alloc_ = edges_alloc_ ? 2 * edges_alloc_ : 256;
+    edges_ = (float*)realloc(edges_, 4 * edges_alloc_ * sizeof(float));
+  }
+  float *e = edges_ + 4 * nedges_;
+  e[0] = x0; e[1] = y0; e[2] = x1; e[3] = y1;
+  if (!nedges_) {
+    xmin_ = xmax_ = x0;
+    ymin_ = ymax_ = y0;
+  }
+  nedges_++;
+  if (x0 < xmin_)
+    xmin_ = x0;
+  if (x0 > xmax_)
+    xmax_ = x0;
+  if (x1 < xmin_)
+    xmin_ = x1;
+  if (x1 > xmax_)
+    xmax_ = x1;
+  if (y0 < ymin_)
+    ymin_ = y0;
+  if (y0 > ymax_)
+    ymax_ = y0;
+  if (y1 < ymin_)
+    ymin_ = y1;
+  if (y1 > ymax_)
+    ymax_ = y1;
+}
+
+/** Adds a closed contour of \p n points, \p xy holding x and y of each point. */
+void Fl_Scanline_Rasterizer::add_polygon(const float *xy, int n) {
+  if (n < 3) return;
+  for (int i = 1; i < n; i++)
+    add_edge(xy[2*i-2], xy[2*i-1], xy[2*i], xy[2*i+1]);
+  add_edge(xy[2*n-2], xy[2*n-1], xy[0], xy[1]);
+}
+
+// Adds a convex polygon with the same orientation as all other parts
+// of a stroke, so that overlapping parts do not cancel each other.
+void Fl_Scanline_Rasterizer::add_convex(const float *xy, int n) {
+  float area = 0;
+  int i;
+  for (i = 0; i < n; i++) {
+    int j = (i + 1) % n;
+    area += xy[2*i] * xy[2*j+1] - xy[2*j] * xy[2*i+1];
+  }
+  if (area >= 0) {
+    add_polygon(xy, n);
+  } else {
+    for (i = n - 1; i > 0; i--)
+      add_edge(xy[2*i], xy[2*i+1], xy[2*i-2], xy[2*i-1]);
+    add_edge(xy[0], xy[1], xy[2*n-2], xy[2*n-1]);
+  }
+}
+
+void Fl_Scanline_Rasterizer::add_disc(float x, float y, float r) {
+  float xy[2*128];
+  int n = 8 + (int)(2 * r);
+  if (n > 128) n = 128;
+  for (int i = 0; i < n; i++) {
+    double a = 2 * M_PI * i / n;
+    xy[2*i] = x + r * (float)cos(a);
+    xy[2*i+1] = y + r * (float)sin(a);
+  }
+  add_convex(xy, n);
+}
+
+/**
+ Adds the outline of a polyline of \p n points with the given line width.
+ \p cap and \p join are the cap and join flags of fl_line_style().
+ If \p closed is set, the last point is joined to the first one.
+ Call render() with the NON_ZERO rule to draw the stroke.
+ */
+void Fl_Scanline_Rasterizer::stroke(const float *xy, int n, int closed, float width, int cap, int join) {
+  float hw = (width < 1 ? 1 : width) / 2;
+  float q[8];
+  // start: first point, direction of the first segment; prev: previous direction
+  float dx0 = 0, dy0 = 0, sdx = 0, sdy = 0;
+  int i, segs = 0;
+  for (i = 0; i < n + (closed ? 1 : 0) - 1; i++) {
+    const float *a = xy + 2 * i, *b = xy + 2 * ((i + 1) % n);
+    float dx = b[0] - a[0], dy = b[1] - a[1];
+    float len = (float)sqrt(dx * dx + dy * dy);
+    if (len == 0) continue;
+    dx /= len; dy /= len;
+    float nx = -dy * hw, ny = dx * hw;
+    q[0] = a[0] + nx; q[1] = a[1] + ny;
+    q[2] = b[0] + nx; q[3] = b[1] + ny;
+    q[4] = b[0] - nx; q[5] = b[1] - ny;
+    q[6] = a[0] - nx; q[7] = a[1] - ny;
+    add_convex(q, 4);
+    if (segs) {
+      // join with the previous segment at point a
+      float cross = dx0 * dy - dy0 * dx, s = cross > 0 ? -hw : hw;
+      float n0x = -dy0 * s, n0y = dx0 * s, n1x = -dy * s, n1y = dx * s;
+      if (join == FL_JOIN_ROUND) {
+        add_disc(a[0], a[1], hw);
+      } else if (cross != 0) {
+        float cosa = dx0 * dx + dy0 * dy;
+        q[0] = a[0]; q[1] = a[1];
+        q[2] = a[0] + n0x; q[3] = a[1] + n0y;
+        if (join != FL_JOIN_BEVEL && 2 <= miter_limit * miter_limit * (1 + cosa)) {
+          q[4] = a[0] + (n0x + n1x) / (1 + cosa); q[5] = a[1] + (n0y + n1y) / (1 + cosa);
+          q[6] = a[0] + n1x; q[7] = a[1] + n1y;
+          add_convex(q, 4);
+        } else {
+          q[4] = a[0] + n1x; q[5] = a[1] + n1y;
+          add_convex(q, 3);
+        }
+      }
+    } else {
+      sdx = dx; sdy = dy;
+    }
+    dx0 = dx; dy0 = dy;
+    segs++;
+  }
+  if (closed && segs) {
+    // join the last segment with the first one at the first point
+    float cross = dx0 * sdy - dy0 * sdx, s = cross > 0 ? -hw : hw;
+    if (join == FL_JOIN_ROUND) {
+      add_disc(xy[0], xy[1], hw);
+    } else if (cross != 0) {
+      float cosa = dx0 * sdx + dy0 * sdy;
+      float n0x = -dy0 * s, n0y = dx0 * s, n1x = -sdy * s, n1y = sdx * s;
+      q[0] = xy[0]; q[1] = xy[1];
+      q[2] = xy[0] + n0x; q[3] = xy[1] + n0y;
+      if (join != FL_JOIN_BEVEL && 2 <= miter_limit * miter_limit * (1 + cosa)) {
+        q[4] = xy[0] + (n0x + n1x) / (1 + cosa); q[5] = xy[1] + (n0y + n1y) / (1 + cosa);
+        q[6] = xy[0] + n1x; q[7] = xy[1] + n1y;
+        add_convex(q, 4);
+      } else {
+        q[4] = xy[0] + n1x; q[5] = xy[1] + n1y;
+        add_convex(q, 3);
+      }
+    }
+    return;
+  }
+  if (!segs) { // a single point is drawn as a dot with round and square caps
+    if (n < 1) return;
+    if (cap == FL_CAP_ROUND) add_disc(xy[0], xy[1], hw);
+    else if (cap == FL_CAP_SQUARE) {
+      q[0] = xy[0] - hw; q[1] = xy[1] - hw; q[2] = xy[0] + hw; q[3] = xy[1] - hw;
+      q[4] = xy[0] + hw; q[5] = xy[1] + hw; q[6] = xy[0] - hw; q[7] = xy[1] + hw;
+      add_convex(q, 4);
+    }
+    return;
+  }
+  // caps at both ends, dx0/dy0 is the direction of the last segment
+  const float *e = xy + 2 * (n - 1);
+  if (cap == FL_CAP_ROUND) {
+    add_disc(xy[0], xy[1], hw);
+    add_disc(e[0], e[1], hw);
+  } else if (cap == FL_CAP_SQUARE) {
+    float nx = -sdy * hw, ny = sdx * hw, tx = sdx * hw, ty = sdy * hw;
+    q[0] = xy[0] + nx; q[1] = xy[1] + ny; q[2] = xy[0] - nx; q[3] = xy[1] - ny;
+    q[4] = q[2] - tx; q[5] = q[3] - ty; q[6] = q[0] - tx; q[7] = q[1] - ty;
+    add_convex(q, 4);
+    nx = -dy0 * hw; ny = dx0 * hw; tx = dx0 * hw; ty = dy0 * hw;
+    q[0] = e[0] + nx; q[1] = e[1] + ny; q[2] = e[0] - nx; q[3] = e[1] - ny;
+    q[4] = q[2] + tx; q[5] = q[3] + ty; q[6] = q[0] + tx; q[7] = q[1] + ty;
+    add_convex(q, 4);
+  }
+}
+
+// Adds coverage g to the pixels of a row between x = xa and x = xb, as
+// changes of coverage: a running sum along the row gives the coverage
+// of every pixel.
+static void add_span(float *row, float xa, float xb, int w, float g) {
+  if (xa < 0) xa = 0;
+  if (xb > w) xb = (float)w;
+  if (xb <= xa) return;
+  int ia = (int)xa, ib = (int)xb;
+  if (ia == ib) {
+    float c = (xb - xa) * g;
+    row[ia] += c;
+    row[ia + 1] -= c;
+  } else {
+    float fa = xa - ia, fb = xb - ib;
+    row[ia] += (1 - fa) * g;
+    row[ia + 1] += fa * g;
+    row[ib] += (fb - 1) * g;
+    row[ib + 1] -= fb * g;
+  }
+}
+
+// Sorts the edges prepared by render() by their top y coordinate
+static int compare_edges(const void *a, const void *b) {
+  float ya = *(const float*)a, yb = *(const float*)b;
+  return ya < yb ? -1 : ya > yb ? 1 : 0;
+}
+
+/**
+ Computes the coverage of all edges added since the last call.
+
+ Each pixel row is sampled with several sub-scanlines. On each of them
+ the spans inside the shape are found from the edge crossings and the
+ fill rule, and their exact horizontal extent is added to the coverage.
+ Overlapping contours and self-intersecting polygons are thus covered
+ once, as the fill rule says, and not once per contour.
+
+ Only the part of the bounding box of the edges inside the clip rectangle
+ \p cx, \p cy, \p cw, \p ch is computed. On return \p X, \p Y, \p W, \p H
+ is the rectangle covered by the mask. All edges are removed.
+
+ \param[in] rule NON_ZERO or EVEN_ODD
+ \return W x H coverage values from 0 to 255, row by row, or NULL if
+ nothing is visible. The mask is valid until the next call.
+ */
+const uchar *Fl_Scanline_Rasterizer::render(int rule, int cx, int cy, int cw, int ch,
+                                            int &X, int &Y, int &W, int &H) {
+  W = H = 0;
+  if (!nedges_) return 0;
+  int x0 = (int)floor(xmin_), y0 = (int)floor(ymin_);
+  int x1 = (int)ceil(xmax_), y1 = (int)ceil(ymax_);
+  if (x0 < cx) x0 = cx;
+  if (y0 < cy) y0 = cy;
+  if (x1 > cx + cw) x1 = cx + cw;
+  if (y1 > cy + ch) y1 = cy + ch;
+  if (x1 <= x0 || y1 <= y0) { nedges_ = 0; return 0; }
+  int w = x1 - x0, h = y1 - y0, stride = w + 2;
+  if (stride * h > cells_alloc_) {
+    cells_alloc_ = stride * h;
+    free(cells_);
+    cells_ = (float*)malloc(cells_alloc_ * sizeof(float));
+  }
+  if (w * h > mask_alloc_) {
+    mask_alloc_ = w * h;
+    free(mask_);
+    mask_ = (uchar*)malloc(mask_alloc_);
+  }
+  if (nedges_ > work_alloc_) {
+    work_alloc_ = nedges_;
+    free(work_);
+    free(active_);
+    work_ = (float*)malloc(7 * work_alloc_ * sizeof(float));
+    active_ = (int*)malloc(work_alloc_ * sizeof(int));
+  }
+  if (!cells_ || !mask_ || !work_ || !active_) {
+    free(cells_); free(mask_); free(work_); free(active_);
+    cells_ = 0; mask_ = 0; work_ = 0; active_ = 0;
+    cells_alloc_ = mask_alloc_ = work_alloc_ = 0;
+    nedges_ = 0;
+    return 0;
+  }
+  memset(cells_, 0, stride * h * sizeof(float));
+
+  // Prepare the edges that cross the mask: top y, bottom y, x at the top,
+  // change of x per row and direction, sorted by top y
+  int n = 0, i;
+  const float *e = edges_;
+  for (i = 0; i < nedges_; i++, e += 4) {
+    float ex0 = e[0] - x0, ey0 = e[1] - y0, ex1 = e[2] - x0, ey1 = e[3] - y0;
+    float dir = 1;
+    if (ey0 > ey1) {
+      float t;
+      t = ex0; ex0 = ex1; ex1 = t;
+      t = ey0; ey0 = ey1; ey1 = t;
+      dir = -1;
+    }
+    if (ey1 <= 0 || ey0 >= h) continue;
+    float *p = work_ + 5 * n++;
+    p[0] = ey0; p[1] = ey1; p[2] = ex0;
+    p[3] = (ex1 - ex0) / (ey1 - ey0); p[4] = dir;
+  }
+  nedges_ = 0;
+  qsort(work_, n, 5 * sizeof(float), compare_edges);
+  float *cross = work_ + 5 * work_alloc_;     // x and direction of each crossing
+
+  const float g = 1.0f / sub_rows;
+  int next = 0, nactive = 0;
+  for (int y = 0; y < h; y++) {
+    float *row = cells_ + y * stride;
+    for (int sub = 0; sub < sub_rows; sub++) {
+      float sy = y + (sub + 0.5f) * g;
+      while (next < n && work_[5 * next] <= sy) active_[nactive++] = next++;
+      // the crossings of this sub-scanline, sorted by x
+      int nc = 0;
+      for (int k = 0; k < nactive; ) {
+        const float *p = work_ + 5 * active_[k];
+        if (p[1] <= sy) { active_[k] = active_[--nactive]; continue; }
+        k++;
+        float xs = p[2] + (sy - p[0]) * p[3];
+        int j = nc++;
+        while (j > 0 && cross[2 * j - 2] > xs) {
+          cross[2 * j] = cross[2 * j - 2];
+          cross[2 * j + 1] = cross[2 * j - 1];
+          j--;
+        }
+        cross[2 * j] = xs;
+        cross[2 * j + 1] = p[4];
+      }
+      // add the spans inside the shape according to the fill rule
+      int winding = 0;
+      float start = 0;
+      for (i = 0; i < nc; i++) {
+        int was_inside = rule == EVEN_ODD ? (winding & 1) : winding != 0;
+        winding += cross[2 * i + 1] > 0 ? 1 : -1;
+        int inside = rule == EVEN_ODD ? (winding & 1) : winding != 0;
+        if (inside && !was_inside) start = cross[2 * i];
+        else if (was_inside && !inside) add_span(row, start, cross[2 * i], w, g);
+      }
+    }
+  }
+
+  uchar *m = mask_;
+  for (int y = 0; y < h; y++) {
+    const float *row = cells_ + y * stride;
+    float acc = 0;
+    for (int x = 0; x < w; x++) {
+      acc += row[x];
+      float a = acc < 0 ? 0 : acc > 1 ? 1 : acc;
+      *m++ = (uchar)(a * 255 + 0.5f);
+    }
+  }
+  X = x0; Y = y0; W = w; H = h;
+  return mask_;
+}
+
+/**
+ \}
+ \endcond
+ */
@@ -17,7 +17,7 @@
 
 #include <ctype.h>      /* isdigit */
 #include <string.h>     /* memset */
-#include <stdlib.h>     /* strtol */
+#include <stdlib.h>     /* abs, malloc */
 #include <FL/Fl_Simple_Terminal.H>
 #include <FL/Fl.H>
 #include <stdarg.h>
@@ -57,12 +57,9 @@ static const Fl_Text_Display::Style_Table_Entry builtin_stable[] = {
 static const int  builtin_stable_size = sizeof(builtin_stable);
 static const char builtin_normal_index = 17;        // the reset style index used by \033[0m
 
-// Count how many times character 'c' appears in string 's'
-static int strcnt(const char *s, char c) {
-  int count = 0;
-  while ( *s ) { if ( *s++ == c ) ++count; }
-  return count;
-}
+// Pending text larger than this (and larger than the buffer) is added
+// right away instead of waiting for the event loop
+static const int pend_flush_size = 64 * 1024;
 
 // Vertical scrollbar callback intercept
 void Fl_Simple_Terminal::vscroll_cb2(Fl_Widget *w, void*) {
@@ -76,6 +73,11 @@ void Fl_Simple_Terminal::vscroll_cb(Fl_Widget *w, void *data) {
   o->vscroll_cb2(w,(void*)0);
 }
 
+// Check callback: adds the text appended since the last event loop pass
+void Fl_Simple_Terminal::flush_cb(void *data) {
+  ((Fl_Simple_Terminal*)data)->flush_pending();
+}
+
 /**
  Creates a new Fl_Simple_Terminal widget that can be a child of other FLTK widgets.
 */
@@ -106,6 +108,15 @@ Fl_Simple_Terminal::Fl_Simple_Terminal(int X,int Y,int W,int H,const char *l) :
   stable_size_ = builtin_stable_size;
   normal_style_index_  = builtin_normal_index;
   current_style_index_ = builtin_normal_index;
+  // Pending text and ANSI parser
+  pend_text_ = 0;
+  pend_style_ = 0;
+  pend_start_ = pend_len_ = pend_size_ = pend_lines_ = 0;
+  pend_drop_ = false;
+  nl_ring_ = 0;
+  nl_first_ = nl_size_ = 0;
+  esc_len_ = esc_nvals_ = 0;
+  esc_val_ = -1;
   // Intercept vertical scrolling
   orig_vscroll_cb = mVScrollBar->callback();
   orig_vscroll_data = mVScrollBar->user_data();
@@ -117,6 +128,10 @@ Fl_Simple_Terminal::Fl_Simple_Terminal(int X,int Y,int W,int H,const char *l) :
  for the terminal, including text buffer, style buffer, etc.
 */
 Fl_Simple_Terminal::~Fl_Simple_Terminal() {
+  Fl::remove_check(flush_cb, this);
+  free(pend_text_);
+  free(pend_style_);
+  free(nl_ring_);
   buffer(0);    // disassociate buffer /before/ we delete it
   if ( buf  ) { delete buf;  buf  = 0; }
   if ( sbuf ) { delete sbuf; sbuf = 0; }
@@ -182,6 +197,7 @@ int Fl_Simple_Terminal::history_lines() const {
                  A value of 0 is not recommended.
 */
 void Fl_Simple_Terminal::history_lines(int maxlines) {
+  flush_pending();              // pending lines were kept for the old limit
   history_lines_ = maxlines;
   enforce_history_lines();
 }
@@ -489,17 +505,99 @@ void Fl_Simple_Terminal::enforce_stay_at_bottom() {
  should need to call this.
 */
 void Fl_Simple_Terminal::enforce_history_lines() {
+  if ( pend_drop_ || pend_len_ > pend_start_ ) {
+    flush_pending();            // adds the pending text, then trims
+    return;
+  }
   if ( history_lines() > -1 && lines > history_lines() ) {
     int trimlines = lines - history_lines();
     remove_lines(0, trimlines);                         // remove lines from top
   }
 }
 
+/**
+ \internal
+ Make room for at least \p n more bytes of pending text (and styles).
+
+ Text that scrolled out of the history is dropped from the front of the
+ pending text when that frees at least half of the space, so the pending
+ text is moved at most once per filling of the array.
+*/
+void Fl_Simple_Terminal::pend_reserve(int n) {
+  if ( pend_len_ + n <= pend_size_ ) return;
+  int live = pend_len_ - pend_start_;
+  if ( pend_start_ > 0 && pend_start_ >= live ) {
+    memmove(pend_text_, pend_text_ + pend_start_, live);
+    memmove(pend_style_, pend_style_ + pend_start_, live);
+    for ( int i = 0; history_lines_ > 0 && i < pend_lines_; i++ )
+      nl_ring_[(nl_first_ + i) & (nl_size_ - 1)] -= pend_start_;
+    pend_start_ = 0;
+    pend_len_ = live;
+    if ( pend_len_ + n <= pend_size_ ) return;
+  }
+  int size = pend_size_ ? pend_size_ : 1024;
+  while ( size < pend_len_ + n ) size *= 2;
+  char *text  = (char*)realloc(pend_text_, size);
+  if ( text ) pend_text_ = text;
+  char *style = (char*)realloc(pend_style_, size);
+  if ( style ) pend_style_ = style;
+  if ( !text || !style )
+    Fl::fatal("Fl_Simple_Terminal: out of memory (%d bytes)", size);
+  pend_size_ = size;
+}
+
+/**
+ \internal
+ Record a newline in the pending text; \p pos is the offset just past it.
+
+ With a history limit, the offsets of the last history_lines() pending
+ lines are kept in a ring. Once more lines are pending, the oldest one
+ is dropped in constant time by moving the start of the pending text,
+ and all lines in the buffer will be removed when the text is added.
+*/
+void Fl_Simple_Terminal::pend_newline(int pos) {
+  if ( history_lines_ < 0 ) {           // unlimited history: just count
+    pend_lines_++;
+    return;
+  }
+  if ( history_lines_ == 0 ) {          // no history at all: drop the line
+    pend_start_ = pos;
+    pend_drop_ = true;
+    return;
+  }
+  if ( pend_lines_ == nl_size_ ) {      // grow ring, oldest entry first
+    int size = nl_size_ ? nl_size_ * 2 : 64;
+    int *ring = (int*)malloc(size * sizeof(int));
+    for ( int i = 0; i < pend_lines_; i++ )
+      ring[i] = nl_ring_[(nl_first_ + i) & (nl_size_ - 1)];
+    free(nl_ring_);
+    nl_ring_ = ring;
+    nl_size_ = size;
+    nl_first_ = 0;
+  }
+  nl_ring_[(nl_first_ + pend_lines_) & (nl_size_ - 1)] = pos;
+  if ( ++pend_lines_ > history_lines_ ) {
+    pend_start_ = nl_ring_[nl_first_];  // drop oldest pending line
+    nl_first_ = (nl_first_ + 1) & (nl_size_ - 1);
+    pend_lines_--;
+    pend_drop_ = true;
+  }
+}
+
 /**
  Appends new string 's' to terminal.
 
  The string can contain UTF-8, crlf's, and ANSI sequences are
- also supported when ansi(bool) is set to 'true'.
+ also supported when ansi(bool) is set to 'true'. An ANSI sequence
+ may be split across several calls.
+
+ To keep fast output cheap, appended text is collected and added to the
+ text buffer in one go before the terminal is redrawn, or when the event
+ loop runs next. Lines that would scroll out of the history_lines() limit
+ before that are dropped without ever being added to the buffer. text()
+ always returns the complete text; code that uses the text buffer or
+ other methods inherited from Fl_Text_Display should call
+ flush_pending() first.
 
  \param s string to append.
 
@@ -509,101 +607,145 @@ void Fl_Simple_Terminal::enforce_history_lines() {
  \see printf(), vprintf(), text(), clear()
 */
 void Fl_Simple_Terminal::append(const char *s, int len) {
-  // Remove ansi codes and adjust style buffer accordingly.
-  if ( ansi() ) {
-    int nstyles = stable_size_ / STE_SIZE;
-    if ( len < 0 ) len = strlen(s);
-    // New text buffer (after ansi codes parsed+removed)
-    char *ntm = (char*)malloc(len+1);       // new text memory
-    char *ntp = ntm;
-    char *nsm = (char*)malloc(len+1);       // new style memory
-    char *nsp = nsm;
-    // ANSI values
-    char astyle = 'A'+current_style_index_; // the running style index
-    const char *esc = 0;
-    const char *sp = s;
-    // Walk user's string looking for codes, modify new text/style text as needed
-    while ( *sp ) {
-      if ( *sp == 033 ) {        // "\033.."
-        esc = sp++;
-        switch (*sp) {
-          case 0:                // "\033<NUL>"? stop
+  if ( len < 0 ) {
+    len = (int)strlen(s);
+  } else {
+    const char *e = (const char*)memchr(s, 0, len);
+    if ( e ) len = (int)(e - s);
+  }
+  // Parsed text is never longer than 's' plus a sequence left from the
+  // last call, and the flush needs room for a trailing NUL
+  pend_reserve(len + (int)sizeof(esc_seq_) + 1);
+  int nstyles = stable_size_ / STE_SIZE;
+  char astyle = 'A' + current_style_index_;   // the running style index
+  int p = pend_len_;
+  const char *sp = s, *ep = s + len;
+  while ( sp < ep ) {
+    if ( esc_len_ == 0 ) {
+      // Copy text up to the next newline or escape
+      const char *rp = sp;
+      if ( ansi_ ) {
+        while ( rp < ep && *rp != '\n' && *rp != 033 ) rp++;
+      } else {
+        rp = (const char*)memchr(sp, '\n', ep - sp);
+        if ( !rp ) rp = ep;
+      }
+      int n = (int)(rp - sp);
+      memcpy(pend_text_ + p, sp, n);
+      if ( ansi_ ) memset(pend_style_ + p, astyle, n);
+      p += n;
+      sp = rp;
+      if ( sp == ep ) break;
+      if ( *sp == '\n' ) {
+        pend_text_[p] = '\n';
+        pend_style_[p] = astyle;
+        sp++;
+        pend_newline(++p);
+      } else {                          // "\033.."
+        esc_seq_[0] = *sp++;
+        esc_len_ = 1;
+      }
+      continue;
+    }
+    char c = *sp++;
+    if ( esc_len_ == 1 ) {
+      if ( c == '[' ) {                 // "\033[.."
+        esc_seq_[esc_len_++] = c;
+        esc_nvals_ = 0;
+        esc_val_ = -1;
+      } else {                          // not a sequence: drop the ESC
+        esc_len_ = 0;
+        --sp;
+      }
+      continue;
+    }
+    if ( isdigit(c) && esc_len_ < (int)sizeof(esc_seq_) ) {   // "\033[#;#.."
+      esc_seq_[esc_len_++] = c;
+      if ( esc_val_ < 0 ) esc_val_ = 0;
+      if ( esc_val_ < 100000000 ) esc_val_ = esc_val_ * 10 + (c - '0');
+      continue;
+    }
+    if ( esc_val_ < 0 ) {               // "\033[" or ";" not followed by a number
+      esc_len_ = 0;
+      --sp;
+      continue;
+    }
+    if ( !isdigit(c) ) {
+      esc_vals_[esc_nvals_++] = esc_val_;
+      esc_val_ = -1;
+      if ( esc_nvals_ < 4 ) {           // else too many #'s specified: abort
+        switch ( c ) {
+          case ';':                     // numeric separator
+            if ( esc_len_ == (int)sizeof(esc_seq_) ) break;
+            esc_seq_[esc_len_++] = c;
+            continue;
+          case 'J':                     // erase in display
+            if ( esc_vals_[0] == 2 ) {  // \033[2J -- clear entire screen
+              clear();                  // clear text buffer and pending text
+              p = 0;
+            }                           // \033[0J and \033[1J unsupported
+            esc_len_ = 0;
             continue;
-          case '[': {            // "\033[.."
-            ++sp;
-            int vals[4], tv=0, seqdone=0;
-            while ( *sp && !seqdone && isdigit(*sp) ) { // "\033[#;#.."
-              char *newsp;
-              long a = strtol(sp, &newsp, 10);
-              sp = newsp;
-              vals[tv++] = (a<0) ? 0 : a;       // prevent negative values
-              if ( tv >= 4 )      // too many #'s specified? abort sequence
-                { seqdone = 1; sp = esc+1; continue; }
-              switch(*sp) {
-                case ';':         // numeric separator
-                  ++sp;
-                  continue;
-                case 'J':         // erase in display
-                  switch (vals[0]) {
-                    case 0:       // \033[0J -- clear to eol
-                      // unsupported
-                      break;
-                    case 1:       // \033[1J -- clear to sol
-                      // unsupported
-                      break;
-                    case 2:       // \033[2J -- clear entire screen
-                      clear();    // clear text buffer
-                      ntp = ntm;  // clear text contents accumulated so far
-                      nsp = nsm;  // clear style contents ""
-                      break;
-                  }
-                  ++sp;
-                  seqdone = 1;
-                  continue;
-                case 'm':         // set color
-                  if ( tv > 0 ) { // at least one value parsed?
-                    current_style_index_ = (vals[0] == 0)            // "reset"?
-                                             ? normal_style_index_   // use normal color for "reset"
-                                             : (vals[0] % nstyles);  // use user's value, wrapped to ensure not larger than table
-                    astyle = 'A' + current_style_index_;             // convert index -> style buffer char
-                  }
-                  ++sp;
-                  seqdone = 1;
-                  continue;
-                case '\0':        // EOS in middle of sequence?
-                  *ntp = 0;       // end of text
-                  *nsp = 0;       // end of style
-                  seqdone = 1;
-                  continue;
-                default:          // un-supported cmd?
-                  seqdone = 1;
-                  sp = esc+1;     // continue parsing just past esc
-                  break;
-              }   // switch
-            }     // while
-          }       // case '['
-        }         // switch
-      }           // \033
-      else {
-        // Non-ANSI character?
-        if ( *sp == '\n' ) ++lines; // keep track of #lines
-        *ntp++ = *sp++;             // pass char thru
-        *nsp++ = astyle;            // use current style
+          case 'm':                     // set color
+            current_style_index_ = (esc_vals_[0] == 0)             // "reset"?
+                                     ? normal_style_index_         // use normal color for "reset"
+                                     : (esc_vals_[0] % nstyles);   // use user's value, wrapped to ensure not larger than table
+            astyle = 'A' + current_style_index_;                  // convert index -> style buffer char
+            esc_len_ = 0;
+            continue;
+        }
       }
-    } // while
-    *ntp = 0;
-    *nsp = 0;
-    //::printf("  RESULT: ntm='%s'\n", ntm);
-    //::printf("  RESULT: nsm='%s'\n", nsm);
-    buf->append(ntm);           // new text memory
-    sbuf->append(nsm);          // new style memory
-    free(ntm);
-    free(nsm);
-  } else {
-    // non-ansi buffer
-    buf->append(s);
-    lines += ::strcnt(s, '\n');  // count total line feeds in string added
+    }
+    // Un-supported sequence: show it without the ESC, then continue
+    // parsing at the character that ended it
+    int n = esc_len_ - 1;
+    memcpy(pend_text_ + p, esc_seq_ + 1, n);
+    memset(pend_style_ + p, astyle, n);
+    p += n;
+    esc_len_ = 0;
+    --sp;
   }
+  pend_len_ = p;
+  if ( !pend_drop_ && pend_len_ == pend_start_ ) return;
+  if ( pend_len_ - pend_start_ > pend_flush_size &&
+       pend_len_ - pend_start_ > buf->length() )
+    flush_pending();
+  else if ( !Fl::has_check(flush_cb, this) )
+    Fl::add_check(flush_cb, this);
+}
+
+/**
+ Adds text appended since the last call to the text and style buffers,
+ trims the history, and scrolls to the bottom if needed.
+
+ This is called automatically before the terminal is drawn, by the
+ event loop, and by the methods of this class. Call it before using
+ buffer(), insert_position(), scroll() or other methods inherited from
+ Fl_Text_Display right after appending text.
+
+ \since 1.4.0
+*/
+void Fl_Simple_Terminal::flush_pending() {
+  Fl::remove_check(flush_cb, this);
+  if ( !pend_drop_ && pend_len_ == pend_start_ ) return;
+  if ( pend_drop_ ) {           // all lines in the buffer left the history
+    buf->text("");
+    sbuf->text("");
+    lines = 0;
+  }
+  if ( pend_len_ > pend_start_ ) {
+    // Update the style buffer first so styles always cover the text
+    if ( ansi() ) {
+      pend_style_[pend_len_] = 0;
+      sbuf->append(pend_style_ + pend_start_);
+    }
+    pend_text_[pend_len_] = 0;
+    buf->append(pend_text_ + pend_start_);
+  }
+  lines += pend_lines_;
+  pend_start_ = pend_len_ = pend_lines_ = 0;
+  nl_first_ = 0;
+  pend_drop_ = false;
   enforce_history_lines();
   enforce_stay_at_bottom();
 }
@@ -636,6 +778,7 @@ void Fl_Simple_Terminal::text(const char *s, int len) {
  onscreen content.
 */
 const char* Fl_Simple_Terminal::text() const {
+  ((Fl_Simple_Terminal*)this)->flush_pending();
   return buf->text();
 }
 
@@ -687,13 +830,17 @@ void Fl_Simple_Terminal::vprintf(const char *fmt, va_list ap) {
   ::vsnprintf(buffer, 1024, fmt, ap);
   buffer[1024-1] = 0;   // XXX: MICROSOFT
   append(buffer);
-  enforce_history_lines();
 }
 
 /**
  Clears the terminal's screen and history. Cursor moves to top of window.
 */
 void Fl_Simple_Terminal::clear() {
+  Fl::remove_check(flush_cb, this);
+  pend_start_ = pend_len_ = pend_lines_ = 0;
+  nl_first_ = 0;
+  pend_drop_ = false;
+  esc_len_ = 0;
   buf->text("");
   sbuf->text("");
   lines = 0;
@@ -703,14 +850,16 @@ void Fl_Simple_Terminal::clear() {
  Remove the specified range of lines from the terminal, starting
  with line 'start' and removing 'count' lines.
 
- This method is used to enforce the history limit.
+ This method is used to enforce the history limit. Lines are counted
+ by their newlines, not by how they wrap on screen.
 
  \param start -- starting line to remove
  \param count -- number of lines to remove
 */
 void Fl_Simple_Terminal::remove_lines(int start, int count) {
-  int spos = skip_lines(0, start, true);
-  int epos = skip_lines(spos, count, true);
+  flush_pending();
+  int spos = buf->skip_lines(0, start);
+  int epos = buf->skip_lines(spos, count);
   if ( ansi() ) {
     buf->remove(spos, epos);
     sbuf->remove(spos, epos);
@@ -732,6 +881,8 @@ void Fl_Simple_Terminal::draw() {
   //
 #define LEFT_MARGIN 3
 #define RIGHT_MARGIN 3
+  // Add text appended since the last event loop pass
+  flush_pending();
   int buflen = buf->length();
   // Force cursor to EOF so it doesn't draw at user's last left-click
   insert_position(buflen);
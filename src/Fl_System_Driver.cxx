@@ -29,6 +29,7 @@
 #include <stdarg.h>
 #include <string.h>
 #include "flstring.h"
+#include "utf8_internal.h"
 #include <time.h>
 
 const int Fl_System_Driver::fl_NoValue =     0x0000;
@@ -277,7 +278,12 @@ unsigned Fl_System_Driver::utf8towc(const char* src, unsigned srclen, wchar_t* d
       return count;
     }
     if (!(*p & 0x80)) { /* ascii */
-      dst[count] = *p++;
+      unsigned n = fl_utf8_ascii_span(p, (unsigned)(e-p));
+      if (n > dstlen-count-1) n = dstlen-count-1;
+      for (unsigned i = 0; i < n; i++) dst[count+i] = p[i];
+      count += n; p += n;
+      if (count == dstlen-1) {dst[count] = 0; break;}
+      continue;
     } else {
       int len; unsigned ucs = fl_utf8decode(p,e,&len);
       p += len;
@@ -287,8 +293,11 @@ unsigned Fl_System_Driver::utf8towc(const char* src, unsigned srclen, wchar_t* d
   }
   /* we filled dst, measure the rest: */
   while (p < e) {
-    if (!(*p & 0x80)) p++;
-    else {
+    if (!(*p & 0x80)) {
+      unsigned n = fl_utf8_ascii_span(p, (unsigned)(e-p));
+      p += n; count += n;
+      continue;
+    } else {
       int len; fl_utf8decode(p,e,&len);
       p += len;
     }
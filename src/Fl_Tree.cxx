@@ -76,6 +76,9 @@ static int find_total_children(Fl_Tree_Item *item, int count=0) {
 
 /// Constructor.
 Fl_Tree::Fl_Tree(int X, int Y, int W, int H, const char *L) : Fl_Group(X,Y,W,H,L) {
+  _layout_gen = 1;
+  _xywh_gen   = 1;
+  _layout_xyw[0] = _layout_xyw[1] = _layout_xyw[2] = 0;
   _root = new Fl_Tree_Item(this);
   _root->parent(0);                             // we are root of tree
   _root->label("ROOT");
@@ -650,12 +653,19 @@ void Fl_Tree::calc_dimensions() {
 /// The tree hierarchy's size only changes when items are added/removed,
 /// open/closed, label contents or font sizes changed, margins changed, etc.
 ///
-/// This calculation involves walking the *entire* tree from top to bottom,
-/// potentially a slow calculation if the tree has many items (potentially
-/// hundreds of thousands), and should therefore be called sparingly.
+/// Each item caches the size of itself and its displayed children,
+/// so only items whose geometry changed since the last calculation
+/// (and their parents) are measured again; unchanged subtrees are
+/// accounted for from the cache. Changes to a single item (label, open/close,
+/// adding/removing children..) only invalidate that item's cache, whereas
+/// recalc_tree() invalidates the cache of the entire tree.
 ///
-/// For this reason, recalc_tree() is used as a way to /schedule/
-/// calculation when changes affect the tree hierarchy's size.
+/// The cached sizes also allow draw() and find_clicked() to skip over
+/// subtrees that are scrolled off-screen, so that drawing and mouse
+/// handling only involve the items actually displayed.
+///
+/// recalc_tree() is used as a way to /schedule/ calculation when
+/// changes affect the tree hierarchy's size.
 ///
 /// Apps may want to call this method directly if the app makes changes
 /// to the tree's geometry, then immediately needs to work with the tree's
@@ -687,6 +697,24 @@ void Fl_Tree::calc_tree() {
   _tree_h = _prefs.margintop()  + Y - ytop;             // include margin in tree's height
   // Calc tree dims again; now that tree_w/tree_h are known, scrollbars are calculated.
   calc_dimensions();
+  // Item positions calculated above are relative to the unscrolled tree;
+  // have items recalculate their xywh from the layout cache when needed.
+  layout_origin(_layout_xyw[0], _layout_xyw[1], _layout_xyw[2]);
+  if ( ++_xywh_gen == 0 ) _xywh_gen = 1;
+}
+
+// Return the X/Y/W position of the root item for the current scroll position.
+//    Items' xywh are calculated relative to this.
+//
+void Fl_Tree::layout_origin(int &X, int &Y, int &W) const {
+  X = _tix + _prefs.marginleft() - (int)_hscroll->value();
+  Y = _tiy + _prefs.margintop()  - (int)_vscroll->value();
+  W = _tiw - X + _tix;
+  // Adjust root's X/W if connectors off
+  if (_prefs.connectorstyle() == FL_TREE_CONNECTOR_NONE) {
+    X -= _prefs.openicon()->w();
+    W += _prefs.openicon()->w();
+  }
 }
 
 void Fl_Tree::resize(int X,int Y,int W, int H) {
@@ -713,13 +741,12 @@ void Fl_Tree::draw() {
     if ( ! _root ) return;
     // These values are changed during drawing
     // By end, 'Y' will be the lowest point on the tree
-    int X = _tix + _prefs.marginleft() - _hscroll->value();
-    int Y = _tiy + _prefs.margintop()  - _vscroll->value();
-    int W = _tiw - X + _tix;
-    // Adjust root's X/W if connectors off
-    if (_prefs.connectorstyle() == FL_TREE_CONNECTOR_NONE) {
-      X -= _prefs.openicon()->w();
-      W += _prefs.openicon()->w();
+    int X, Y, W;
+    layout_origin(X, Y, W);
+    // Scrolled or resized? Items not drawn below need to update their xywh
+    if ( X != _layout_xyw[0] || Y != _layout_xyw[1] || W != _layout_xyw[2] ) {
+      _layout_xyw[0] = X; _layout_xyw[1] = Y; _layout_xyw[2] = W;
+      if ( ++_xywh_gen == 0 ) _xywh_gen = 1;
     }
     // Draw entire tree, starting with root
     fl_push_clip(_tix,_tiy,_tiw,_tih);
@@ -2333,6 +2360,7 @@ Fl_Tree_Item_Draw_Mode Fl_Tree::item_draw_mode() const {
 ///
 void Fl_Tree::item_draw_mode(Fl_Tree_Item_Draw_Mode mode) {
   _prefs.item_draw_mode(mode);
+  recalc_tree();
 }
 
 /// Set the 'item draw mode' used for the tree to integer \p 'mode'.
@@ -2344,6 +2372,84 @@ void Fl_Tree::item_draw_mode(Fl_Tree_Item_Draw_Mode mode) {
 ///
 void Fl_Tree::item_draw_mode(int mode) {
   _prefs.item_draw_mode(Fl_Tree_Item_Draw_Mode(mode));
+  recalc_tree();
+}
+
+/**
+ Sets the callback that creates the children of items on demand.
+
+ Items marked with Fl_Tree_Item::children_pending(1) are shown with
+ an 'open' icon, but have no children until they are opened for the first time.
+ Before such an item is opened, \p 'cb' is invoked with the item and \p 'data'
+ so the children can be added, e.g. from a database or the file system.
+ Children that may have children of their own can be marked in turn.
+ This way a large hierarchy only needs to create the items that are displayed.
+ \par
+ \code
+ :
+ static void populate_cb(Fl_Tree_Item *item, void *data) {
+   Fl_Tree *tree = (Fl_Tree*)data;
+   for ( int t=0; t<my_child_count(item); t++ ) {
+     Fl_Tree_Item *child = tree->add(item, my_child_name(item, t));
+     if ( my_child_count(child) > 0 ) child->children_pending(1);
+   }
+ }
+ :
+ tree->item_populate_callback(populate_cb, (void*)tree);
+ Fl_Tree_Item *item = tree->add("Database");
+ item->children_pending(1);             // children are added by populate_cb() when opened
+ :
+ \endcode
+
+ \param[in] cb   The callback, or NULL to disable creating children on demand.
+ \param[in] data User data passed to the callback.
+ \see unload_closed(), Fl_Tree_Item::children_pending()
+ \version 1.4.0
+*/
+void Fl_Tree::item_populate_callback(Fl_Tree_Item_Populate_Callback *cb, void *data) {
+  _prefs.item_populate_callback(cb, data);
+}
+
+/// Returns the callback that creates the children of items on demand, if any.
+/// \see item_populate_callback(Fl_Tree_Item_Populate_Callback*,void*)
+/// \version 1.4.0
+///
+Fl_Tree_Item_Populate_Callback* Fl_Tree::item_populate_callback() const {
+  return(_prefs.item_populate_callback());
+}
+
+/// Returns the user data passed to the item_populate_callback().
+/// \version 1.4.0
+///
+void* Fl_Tree::item_populate_user_data() const {
+  return(_prefs.item_populate_user_data());
+}
+
+/// Returns 1 if children created on demand are deleted when their parent is closed.
+/// \see unload_closed(int)
+/// \version 1.4.0
+///
+int Fl_Tree::unload_closed() const {
+  return(_prefs.unload_closed());
+}
+
+/// Sets whether children created on demand are deleted when their parent is closed.
+///
+/// If enabled, closing an item whose children were created by the
+/// item_populate_callback() deletes those children (and their descendants)
+/// and marks the item's children as pending again, so they are created
+/// anew when the item is re-opened. This keeps memory use proportional
+/// to the part of the tree that is open.
+///
+/// Widgets assigned to the deleted items with Fl_Tree_Item::widget()
+/// are not deleted; the application remains responsible for them.
+///
+/// \param[in] val 1 to delete children of closed items, 0 to keep them (default).
+/// \see item_populate_callback()
+/// \version 1.4.0
+///
+void Fl_Tree::unload_closed(int val) {
+  _prefs.unload_closed(val);
 }
 
 /// See if \p 'item' is currently displayed on-screen (visible within the widget).
@@ -2684,8 +2790,13 @@ void Fl_Tree::fix_scrollbar_order() {
 }
 
 /// Schedule tree to recalc the entire tree size.
+///
+/// This discards the layout cache of all items, so the next calc_tree()
+/// measures every item again. Use this if a change affects the geometry of
+/// all items, e.g. a change of the tree's margins or icons.
 /// \note Must be using FLTK ABI 1.3.3 or higher for this to be effective.
 ///
 void Fl_Tree::recalc_tree() {
   _tree_w = _tree_h = -1;
+  if ( ++_layout_gen == 0 ) _layout_gen = 1;    // 0 is reserved for 'dirty' items
 }
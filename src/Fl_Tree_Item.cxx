@@ -2,6 +2,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <FL/Fl.H>
 #include <FL/Fl_Widget.H>
@@ -34,6 +35,256 @@ static int event_inside(const int xywh[4]) {
   return(Fl::event_inside(xywh[0],xywh[1],xywh[2],xywh[3]));
 }
 
+/////////////////////////////////////////////////////////////////////////// 80 /
+// Item pool -- see Fl_Tree_Item::use_pool()
+//
+//    Items of exactly sizeof(Fl_Tree_Item) are carved out of slabs of
+//    POOL_SLAB_ITEMS items; released items are kept in a per-slab free list.
+//    Slabs are kept sorted by address so operator delete can find the slab
+//    an item belongs to. Larger objects (subclasses) use the global operator new.
+//
+//    Labels are shared: each distinct text is stored once with a use count,
+//    and found through a hash table.
+//
+#define POOL_SLAB_ITEMS 1024            // #items per slab
+
+struct Pool_Slab {
+  char *mem;                            // memory for POOL_SLAB_ITEMS items
+  void *freelist;                       // released items, linked through their first word
+  int   used;                           // #items allocated from this slab
+  int   bump;                           // #items at start of mem handed out so far
+};
+
+struct Pool_Label {
+  Pool_Label *next;                     // next label in same hash bucket
+  unsigned    hash;                     // hash of text
+  unsigned    refs;                     // #items using this label
+  char        text[1];                  // the label's text (allocated to size)
+};
+
+static int          pool_enabled  = 0;  // use_pool() value
+static Pool_Slab   *pool_slabs    = 0;  // slabs, sorted by address
+static int          pool_nslabs   = 0;  // #slabs in use
+static int          pool_size     = 0;  // #slabs allocated in pool_slabs
+static int          pool_cur      = -1; // slab to allocate from next (-1 if none)
+static int          pool_nempty   = 0;  // #slabs with no items allocated
+static Pool_Label **pool_labels   = 0;  // label hash buckets
+static int          pool_nbuckets = 0;  // #buckets (power of 2)
+static int          pool_nlabels  = 0;  // #labels in hash
+
+// Return index of the slab containing item 'p', or -1 if none
+static int pool_find_slab(const void *p) {
+  const char *c = (const char*)p;
+  int lo = 0, hi = pool_nslabs - 1;
+  while ( lo <= hi ) {
+    int mid = (lo + hi) / 2;
+    const char *mem = pool_slabs[mid].mem;
+    if ( c < mem ) hi = mid - 1;
+    else if ( c >= mem + POOL_SLAB_ITEMS * sizeof(Fl_Tree_Item) ) lo = mid + 1;
+    else return(mid);
+  }
+  return(-1);
+}
+
+// Allocate a new slab, return its index or -1 if out of memory
+static int pool_add_slab() {
+  char *mem = (char*)malloc(POOL_SLAB_ITEMS * sizeof(Fl_Tree_Item));
+  if ( !mem ) return(-1);
+  if ( pool_nslabs == pool_size ) {
+    int newsize = pool_size ? pool_size * 2 : 16;
+    Pool_Slab *slabs = (Pool_Slab*)realloc(pool_slabs, newsize * sizeof(Pool_Slab));
+    if ( !slabs ) { free(mem); return(-1); }
+    pool_slabs = slabs;
+    pool_size  = newsize;
+  }
+  int s = pool_nslabs;                  // keep slabs sorted by address
+  while ( s > 0 && pool_slabs[s-1].mem > mem ) --s;
+  memmove(&pool_slabs[s+1], &pool_slabs[s], (pool_nslabs - s) * sizeof(Pool_Slab));
+  pool_slabs[s].mem      = mem;
+  pool_slabs[s].freelist = 0;
+  pool_slabs[s].used     = 0;
+  pool_slabs[s].bump     = 0;
+  ++pool_nslabs;
+  ++pool_nempty;
+  return(s);
+}
+
+// Free the (empty) slab at index 's'
+static void pool_remove_slab(int s) {
+  free((void*)pool_slabs[s].mem);
+  --pool_nslabs;
+  memmove(&pool_slabs[s], &pool_slabs[s+1], (pool_nslabs - s) * sizeof(Pool_Slab));
+  if ( pool_cur == s ) pool_cur = -1;
+  else if ( pool_cur > s ) --pool_cur;
+  if ( pool_nslabs == 0 ) {
+    free((void*)pool_slabs);
+    pool_slabs = 0;
+    pool_size  = 0;
+  }
+}
+
+// FNV-1a hash of a label's text
+static unsigned pool_label_hash(const char *s) {
+  unsigned h = 2166136261U;
+  for ( ; *s; s++ ) { h ^= (unsigned char)*s; h *= 16777619U; }
+  return(h);
+}
+
+// Resize the label hash table to 'nbuckets' (a power of 2)
+static void pool_rehash(int nbuckets) {
+  Pool_Label **buckets = (Pool_Label**)calloc(nbuckets, sizeof(Pool_Label*));
+  if ( !buckets ) return;               // keep old table, just gets slower
+  for ( int t=0; t<pool_nbuckets; t++ ) {
+    Pool_Label *l = pool_labels[t];
+    while ( l ) {
+      Pool_Label *next = l->next;
+      Pool_Label **b = &buckets[l->hash & (nbuckets-1)];
+      l->next = *b;
+      *b = l;
+      l = next;
+    }
+  }
+  free((void*)pool_labels);
+  pool_labels   = buckets;
+  pool_nbuckets = nbuckets;
+}
+
+// Return a shared copy of label 'text', or 0 if out of memory
+static const char *pool_label_share(const char *text) {
+  unsigned h = pool_label_hash(text);
+  if ( pool_nbuckets ) {
+    for ( Pool_Label *l = pool_labels[h & (pool_nbuckets-1)]; l; l = l->next ) {
+      if ( l->hash == h && strcmp(l->text, text) == 0 ) {
+        ++l->refs;
+        return(l->text);
+      }
+    }
+  }
+  if ( pool_nlabels >= pool_nbuckets )
+    pool_rehash(pool_nbuckets ? pool_nbuckets * 2 : 256);
+  if ( !pool_nbuckets ) return(0);
+  size_t len = strlen(text);
+  Pool_Label *l = (Pool_Label*)malloc(offsetof(Pool_Label, text) + len + 1);
+  if ( !l ) return(0);
+  memcpy(l->text, text, len + 1);
+  l->hash = h;
+  l->refs = 1;
+  Pool_Label **b = &pool_labels[h & (pool_nbuckets-1)];
+  l->next = *b;
+  *b = l;
+  ++pool_nlabels;
+  return(l->text);
+}
+
+// Add a use to shared label 'text'
+static const char *pool_label_ref(const char *text) {
+  ++((Pool_Label*)(text - offsetof(Pool_Label, text)))->refs;
+  return(text);
+}
+
+// Release a use of shared label 'text', freeing it when no longer used
+static void pool_label_release(const char *text) {
+  Pool_Label *l = (Pool_Label*)(text - offsetof(Pool_Label, text));
+  if ( --l->refs > 0 ) return;
+  Pool_Label **b = &pool_labels[l->hash & (pool_nbuckets-1)];
+  while ( *b != l ) b = &(*b)->next;
+  *b = l->next;
+  free((void*)l);
+  if ( --pool_nlabels == 0 ) {
+    free((void*)pool_labels);
+    pool_labels   = 0;
+    pool_nbuckets = 0;
+  }
+}
+
+/// Allocate memory for an item.
+/// Uses the item pool if enabled with use_pool(1), otherwise the global operator new.
+///
+void *Fl_Tree_Item::operator new(size_t size) {
+  if ( !pool_enabled || size != sizeof(Fl_Tree_Item) )
+    return(::operator new(size));               // pool disabled, or subclass
+  // Find a slab with room, preferring the one used last
+  int s = pool_cur;
+  if ( s < 0 || pool_slabs[s].used == POOL_SLAB_ITEMS ) {
+    for ( s=0; s<pool_nslabs && pool_slabs[s].used == POOL_SLAB_ITEMS; s++ ) { }
+    if ( s == pool_nslabs && (s = pool_add_slab()) < 0 )
+      return(::operator new(size));             // out of memory: let operator new deal with it
+    pool_cur = s;
+  }
+  Pool_Slab &slab = pool_slabs[s];
+  if ( slab.used == 0 ) --pool_nempty;
+  void *p;
+  if ( slab.freelist ) {
+    p = slab.freelist;
+    slab.freelist = *(void**)p;
+  } else {
+    p = slab.mem + (slab.bump++) * sizeof(Fl_Tree_Item);
+  }
+  ++slab.used;
+  return(p);
+}
+
+/// Free memory of an item allocated with operator new.
+/// Items allocated from the item pool are returned to the pool.
+///
+void Fl_Tree_Item::operator delete(void *p) {
+  int s = p ? pool_find_slab(p) : -1;
+  if ( s < 0 ) { ::operator delete(p); return; }
+  Pool_Slab &slab = pool_slabs[s];
+  if ( --slab.used == 0 ) {
+    // Slab is empty: start over at its beginning for better locality.
+    // Keep one empty slab while the pool is enabled to avoid thrashing.
+    slab.freelist = 0;
+    slab.bump     = 0;
+    if ( !pool_enabled || pool_nempty > 0 ) { pool_remove_slab(s); return; }
+    ++pool_nempty;
+  } else {
+    *(void**)p = slab.freelist;
+    slab.freelist = p;
+  }
+  if ( pool_cur < 0 || pool_slabs[pool_cur].used == POOL_SLAB_ITEMS )
+    pool_cur = s;
+}
+
+/**
+ Enable or disable the pooled storage of items.
+
+ When enabled, new items (e.g. those created by Fl_Tree::add())
+ are allocated from large blocks of memory shared by many items
+ instead of one heap allocation each, and items with the same label
+ share a single copy of the label's text. This considerably reduces
+ the memory needed by trees with many items, and keeps items that
+ were created together close in memory, which speeds up traversing the tree.
+ \par
+ The setting is global and can be changed at any time; it affects
+ only items created (or labels set) afterwards. Memory of the pool
+ is freed again when the items allocated from it are deleted.
+ Objects of classes derived from Fl_Tree_Item are not pooled if they
+ are larger than Fl_Tree_Item, but their labels are shared.
+ \par
+ Like all FLTK calls, the pool is not thread safe: create and delete
+ items only in the main thread, or while holding Fl::lock().
+
+ \param[in] val 1 to enable, 0 to disable the pool (default).
+ \version 1.4.0
+*/
+void Fl_Tree_Item::use_pool(int val) {
+  pool_enabled = val ? 1 : 0;
+  if ( !pool_enabled ) {                        // release unused slabs
+    for ( int s=pool_nslabs-1; s>=0; s-- )
+      if ( pool_slabs[s].used == 0 ) pool_remove_slab(s);
+    pool_nempty = 0;
+  }
+}
+
+/// Returns 1 if items use pooled storage, 0 if not.
+/// \see use_pool(int)
+/// \version 1.4.0
+///
+int Fl_Tree_Item::use_pool() {
+  return(pool_enabled);
+}
+
 /// Constructor.
 /// Makes a new instance of Fl_Tree_Item using defaults from \p 'prefs'.
 /// \deprecated in 1.3.3 ABI -- you must use Fl_Tree_Item(Fl_Tree*) for proper horizontal scrollbar behavior.
@@ -73,6 +324,13 @@ void Fl_Tree_Item::_Init(const Fl_Tree_Prefs &prefs, Fl_Tree *tree) {
   _children.manage_item_destroy(1);     // let array's dtor manage destroying Fl_Tree_Items
   _prev_sibling     = 0;
   _next_sibling     = 0;
+  _layout_gen       = 0;
+  _xywh_gen         = 0;
+  _layout_ry        = 0;
+  _layout_h         = 0;
+  _layout_ch        = 0;
+  _layout_th        = 0;
+  _layout_xmax      = 0;
 }
 
 /// Constructor.
@@ -90,7 +348,8 @@ Fl_Tree_Item::Fl_Tree_Item(Fl_Tree *tree) {
 // DTOR
 Fl_Tree_Item::~Fl_Tree_Item() {
   if ( _label ) {
-    free((void*)_label);
+    if ( is_flag(LABEL_SHARED) ) pool_label_release(_label);
+    else free((void*)_label);
     _label = 0;
   }
   _widget = 0;                  // Fl_Group will handle destruction
@@ -99,13 +358,17 @@ Fl_Tree_Item::~Fl_Tree_Item() {
   // focus item? set to null
   if ( _tree && this == _tree->_item_focus )
     { _tree->_item_focus = 0; }
+  // last selected item? set to null
+  if ( _tree && this == _tree->_lastselect )
+    { _tree->_lastselect = 0; }
   //_children.clear();          // array's destructor handles itself
 }
 
 /// Copy constructor.
 Fl_Tree_Item::Fl_Tree_Item(const Fl_Tree_Item *o) {
   _tree             = o->_tree;
-  _label        = o->label() ? fl_strdup(o->label()) : 0;
+  _label        = !o->_label ? 0 :
+                  o->is_flag(LABEL_SHARED) ? pool_label_ref(o->_label) : fl_strdup(o->_label);
   _labelfont    = o->labelfont();
   _labelsize    = o->labelsize();
   _labelfgcolor = o->labelfgcolor();
@@ -129,6 +392,13 @@ Fl_Tree_Item::Fl_Tree_Item(const Fl_Tree_Item *o) {
   _parent           = o->_parent;
   _prev_sibling     = 0;                // do not copy ptrs! use update_prev_next()
   _next_sibling     = 0;                // do not copy ptrs! use update_prev_next()
+  _layout_gen       = 0;                // copy must be measured again
+  _xywh_gen         = 0;
+  _layout_ry        = 0;
+  _layout_h         = 0;
+  _layout_ch        = 0;
+  _layout_th        = 0;
+  _layout_xmax      = 0;
 }
 
 /// Print the tree as 'ascii art' to stdout.
@@ -153,10 +423,22 @@ void Fl_Tree_Item::show_self(const char *indent) const {
 
 /// Set the label to \p 'name'.
 /// Makes and manages an internal copy of \p 'name'.
+/// With use_pool(1) the copy is shared with other items that have the same label.
 ///
 void Fl_Tree_Item::label(const char *name) {
-  if ( _label ) { free((void*)_label); _label = 0; }
-  _label = name ? fl_strdup(name) : 0;
+  const char *old = _label;
+  int shared = is_flag(LABEL_SHARED);
+  _label = (name && pool_enabled) ? pool_label_share(name) : 0;
+  if ( _label ) {
+    _flags |= LABEL_SHARED;
+  } else {
+    _label = name ? fl_strdup(name) : 0;
+    _flags &= ~LABEL_SHARED;
+  }
+  if ( old ) {
+    if ( shared ) pool_label_release(old);
+    else free((void*)old);
+  }
   recalc_tree();                // may change label geometry
 }
 
@@ -438,6 +720,7 @@ Fl_Tree_Item *Fl_Tree_Item::insert_above(const Fl_Tree_Prefs &prefs, const char
 Fl_Tree_Item* Fl_Tree_Item::deparent(int pos) {
   Fl_Tree_Item *orphan = _children[pos];
   if ( _children.deparent(pos) < 0 ) return NULL;
+  recalc_tree();                // may change tree geometry
   return orphan;
 }
 
@@ -452,6 +735,7 @@ int Fl_Tree_Item::reparent(Fl_Tree_Item *newchild, int pos) {
   int ret;
   if ( (ret = _children.reparent(newchild, this, pos)) < 0 ) return ret;
   newchild->parent(this);               // take custody
+  recalc_tree();                        // may change tree geometry
   return 0;
 }
 
@@ -464,7 +748,9 @@ int Fl_Tree_Item::reparent(Fl_Tree_Item *newchild, int pos) {
 /// \see move_above(), move_below(), move_into(), move(Fl_Tree_Item*,int,int)
 ///
 int Fl_Tree_Item::move(int to, int from) {
-  return _children.move(to, from);
+  int ret = _children.move(to, from);
+  if ( ret == 0 ) recalc_tree();        // may change tree geometry
+  return ret;
 }
 
 /// Move the current item above/below/into the specified 'item',
@@ -673,6 +959,7 @@ int Fl_Tree_Item::remove_child(const char *name) {
 ///
 void Fl_Tree_Item::swap_children(int ax, int bx) {
   _children.swap(ax, bx);
+  recalc_tree();                // may change tree geometry
 }
 
 /// Swap two of our immediate children, given item pointers.
@@ -763,7 +1050,9 @@ void Fl_Tree_Item::draw_vertical_connector(int x, int y1, int y2, const Fl_Tree_
 ///
 const Fl_Tree_Item *Fl_Tree_Item::find_clicked(const Fl_Tree_Prefs &prefs, int yonly) const {
   if ( ! is_visible() ) return(0);
-  if ( is_root() && !prefs.showroot() ) {
+  update_xywh();
+  char drawthis = ( is_root() && !prefs.showroot() ) ? 0 : 1;
+  if ( !drawthis ) {
     // skip event check if we're root but root not being shown
   } else {
     // See if event is over us
@@ -778,8 +1067,23 @@ const Fl_Tree_Item *Fl_Tree_Item::find_clicked(const Fl_Tree_Prefs &prefs, int y
       }
     }
   }
-  if ( is_open() ) {                            // open? check children of this item
-    for ( int t=0; t<children(); t++ ) {
+  if ( is_open() && has_children() ) {          // open? check children of this item
+    int t = 0, tend = children();
+    if ( layout_valid() && _xywh_gen == _tree->_xywh_gen ) {
+      // Use layout cache to find the few children whose subtree spans the event
+      int child_y_start = _xywh[1] + (drawthis ? _layout_h + prefs.linespacing() : 0);
+      int ey = Fl::event_y();
+      int lo = 0, hi = tend - 1;
+      while ( lo < hi ) {                       // first child whose subtree reaches event
+        int mid = (lo + hi) / 2;
+        const Fl_Tree_Item *c = _children[mid];
+        if ( child_y_start + c->_layout_ry + c->_layout_th < ey ) lo = mid + 1;
+        else hi = mid;
+      }
+      for ( t=lo, tend=lo; tend<children(); tend++ )  // children starting below event can't match
+        if ( child_y_start + _children[tend]->_layout_ry > ey ) break;
+    }
+    for ( ; t<tend; t++ ) {
       const Fl_Tree_Item *item;
       if ( (item = _children[t]->find_clicked(prefs, yonly)) != NULL)  // recurse into child for descendents
         return(item);                                                  // found?
@@ -856,7 +1160,8 @@ int Fl_Tree_Item::calc_item_height(const Fl_Tree_Prefs &prefs) const {
        H < widget()->h()) {
     H = widget()->h();
   }
-  if ( has_children() && prefs.openicon() && H<prefs.openicon()->h() )
+  if ( (has_children() || children_pending()) &&
+       prefs.openicon() && H<prefs.openicon()->h() )
     H = prefs.openicon()->h();
   if ( usericon() && H<usericon()->h() )
     H = usericon()->h();
@@ -1008,30 +1313,40 @@ int Fl_Tree_Item::draw_item_content(int render) {
 void Fl_Tree_Item::draw(int X, int &Y, int W, Fl_Tree_Item *itemfocus,
                         int &tree_item_xmax, int lastchild, int render) {
   Fl_Tree_Prefs &prefs = _tree->_prefs;
-  if ( !is_visible() ) return;
+  if ( !is_visible() ) {
+    if ( !render ) {                    // keep parent's layout cache consistent
+      _layout_ch = _layout_th = _layout_xmax = 0;
+      _flags &= ~LAYOUT_WIDGETS;
+      _layout_gen = _tree->_layout_gen;
+    }
+    return;
+  }
   int tree_top = tree()->_tiy;
   int tree_bot = tree_top + tree()->_tih;
-  int H = calc_item_height(prefs);      // height of item
+  // Use our layout cache instead of measuring ourself and our children?
+  //    Not if we (or one of our children) have a widget that needs positioning.
+  char cached = layout_valid() ? 1 : 0;
+  int H = cached ? _layout_h : calc_item_height(prefs); // height of item
   int H2 = H + prefs.linespacing();     // height of item with line spacing
+  int Y_start = Y;
+  _layout_h = H;
+
+  // Update the xywh of this item, its collapse icon and label
+  calc_xywh(X, Y, W, H, prefs);
+
+  // Skip entire subtree if its size is known and it's either not rendered
+  // or scrolled off-screen: children will update their xywh when needed.
+  if ( cached && ( !render || (Y+_layout_th+1) < tree_top || Y > (tree_bot+1) ) ) {
+    if ( X + _layout_xmax > tree_item_xmax )
+      tree_item_xmax = X + _layout_xmax;
+    Y += _layout_th;
+    return;
+  }
 
-  // Update the xywh of this item
-  _xywh[0] = X;
-  _xywh[1] = Y;
-  _xywh[2] = W;
-  _xywh[3] = H;
-
-  // Determine collapse icon's xywh
-  //   Note: calculate collapse icon's xywh for possible mouse click detection.
-  //   We don't care about items clipped off the viewport; they won't get mouse events.
-  //
   int item_y_center = Y+(H/2);
-  _collapse_xywh[2] = prefs.openicon()->w();
-  int &icon_w = _collapse_xywh[2];
-  _collapse_xywh[0] = X + (icon_w + prefs.connectorwidth())/2 - 3;
-  int &icon_x = _collapse_xywh[0];
-  _collapse_xywh[1] = item_y_center - (prefs.openicon()->h()/2);
-  int &icon_y = _collapse_xywh[1];
-  _collapse_xywh[3] = prefs.openicon()->h();
+  int icon_w = _collapse_xywh[2];
+  int icon_x = _collapse_xywh[0];
+  int icon_y = _collapse_xywh[1];
 
   // Horizontal connector values
   //   Must calculate these even if(clipped) because 'draw children' code (below)
@@ -1049,12 +1364,6 @@ void Fl_Tree_Item::draw(int X, int &Y, int W, Fl_Tree_Item *itemfocus,
   int uicon_w = usericon() ? usericon()->w()
                            : prefs.usericon() ? prefs.usericon()->w() : 0;
 
-  // Label xywh
-  _label_xywh[0] = uicon_x + uicon_w + prefs.labelmarginleft();
-  _label_xywh[1] = Y;
-  _label_xywh[2] = tree()->_tix + tree()->_tiw - _label_xywh[0];
-  _label_xywh[3] = H;
-
   // Begin calc of this item's max width..
   //     It might not even be visible, so start at zero.
   //
@@ -1112,7 +1421,7 @@ void Fl_Tree_Item::draw(int X, int &Y, int W, Fl_Tree_Item *itemfocus,
           }
         }
         // Draw collapse icon
-        if ( render && has_children() && prefs.showcollapse() ) {
+        if ( render && (has_children() || children_pending()) && prefs.showcollapse() ) {
           // Draw icon image
           if ( is_open() ) {
             if ( active ) prefs.closeicon()->draw(icon_x,icon_y);
@@ -1156,19 +1465,38 @@ void Fl_Tree_Item::draw(int X, int &Y, int W, Fl_Tree_Item *itemfocus,
     }                   // end drawthis
   }                     // end clipped
   if ( drawthis ) Y += H2;                                      // adjust Y (even if clipped)
-  // Manage tree_item_xmax
-  if ( xmax > tree_item_xmax )
-    tree_item_xmax = xmax;
+  // Manage max width of this item and its children
+  int subtree_xmax = xmax;
+  int has_widgets = widget() ? 1 : 0;
   // Draw child items (if any)
   if ( has_children() && is_open() ) {
     int child_x = drawthis ? (hconn_x_center - (icon_w/2) + 1)  // offset children to right,
                            : X;                                 // unless didn't drawthis
     int child_w = W - (child_x-X);
     int child_y_start = Y;
-    for ( int t=0; t<children(); t++ ) {
+    int t = 0;
+    if ( cached ) {
+      // Cached (and rendering): skip children scrolled off top of screen
+      int lo = 0, hi = children() - 1;
+      while ( lo < hi ) {               // find first child whose subtree reaches tree_top
+        int mid = (lo + hi) / 2;
+        Fl_Tree_Item *c = _children[mid];
+        if ( (child_y_start + c->_layout_ry + c->_layout_th + 1) < tree_top ) lo = mid + 1;
+        else hi = mid;
+      }
+      t = lo;
+      Y = child_y_start + _children[t]->_layout_ry;
+    }
+    for ( ; t<children(); t++ ) {
+      if ( cached && Y > (tree_bot+1) ) break;                  // rest is below screen
       int is_lastchild = ((t+1)==children()) ? 1 : 0;
-      _children[t]->draw(child_x, Y, child_w, itemfocus, tree_item_xmax, is_lastchild, render);
+      Fl_Tree_Item *c = _children[t];
+      c->_layout_ry = Y - child_y_start;
+      c->draw(child_x, Y, child_w, itemfocus, subtree_xmax, is_lastchild, render);
+      if ( c->is_flag(LAYOUT_WIDGETS) ) has_widgets = 1;
     }
+    if ( cached ) Y = child_y_start + _layout_ch;               // include children not drawn
+    else _layout_ch = Y - child_y_start;
     if ( has_children() && is_open() ) {
       Y += prefs.openchild_marginbottom();              // offset below open child tree
     }
@@ -1179,14 +1507,106 @@ void Fl_Tree_Item::draw(int X, int &Y, int W, Fl_Tree_Item *itemfocus,
       if (render && !is_clipped )
         draw_vertical_connector(hconn_x, child_y_start, Y, prefs);
     }
+  } else if ( !cached ) {
+    _layout_ch = 0;
+  }
+  // Manage tree_item_xmax
+  if ( subtree_xmax > tree_item_xmax )
+    tree_item_xmax = subtree_xmax;
+  // Update layout cache
+  if ( !cached ) {
+    _layout_th = Y - Y_start;
+    _layout_xmax = subtree_xmax - X;
+    if ( has_widgets ) _flags |= LAYOUT_WIDGETS; else _flags &= ~LAYOUT_WIDGETS;
+    if ( !render ) _layout_gen = _tree->_layout_gen;    // measured: cache now valid
   }
 }
 
+// Update the xywh of this item, its collapse icon and label
+//    for an item positioned at X,Y with width W and height H.
+//
+void Fl_Tree_Item::calc_xywh(int X, int Y, int W, int H, const Fl_Tree_Prefs &prefs) {
+  _xywh[0] = X;
+  _xywh[1] = Y;
+  _xywh[2] = W;
+  _xywh[3] = H;
+
+  // Determine collapse icon's xywh
+  //   Note: calculate collapse icon's xywh for possible mouse click detection.
+  //   We don't care about items clipped off the viewport; they won't get mouse events.
+  //
+  int icon_w = prefs.openicon()->w();
+  _collapse_xywh[0] = X + (icon_w + prefs.connectorwidth())/2 - 3;
+  _collapse_xywh[1] = Y + (H/2) - (prefs.openicon()->h()/2);
+  _collapse_xywh[2] = icon_w;
+  _collapse_xywh[3] = prefs.openicon()->h();
+
+  // Label xywh: to the right of connector and usericon
+  int cw1 = icon_w+prefs.connectorwidth()/2, cw2 = prefs.connectorwidth();
+  int conn_w = cw1>cw2 ? cw1 : cw2;
+  int uicon_x = X+(icon_w/2-1+conn_w) + ( (usericon() || prefs.usericon())
+                                          ? prefs.usericonmarginleft() : 0);
+  int uicon_w = usericon() ? usericon()->w()
+                           : prefs.usericon() ? prefs.usericon()->w() : 0;
+  _label_xywh[0] = uicon_x + uicon_w + prefs.labelmarginleft();
+  _label_xywh[1] = Y;
+  _label_xywh[2] = tree()->_tix + tree()->_tiw - _label_xywh[0];
+  _label_xywh[3] = H;
+
+  _xywh_gen = _tree->_xywh_gen;
+}
+
+// See if the layout cache of this item and its children can be used
+//    instead of measuring them, i.e. it's up to date and there are
+//    no widgets in the subtree that need to be positioned.
+//
+int Fl_Tree_Item::layout_valid() const {
+  return( _tree && _layout_gen == _tree->_layout_gen && !is_flag(LAYOUT_WIDGETS) );
+}
+
+// Update the xywh of an item not drawn since the tree was scrolled or recalculated.
+//    Uses the parents' positions and the layout cache, as draw() would have.
+//    Items that aren't displayed (e.g. children of closed items) keep their xywh.
+//
+void Fl_Tree_Item::update_xywh() const {
+  if ( !_tree || _xywh_gen == _tree->_xywh_gen ) return;        // up to date
+  if ( _layout_gen != _tree->_layout_gen || _tree->_tree_w == -1 || !is_visible() )
+    return;                                                     // not laid out
+  const Fl_Tree_Prefs &prefs = _tree->_prefs;
+  int X, Y, W;
+  if ( !_parent ) {                                             // root?
+    X = _tree->_layout_xyw[0];
+    Y = _tree->_layout_xyw[1];
+    W = _tree->_layout_xyw[2];
+  } else {
+    const Fl_Tree_Item *p = _parent;
+    if ( !p->is_open() ) return;
+    p->update_xywh();
+    if ( p->_xywh_gen != _tree->_xywh_gen ) return;             // parent not displayed
+    X = p->_xywh[0];
+    Y = p->_xywh[1];
+    W = p->_xywh[2];
+    if ( !p->is_root() || prefs.showroot() ) {                  // parent drawn? offset below+right
+      int icon_w = prefs.openicon()->w();
+      int hconn_x  = X+icon_w/2-1;
+      int hconn_x2 = hconn_x + prefs.connectorwidth();
+      int hconn_x_center = X + icon_w + ((hconn_x2 - (X + icon_w)) / 2);
+      int child_x = hconn_x_center - (icon_w/2) + 1;
+      W -= (child_x - X);
+      X = child_x;
+      Y += p->_layout_h + prefs.linespacing();
+    }
+    Y += _layout_ry;
+  }
+  const_cast<Fl_Tree_Item*>(this)->calc_xywh(X, Y, W, _layout_h, prefs);
+}
+
 
 /// Was the event on the 'collapse' button of this item?
 ///
 int Fl_Tree_Item::event_on_collapse_icon(const Fl_Tree_Prefs &prefs) const {
-  if ( is_visible() && is_active() && has_children() && prefs.showcollapse() ) {
+  if ( is_visible() && is_active() && (has_children() || children_pending()) &&
+       prefs.showcollapse() ) {
     return(event_inside(_collapse_xywh) ? 1 : 0);
   } else {
     return(0);
@@ -1255,7 +1675,15 @@ void Fl_Tree_Item::hide_widgets() {
 }
 
 /// Open this item and all its children.
+///
+/// If the item's children are pending (see children_pending(int)),
+/// the tree's item_populate_callback() is invoked first to create them.
+///
 void Fl_Tree_Item::open() {
+  if ( is_flag(CHILDREN_PENDING) ) {
+    set_flag(CHILDREN_PENDING,0);
+    if ( _tree ) _tree->_prefs.do_item_populate_callback(this);
+  }
   set_flag(OPEN,1);
   // Tell children to show() their widgets
   for ( int t=0; t<_children.total(); t++ ) {
@@ -1265,15 +1693,50 @@ void Fl_Tree_Item::open() {
 }
 
 /// Close this item and all its children.
+///
+/// If Fl_Tree::unload_closed() is enabled and the item's children
+/// were created on demand, the children are deleted and will be
+/// created again when the item is re-opened.
+///
 void Fl_Tree_Item::close() {
   set_flag(OPEN,0);
   // Tell children to hide() their widgets
   for ( int t=0; t<_children.total(); t++ ) {
     _children[t]->hide_widgets();
   }
+  if ( is_flag(CHILDREN_ON_DEMAND) && _tree && _tree->_prefs.unload_closed() ) {
+    _children.clear();                  // created again on next open()
+    set_flag(CHILDREN_PENDING,1);
+  }
   recalc_tree();                // may change tree geometry
 }
 
+/// Set whether this item's children are created on demand.
+///
+/// If \p 'val' is 1, the item is closed and shown with an 'open' icon even
+/// if it has no children yet. When it is opened the first time, the tree's
+/// Fl_Tree::item_populate_callback() is invoked to add the children.
+/// Use this to avoid creating large hierarchies of items up front.
+/// Children the item already has are deleted, since the callback creates
+/// all of them.
+///
+/// If \p 'val' is 0, the children are no longer created on demand.
+/// Existing children are kept.
+///
+/// \see Fl_Tree::item_populate_callback(), Fl_Tree::unload_closed()
+/// \version 1.4.0
+///
+void Fl_Tree_Item::children_pending(int val) {
+  if ( val ) {
+    if ( is_open() ) close();           // hides the children's widgets
+    _children.clear();                  // created again by open()
+    _flags |= (CHILDREN_PENDING|CHILDREN_ON_DEMAND);
+  } else {
+    _flags &= ~(CHILDREN_PENDING|CHILDREN_ON_DEMAND);
+  }
+  recalc_tree();                // may change collapse icon and item height
+}
+
 /// Returns how many levels deep this item is in the hierarchy.
 ///
 /// For instance; root has a depth of zero, and its immediate children
@@ -1411,7 +1874,16 @@ void Fl_Tree_Item::update_prev_next(int index) {
 Fl_Tree_Item *Fl_Tree_Item::next_visible(Fl_Tree_Prefs &prefs) {
   Fl_Tree_Item *item = this;
   while ( 1 ) {
-    item = item->next();
+    // Don't descend into children of closed or invisible items;
+    // they can't be displayed, so skip the entire subtree.
+    if ( item->has_children() && item->is_open() && item->visible() ) {
+      item = item->child(0);
+    } else {
+      Fl_Tree_Item *p;
+      while ( !item->_next_sibling && (p = item->parent()) != NULL )
+        item = p;                                       // move up to next parent
+      item = item->_next_sibling;
+    }
     if ( !item ) return 0;
     if ( item->is_root() && !prefs.showroot() ) continue;
     if ( item->visible_r() ) return(item);
@@ -1478,5 +1950,10 @@ int Fl_Tree_Item::visible_r() const {
 /// \version 1.3.3 ABI
 ///
 void Fl_Tree_Item::recalc_tree() {
-  _tree->recalc_tree();
+  if ( !_tree ) return;
+  // Invalidate layout cache of this item and all its parents;
+  // all other items in the tree keep their cached layout.
+  for ( Fl_Tree_Item *p = this; p; p = p->_parent )
+    p->_layout_gen = 0;
+  _tree->_tree_w = _tree->_tree_h = -1;         // schedule tree recalc
 }
@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <FL/Fl.H>
 #include <FL/Fl_Tree_Item_Array.H>
 #include <FL/Fl_Tree_Item.H>
 
@@ -88,17 +89,16 @@ void Fl_Tree_Item_Array::clear() {
 //
 void Fl_Tree_Item_Array::enlarge(int count) {
   int newtotal = _total + count;        // new total
-  if ( newtotal >= _size ) {            // more than we have allocated?
-    if ( (newtotal/150) > _chunksize ) _chunksize *= 10;
-    // Increase size of array
-    int newsize = _size + _chunksize;
-    Fl_Tree_Item **newitems = (Fl_Tree_Item**)malloc(newsize * sizeof(Fl_Tree_Item*));
-    if ( _items ) {
-      // Copy old array -> new, delete old
-      memmove(newitems, _items, _size * sizeof(Fl_Tree_Item*));
-      free((void*)_items); _items = 0;
+  if ( newtotal > _size ) {             // more than we have allocated?
+    // Increase size of array: start small (most items have few children),
+    // then grow by _chunksize or by doubling, whichever is larger
+    int newsize = _size ? _size + (_size > _chunksize ? _size : _chunksize) : 2;
+    if ( newsize < newtotal ) newsize = newtotal;
+    Fl_Tree_Item **newitems = (Fl_Tree_Item**)realloc((void*)_items, newsize * sizeof(Fl_Tree_Item*));
+    if ( !newitems ) {                  // keep the old array, callers can't recover
+      Fl::fatal("Fl_Tree_Item_Array: out of memory (%d items)", newsize);
+      return;
     }
-    // Adjust items/sizeitems
     _items = newitems;
     _size = newsize;
   }
@@ -228,6 +228,9 @@ Fl_Tree_Prefs::Fl_Tree_Prefs() {
   _itemdrawmode           = FL_TREE_ITEM_DRAW_DEFAULT;
   _itemdrawcallback       = 0;
   _itemdrawuserdata       = 0;
+  _itempopulatecallback   = 0;
+  _itempopulateuserdata   = 0;
+  _unloadclosed           = 0;
   // Let fltk's current 'scheme' affect defaults
   if (Fl::is_scheme("gtk+")) {
     _selectbox = _FL_GTK_THIN_UP_BOX;
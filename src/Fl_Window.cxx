@@ -473,9 +473,7 @@ void Fl_Window::flush()
 {
   if (!shown()) return;
   make_current();
-  fl_clip_region(i->region);
-  i->region = 0;
-  draw();
+  pWindowDriver->draw_damage();
 }
 
 
@@ -524,6 +522,37 @@ void Fl_Window::make_current()
   current_ = this;
 }
 
+/**
+  Returns statistics about the drawing of this window.
+
+  \param[out] drawn number of times the window was drawn by Fl::flush()
+  \param[out] skipped number of times Fl::flush() postponed the drawing
+      of the damaged window to respect Fl::max_fps(); further damage
+      until the postponed frame is drawn is not counted again
+  \param[out] late number of frames that were drawn more than one frame
+      interval after they were due, e.g. because handling events or
+      drawing took too long
+
+  Subwindows are counted separately from their top-level window.
+  \see Fl::max_fps(double), reset_frame_stats()
+  \version 1.4.0
+*/
+void Fl_Window::frame_stats(unsigned &drawn, unsigned &skipped, unsigned &late) const {
+  drawn = pWindowDriver->frames_drawn;
+  skipped = pWindowDriver->frames_skipped;
+  late = pWindowDriver->frames_late;
+}
+
+/**
+  Sets the counters returned by frame_stats() to zero.
+  \version 1.4.0
+*/
+void Fl_Window::reset_frame_stats() {
+  pWindowDriver->frames_drawn = 0;
+  pWindowDriver->frames_skipped = 0;
+  pWindowDriver->frames_late = 0;
+}
+
 void Fl_Window::label(const char *name, const char *mininame) {
   Fl_Widget::label(name);
   iconlabel_ = mininame;
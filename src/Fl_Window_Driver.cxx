@@ -42,6 +42,9 @@ pWindow(win)
   shape_data_ = NULL;
   wait_for_expose_value = 0;
   other_xid = 0;
+  frame_due = 0;
+  frame_deferred = 0;
+  frames_drawn = frames_skipped = frames_late = 0;
 }
 
 
@@ -80,6 +83,18 @@ void Fl_Window_Driver::flush_menu() { pWindow->Fl_Window::flush(); }
  */
 void Fl_Window_Driver::draw() { pWindow->draw(); }
 
+/**
+ Draw the window content clipped to its damage region, and delete the region.
+ A driver may draw separate parts of the damage region one after the other
+ when that is faster. On return, the clipping region covers all damage.
+ */
+void Fl_Window_Driver::draw_damage() {
+  Fl_X *i = Fl_X::i(pWindow);
+  fl_clip_region(i->region);
+  i->region = 0;
+  draw();
+}
+
 /**
  Prepare this window for rendering.
  A new driver may prepare bitmaps and clipping areas for calls to the
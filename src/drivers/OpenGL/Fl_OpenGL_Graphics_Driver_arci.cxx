@@ -39,12 +39,16 @@ void Fl_OpenGL_Graphics_Driver::arc(int x,int y,int w,int h,double a1,double a2)
   int nSeg = (int)(10 * sqrt(rMax))+1;
   double incr = (a2-a1)/(double)nSeg;
 
-  glBegin(GL_LINE_STRIP);
-  for (int i=0; i<nSeg; i++) {
-    glVertex2d(cx+cos(a1)*rMax, cy-sin(a1)*rMax);
+  // the arc is added to the vertex batch as nSeg-1 line segments
+  Batch_Vertex *v = batch_add(GL_LINES, 2*(nSeg-1));
+  if (!v) return;
+  float px = (float)(cx+cos(a1)*rMax), py = (float)(cy-sin(a1)*rMax);
+  for (int i=1; i<nSeg; i++) {
     a1 += incr;
+    batch_point(v++, px, py);
+    px = (float)(cx+cos(a1)*rMax); py = (float)(cy-sin(a1)*rMax);
+    batch_point(v++, px, py);
   }
-  glEnd();
 }
 
 void Fl_OpenGL_Graphics_Driver::pie(int x,int y,int w,int h,double a1,double a2) {
@@ -56,11 +60,15 @@ void Fl_OpenGL_Graphics_Driver::pie(int x,int y,int w,int h,double a1,double a2)
   int nSeg = (int)(10 * sqrt(rMax))+1;
   double incr = (a2-a1)/(double)nSeg;
 
-  glBegin(GL_TRIANGLE_FAN);
-  glVertex2d(cx, cy);
-  for (int i=0; i<nSeg+1; i++) {
-    glVertex2d(cx+cos(a1)*rMax, cy-sin(a1)*rMax);
+  // the pie is added to the vertex batch as a fan of nSeg triangles
+  Batch_Vertex *v = batch_add(GL_TRIANGLES, 3*nSeg);
+  if (!v) return;
+  float px = (float)(cx+cos(a1)*rMax), py = (float)(cy-sin(a1)*rMax);
+  for (int i=0; i<nSeg; i++) {
     a1 += incr;
+    batch_point(v++, (float)cx, (float)cy);
+    batch_point(v++, px, py);
+    px = (float)(cx+cos(a1)*rMax); py = (float)(cy-sin(a1)*rMax);
+    batch_point(v++, px, py);
   }
-  glEnd();
 }
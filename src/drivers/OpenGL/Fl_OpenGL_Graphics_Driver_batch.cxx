@@ -0,0 +1,100 @@
+//
+// Vertex batching for the OpenGL graphics driver of the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2020 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+/**
+ \file Fl_OpenGL_Graphics_Driver_batch.cxx
+ \brief Collects OpenGL primitives in a vertex array and draws them in one call.
+ */
+
+#include <config.h>
+#include "../../config_lib.h"
+#include "Fl_OpenGL_Graphics_Driver.H"
+#include <FL/gl.h>
+#include <stdlib.h>
+
+// Vertices are drawn when this many are pending, so memory use stays bounded
+// for very large drawings. This is a multiple of 6 (2 triangles per rectangle).
+static const int batch_max = 6 * 4096;
+
+Fl_OpenGL_Graphics_Driver::Fl_OpenGL_Graphics_Driver() {
+  batch_ = 0;
+  batch_n_ = batch_alloc_ = 0;
+  batch_mode_ = GL_TRIANGLES;
+  batch_color_[0] = batch_color_[1] = batch_color_[2] = 0;
+  batch_color_[3] = 255;
+  line_solid_ = 1;
+  draw_calls_ = 0;
+  first_[0] = first_[1] = prev_[0] = prev_[1] = 0;
+}
+
+Fl_OpenGL_Graphics_Driver::~Fl_OpenGL_Graphics_Driver() {
+  free(batch_);
+}
+
+/**
+ Returns room for \p count vertices of primitive type \p mode.
+ Pending vertices are drawn first if they are of another primitive type,
+ or if the batch is full. The caller must fill all \p count vertices.
+ Returns NULL if memory for the vertices can't be allocated; the caller
+ then drops the primitive.
+ */
+Fl_OpenGL_Graphics_Driver::Batch_Vertex *Fl_OpenGL_Graphics_Driver::batch_add(int mode, int count) {
+  if (batch_n_ && (mode != batch_mode_ || batch_n_ + count > batch_max))
+    flush_vertices();
+  batch_mode_ = mode;
+  if (batch_n_ + count > batch_alloc_) {
+    int size = batch_alloc_ ? 2 * batch_alloc_ : 384;
+    while (size < batch_n_ + count) size *= 2;
+    Batch_Vertex *batch = (Batch_Vertex*)realloc(batch_, size * sizeof(Batch_Vertex));
+    if (!batch) return NULL;
+    batch_ = batch;
+    batch_alloc_ = size;
+  }
+  Batch_Vertex *v = batch_ + batch_n_;
+  batch_n_ += count;
+  return v;
+}
+
+// Stores one vertex with the current color.
+void Fl_OpenGL_Graphics_Driver::batch_point(Batch_Vertex *v, float x, float y) {
+  v->rgba[0] = batch_color_[0];
+  v->rgba[1] = batch_color_[1];
+  v->rgba[2] = batch_color_[2];
+  v->rgba[3] = batch_color_[3];
+  v->x = x;
+  v->y = y;
+}
+
+/**
+ Draws all pending vertices with one glDrawArrays() call.
+ This is done automatically when drawing to an Fl_Gl_Window ends, and
+ before text is drawn. Call this before issuing OpenGL commands directly
+ if FLTK drawing functions were used before in the same window.
+ \version 1.4.0
+ */
+void Fl_OpenGL_Graphics_Driver::flush_vertices() {
+  if (!batch_n_) return;
+  // glInterleavedArrays() disables all other client arrays, so drawing
+  // does not depend on the array state of the application
+  glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+  glInterleavedArrays(GL_C4UB_V2F, 0, batch_);
+  glDrawArrays(batch_mode_, 0, batch_n_);
+  glPopClientAttrib();
+  // the current color is undefined after drawing with a color array
+  glColor4ubv(batch_color_);
+  draw_calls_++;
+  batch_n_ = 0;
+}
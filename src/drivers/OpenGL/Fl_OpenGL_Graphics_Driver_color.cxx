@@ -61,11 +61,13 @@ void Fl_OpenGL_Graphics_Driver::color(Fl_Color i) {
     Fl_Graphics_Driver::color(i);
     uchar red, green, blue;
     Fl::get_color(i, red, green, blue);
+    batch_color_[0] = red; batch_color_[1] = green; batch_color_[2] = blue;
     glColor3ub(red, green, blue);
   }
 }
 
 void Fl_OpenGL_Graphics_Driver::color(uchar r,uchar g,uchar b) {
   Fl_Graphics_Driver::color( fl_rgb_color(r, g, b) );
+  batch_color_[0] = r; batch_color_[1] = g; batch_color_[2] = b;
   glColor3ub(r,g,b);
 }
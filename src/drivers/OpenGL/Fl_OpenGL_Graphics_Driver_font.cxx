@@ -117,6 +117,7 @@ void Fl_OpenGL_Graphics_Driver::text_extents(const char *str, int n, int& dx, in
 
 void Fl_OpenGL_Graphics_Driver::draw(const char *str, int n, int x, int y)
 {
+  flush_vertices();
   int i;
   for (i=0; i<n; i++) {
     char c = str[i] & 0x7f;
@@ -179,6 +180,7 @@ void Fl_OpenGL_Graphics_Driver::font(Fl_Font face, Fl_Fontsize fsize) {
 }
 
 void Fl_OpenGL_Graphics_Driver::draw(const char* str, int n, int x, int y) {
+  flush_vertices();
   Fl_Surface_Device::push_current(Fl_Display_Device::display_device());
   gl_draw(str, n, x, y);
   Fl_Surface_Device::pop_current();
@@ -35,6 +35,9 @@ void Fl_OpenGL_Graphics_Driver::line_style(int style, int width, char* dashes) {
 
   if (width<1) width = 1;
 
+  // the stipple pattern applies when the pending lines are drawn
+  flush_vertices();
+  line_solid_ = (style==FL_SOLID);
   if (style==FL_SOLID) {
     glLineStipple(1, 0xFFFF);
     glDisable(GL_LINE_STIPPLE);
@@ -27,139 +27,152 @@
 #include <FL/Fl_Gl_Window.H>
 #include <FL/Fl_RGB_Image.H>
 #include <FL/Fl.H>
+#include <stdlib.h>
 
 // --- line and polygon drawing with integer coordinates
 
+// All primitives are added to the vertex batch (see
+// Fl_OpenGL_Graphics_Driver_batch.cxx). Rectangles and horizontal or
+// vertical solid lines become pairs of triangles, so that a typical widget
+// with its box, frame and focus box is drawn with a single draw call.
+
+// Adds a filled rectangle as two triangles. OpenGL has the natural origin
+// at the bottom left. Drawing in FLTK coordinates requires that we shift
+// the rectangle one pixel up.
+void Fl_OpenGL_Graphics_Driver::batch_rectf(int x, int y, int w, int h) {
+  Batch_Vertex *v = batch_add(GL_TRIANGLES, 6);
+  if (!v) return;
+  float l = (float)x, r = (float)(x+w), t = (float)(y-1), b = (float)(y+h-1);
+  batch_point(v,   l, t);
+  batch_point(v+1, r, t);
+  batch_point(v+2, r, b);
+  batch_point(v+3, l, t);
+  batch_point(v+4, r, b);
+  batch_point(v+5, l, b);
+}
+
+// Adds a line strip through n points, including its last point.
+void Fl_OpenGL_Graphics_Driver::batch_strip(int n, const int *p) {
+  int quad = 0;
+  for (int i = 1; i < n; i++, p += 2) {
+    int x = p[0], y = p[1], x1 = p[2], y1 = p[3];
+    quad = line_solid_ && (x == x1 || y == y1);
+    if (quad) {
+      batch_rectf(x < x1 ? x : x1, y < y1 ? y : y1, abs(x1-x)+1, abs(y1-y)+1);
+    } else {
+      Batch_Vertex *v = batch_add(GL_LINES, 2);
+      if (!v) return;
+      batch_point(v,   (float)x,  (float)y);
+      batch_point(v+1, (float)x1, (float)y1);
+    }
+  }
+  if (!quad) {
+    // OpenGL does not draw the last pixel of a line; add a one pixel segment
+    Batch_Vertex *v = batch_add(GL_LINES, 2);
+    if (!v) return;
+    batch_point(v,   (float)p[0],   (float)p[1]);
+    batch_point(v+1, (float)p[0]+1, (float)p[1]);
+  }
+}
+
 void Fl_OpenGL_Graphics_Driver::point(int x, int y) {
-  glBegin(GL_POINTS);
-  glVertex2i(x, y);
-  glEnd();
+  batch_rectf(x, y, 1, 1);
 }
 
 void Fl_OpenGL_Graphics_Driver::rect(int x, int y, int w, int h) {
-  glBegin(GL_LINE_LOOP);
-  glVertex2i(x, y);
-  glVertex2i(x+w, y);
-  glVertex2i(x+w, y+h);
-  glVertex2i(x, y+h);
-  glEnd();
+  if (w<=0 || h<=0) return;
+  int r = x+w-1, b = y+h-1;
+  if (line_solid_) {
+    batch_rectf(x, y, w, 1);
+    if (h > 1) batch_rectf(x, b, w, 1);
+    if (h > 2) {
+      batch_rectf(x, y+1, 1, h-2);
+      if (w > 1) batch_rectf(r, y+1, 1, h-2);
+    }
+  } else {
+    loop(x, y, r, y, r, b, x, b);
+  }
 }
 
 void Fl_OpenGL_Graphics_Driver::rectf(int x, int y, int w, int h) {
   if (w<=0 || h<=0) return;
-  // OpenGL has the natural origin at the bottom left. Drawing in FLTK
-  // coordinates requires that we shift the rectangle one pixel up.
-  glBegin(GL_POLYGON);
-  glVertex2i(x, y-1);
-  glVertex2i(x+w, y-1);
-  glVertex2i(x+w, y+h-1);
-  glVertex2i(x, y+h-1);
-  glEnd();
+  batch_rectf(x, y, w, h);
 }
 
 void Fl_OpenGL_Graphics_Driver::line(int x, int y, int x1, int y1) {
-  glBegin(GL_LINE_STRIP);
-  glVertex2i(x, y);
-  glVertex2i(x1, y1);
-  glEnd();
-  point(x1, y1);
+  int p[] = { x, y,  x1, y1 };
+  batch_strip(2, p);
 }
 
 void Fl_OpenGL_Graphics_Driver::line(int x, int y, int x1, int y1, int x2, int y2) {
-  glBegin(GL_LINE_STRIP);
-  glVertex2i(x, y);
-  glVertex2i(x1, y1);
-  glVertex2i(x2, y2);
-  glEnd();
-  point(x2, y2);
+  int p[] = { x, y,  x1, y1,  x2, y2 };
+  batch_strip(3, p);
 }
 
 void Fl_OpenGL_Graphics_Driver::xyline(int x, int y, int x1) {
-  glBegin(GL_LINE_STRIP);
-  glVertex2i(x, y);
-  glVertex2i(x1, y);
-  glEnd();
-  point(x1, y);
+  int p[] = { x, y,  x1, y };
+  batch_strip(2, p);
 }
 
 void Fl_OpenGL_Graphics_Driver::xyline(int x, int y, int x1, int y2) {
-  glBegin(GL_LINE_STRIP);
-  glVertex2i(x, y);
-  glVertex2i(x1, y);
-  glVertex2i(x1, y2);
-  glEnd();
-  point(x1, y2);
+  int p[] = { x, y,  x1, y,  x1, y2 };
+  batch_strip(3, p);
 }
 
 void Fl_OpenGL_Graphics_Driver::xyline(int x, int y, int x1, int y2, int x3) {
-  glBegin(GL_LINE_STRIP);
-  glVertex2i(x, y);
-  glVertex2i(x1, y);
-  glVertex2i(x1, y2);
-  glVertex2i(x3, y2);
-  glEnd();
-  point(x3, y2);
+  int p[] = { x, y,  x1, y,  x1, y2,  x3, y2 };
+  batch_strip(4, p);
 }
 
 void Fl_OpenGL_Graphics_Driver::yxline(int x, int y, int y1) {
-  glBegin(GL_LINE_STRIP);
-  glVertex2i(x, y);
-  glVertex2i(x, y1);
-  glEnd();
-  point(x, y1);
+  int p[] = { x, y,  x, y1 };
+  batch_strip(2, p);
 }
 
 void Fl_OpenGL_Graphics_Driver::yxline(int x, int y, int y1, int x2) {
-  glBegin(GL_LINE_STRIP);
-  glVertex2i(x, y);
-  glVertex2i(x, y1);
-  glVertex2i(x2, y1);
-  glEnd();
-  point(x2, y1);
+  int p[] = { x, y,  x, y1,  x2, y1 };
+  batch_strip(3, p);
 }
 
 void Fl_OpenGL_Graphics_Driver::yxline(int x, int y, int y1, int x2, int y3) {
-  glBegin(GL_LINE_STRIP);
-  glVertex2i(x, y);
-  glVertex2i(x, y1);
-  glVertex2i(x2, y1);
-  glVertex2i(x2, y3);
-  glEnd();
-  point(x2, y3);
+  int p[] = { x, y,  x, y1,  x2, y1,  x2, y3 };
+  batch_strip(4, p);
 }
 
 void Fl_OpenGL_Graphics_Driver::loop(int x0, int y0, int x1, int y1, int x2, int y2) {
-  glBegin(GL_LINE_LOOP);
-  glVertex2i(x0, y0);
-  glVertex2i(x1, y1);
-  glVertex2i(x2, y2);
-  glEnd();
+  Batch_Vertex *v = batch_add(GL_LINES, 6);
+  if (!v) return;
+  batch_point(v,   (float)x0, (float)y0); batch_point(v+1, (float)x1, (float)y1);
+  batch_point(v+2, (float)x1, (float)y1); batch_point(v+3, (float)x2, (float)y2);
+  batch_point(v+4, (float)x2, (float)y2); batch_point(v+5, (float)x0, (float)y0);
 }
 
 void Fl_OpenGL_Graphics_Driver::loop(int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3) {
-  glBegin(GL_LINE_LOOP);
-  glVertex2i(x0, y0);
-  glVertex2i(x1, y1);
-  glVertex2i(x2, y2);
-  glVertex2i(x3, y3);
-  glEnd();
+  Batch_Vertex *v = batch_add(GL_LINES, 8);
+  if (!v) return;
+  batch_point(v,   (float)x0, (float)y0); batch_point(v+1, (float)x1, (float)y1);
+  batch_point(v+2, (float)x1, (float)y1); batch_point(v+3, (float)x2, (float)y2);
+  batch_point(v+4, (float)x2, (float)y2); batch_point(v+5, (float)x3, (float)y3);
+  batch_point(v+6, (float)x3, (float)y3); batch_point(v+7, (float)x0, (float)y0);
 }
 
 void Fl_OpenGL_Graphics_Driver::polygon(int x0, int y0, int x1, int y1, int x2, int y2) {
-  glBegin(GL_POLYGON);
-  glVertex2i(x0, y0);
-  glVertex2i(x1, y1);
-  glVertex2i(x2, y2);
-  glEnd();
+  Batch_Vertex *v = batch_add(GL_TRIANGLES, 3);
+  if (!v) return;
+  batch_point(v,   (float)x0, (float)y0);
+  batch_point(v+1, (float)x1, (float)y1);
+  batch_point(v+2, (float)x2, (float)y2);
 }
 
 void Fl_OpenGL_Graphics_Driver::polygon(int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3) {
-  glBegin(GL_POLYGON);
-  glVertex2i(x0, y0);
-  glVertex2i(x1, y1);
-  glVertex2i(x2, y2);
-  glVertex2i(x3, y3);
-  glEnd();
+  Batch_Vertex *v = batch_add(GL_TRIANGLES, 6);
+  if (!v) return;
+  batch_point(v,   (float)x0, (float)y0);
+  batch_point(v+1, (float)x1, (float)y1);
+  batch_point(v+2, (float)x2, (float)y2);
+  batch_point(v+3, (float)x0, (float)y0);
+  batch_point(v+4, (float)x2, (float)y2);
+  batch_point(v+5, (float)x3, (float)y3);
 }
 
 void Fl_OpenGL_Graphics_Driver::push_clip(int x, int y, int w, int h) {
@@ -40,58 +40,81 @@
 // double Fl_OpenGL_Graphics_Driver::transform_dx(double x, double y)
 // double Fl_OpenGL_Graphics_Driver::transform_dy(double x, double y)
 
+// The vertices of points, lines and polygons are added to the vertex batch
+// by transformed_vertex(). Lines are split into segments, and polygons
+// into a fan of triangles, which is what OpenGL does with GL_POLYGON.
+
 void Fl_OpenGL_Graphics_Driver::begin_points() {
-  glBegin(GL_POINTS);
+  what = POINT_; n = 0;
 }
 
-void Fl_OpenGL_Graphics_Driver::end_points() {
-  glEnd();
-}
+void Fl_OpenGL_Graphics_Driver::end_points() { }
 
 void Fl_OpenGL_Graphics_Driver::begin_line() {
-  glBegin(GL_LINE_STRIP);
+  what = LINE; n = 0;
 }
 
-void Fl_OpenGL_Graphics_Driver::end_line() {
-  glEnd();
-}
+void Fl_OpenGL_Graphics_Driver::end_line() { }
 
 void Fl_OpenGL_Graphics_Driver::begin_loop() {
-  glBegin(GL_LINE_LOOP);
+  what = LOOP; n = 0;
 }
 
 void Fl_OpenGL_Graphics_Driver::end_loop() {
-  glEnd();
+  Batch_Vertex *v;
+  if (n > 1 && (v = batch_add(GL_LINES, 2))) {
+    batch_point(v,   prev_[0],  prev_[1]);
+    batch_point(v+1, first_[0], first_[1]);
+  }
+  n = 0;
 }
 
 void Fl_OpenGL_Graphics_Driver::begin_polygon() {
-  glBegin(GL_POLYGON);
+  what = POLYGON; n = 0;
 }
 
-void Fl_OpenGL_Graphics_Driver::end_polygon() {
-  glEnd();
-}
+void Fl_OpenGL_Graphics_Driver::end_polygon() { }
 
 void Fl_OpenGL_Graphics_Driver::begin_complex_polygon() {
-  glBegin(GL_POLYGON);
+  what = POLYGON; n = 0;
 }
 
 void Fl_OpenGL_Graphics_Driver::gap() {
-  glEnd();
-  glBegin(GL_POLYGON);
+  n = 0;
 }
 
 // FXIME: non-convex polygons are not supported yet
 // use gluTess* functions to do this; search for gluBeginPolygon
-void Fl_OpenGL_Graphics_Driver::end_complex_polygon() {
-  glEnd();
-}
+void Fl_OpenGL_Graphics_Driver::end_complex_polygon() { }
 
 // remove equal points from closed path
 void Fl_OpenGL_Graphics_Driver::fixloop() { }
 
 void Fl_OpenGL_Graphics_Driver::transformed_vertex(double xf, double yf) {
-  glVertex2d(xf, yf);
+  float x = (float)xf, y = (float)yf;
+  Batch_Vertex *v;
+  switch (what) {
+    case POINT_:
+      if ((v = batch_add(GL_POINTS, 1))) batch_point(v, x, y);
+      break;
+    case LINE:
+    case LOOP:
+      if (n > 0 && (v = batch_add(GL_LINES, 2))) {
+        batch_point(v,   prev_[0], prev_[1]);
+        batch_point(v+1, x, y);
+      }
+      break;
+    case POLYGON:
+      if (n > 1 && (v = batch_add(GL_TRIANGLES, 3))) {
+        batch_point(v,   first_[0], first_[1]);
+        batch_point(v+1, prev_[0], prev_[1]);
+        batch_point(v+2, x, y);
+      }
+      break;
+  }
+  if (n == 0) { first_[0] = x; first_[1] = y; }
+  prev_[0] = x; prev_[1] = y;
+  n++;
 }
 
 void Fl_OpenGL_Graphics_Driver::vertex(double x,double y) {
@@ -112,7 +135,13 @@ void Fl_OpenGL_Graphics_Driver::circle(double cx, double cy, double r) {
   double x = r; //we start at angle = 0
   double y = 0;
 
-  glBegin(GL_LINE_LOOP);
+  // The circle is a closed contour of its own in the current shape: it is
+  // filled in a polygon and outlined otherwise. The state of the enclosing
+  // shape is restored afterwards, so vertices around fl_circle() still
+  // connect as before.
+  int save_n = n;
+  float save_first[2] = { first_[0], first_[1] }, save_prev[2] = { prev_[0], prev_[1] };
+  n = 0;
   for(int ii = 0; ii < num_segments; ii++) {
     vertex(x + cx, y + cy); // output vertex
     double tx = -y;
@@ -122,6 +151,13 @@ void Fl_OpenGL_Graphics_Driver::circle(double cx, double cy, double r) {
     x *= radial_factor;
     y *= radial_factor;
   }
-  glEnd();
+  Batch_Vertex *v;
+  if ((what == LINE || what == LOOP) && n > 1 && (v = batch_add(GL_LINES, 2))) {
+    batch_point(v,   prev_[0],  prev_[1]);
+    batch_point(v+1, first_[0], first_[1]);
+  }
+  n = save_n;
+  first_[0] = save_first[0]; first_[1] = save_first[1];
+  prev_[0] = save_prev[0]; prev_[1] = save_prev[1];
 
 }
@@ -19,11 +19,25 @@
 #include "Fl_Pico_Graphics_Driver.H"
 #include <FL/fl_draw.H>
 #include <FL/math.h>
+#include <stdlib.h>
 
 
 static int sign(int x) { return (x>0)-(x<0); }
 
 
+Fl_Pico_Graphics_Driver::Fl_Pico_Graphics_Driver()
+{
+  edges_ = 0;
+  edges_n_ = edges_alloc_ = 0;
+}
+
+
+Fl_Pico_Graphics_Driver::~Fl_Pico_Graphics_Driver()
+{
+  free(edges_);
+}
+
+
 void Fl_Pico_Graphics_Driver::point(int x, int y)
 {
   // This is the one method that *must* be overridden in the final driver
@@ -44,13 +58,24 @@ void Fl_Pico_Graphics_Driver::rect(int x, int y, int w, int h)
 
 void Fl_Pico_Graphics_Driver::rectf(int x, int y, int w, int h)
 {
-  int i = y, n = y+h, xn = x+w-1;
-  for ( ; i<n; i++) {
-    xyline(x, i, xn);
+  // Lines, polygons and text are drawn as spans of pixels with this method.
+  int i, j;
+  for (j=y; j<y+h; j++) {
+    for (i=x; i<x+w; i++) {
+      point(i, j);
+    }
   }
 }
 
 
+// Draws 'len' pixels of a line starting at x, y in direction dx, dy.
+static void line_run(Fl_Graphics_Driver *d, int x, int y, int len, int dx, int dy)
+{
+  if (dx) d->rectf(dx>0 ? x : x-len+1, y, len, 1);
+  else    d->rectf(x, dy>0 ? y : y-len+1, 1, len);
+}
+
+
 void Fl_Pico_Graphics_Driver::line(int x, int y, int x1, int y1)
 {
   if (x==x1) {
@@ -73,19 +98,23 @@ void Fl_Pico_Graphics_Driver::line(int x, int y, int x1, int y1)
     dx2 = dx1;
     dy2 = 0;
   }
-  int num = max/2;
+  // pixels in the major direction are collected and drawn as one span
+  int num = max/2, len = 0, rx = x, ry = y;
   for (int i=max+1; i>0; i--) {
-    point(x, y);
+    len++;
     num += min;
     if (num>=max) {
       num -= max;
+      line_run(this, rx, ry, len, dx2 ? dx1 : 0, dy2 ? dy1 : 0);
       x += dx1;
       y += dy1;
+      rx = x; ry = y; len = 0;
     } else {
       x += dx2;
       y += dy2;
     }
   }
+  if (len) line_run(this, rx, ry, len, dx2 ? dx1 : 0, dy2 ? dy1 : 0);
 }
 
 
@@ -98,13 +127,10 @@ void Fl_Pico_Graphics_Driver::line(int x, int y, int x1, int y1, int x2, int y2)
 
 void Fl_Pico_Graphics_Driver::xyline(int x, int y, int x1)
 {
-  int i;
   if (x1<x) {
     int tmp = x; x = x1; x1 = tmp;
   }
-  for (i=x; i<=x1; i++) {
-    point(i, y);
-  }
+  rectf(x, y, x1-x+1, 1);
 }
 
 
@@ -125,13 +151,10 @@ void Fl_Pico_Graphics_Driver::xyline(int x, int y, int x1, int y2, int x3)
 
 void Fl_Pico_Graphics_Driver::yxline(int x, int y, int y1)
 {
-  int i;
   if (y1<y) {
     int tmp = y; y = y1; y1 = tmp;
   }
-  for (i=y; i<=y1; i++) {
-    point(x, i);
-  }
+  rectf(x, y, 1, y1-y+1);
 }
 
 
@@ -169,20 +192,73 @@ void Fl_Pico_Graphics_Driver::loop(int x0, int y0, int x1, int y1, int x2, int y
 
 void Fl_Pico_Graphics_Driver::polygon(int x0, int y0, int x1, int y1, int x2, int y2)
 {
-  // FIXME: fill
-  line(x0, y0, x1, y1);
-  line(x1, y1, x2, y2);
-  line(x2, y2, x0, y0);
+  add_edge(x0, y0, x1, y1);
+  add_edge(x1, y1, x2, y2);
+  add_edge(x2, y2, x0, y0);
+  fill_edges();
 }
 
 
 void Fl_Pico_Graphics_Driver::polygon(int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3)
 {
-  // FIXME: fill
-  line(x0, y0, x1, y1);
-  line(x1, y1, x2, y2);
-  line(x2, y2, x3, y3);
-  line(x3, y3, x0, y0);
+  add_edge(x0, y0, x1, y1);
+  add_edge(x1, y1, x2, y2);
+  add_edge(x2, y2, x3, y3);
+  add_edge(x3, y3, x0, y0);
+  fill_edges();
+}
+
+
+// Adds an edge to the polygon that is filled by fill_edges().
+void Fl_Pico_Graphics_Driver::add_edge(double x0, double y0, double x1, double y1)
+{
+  if (y0==y1) return; // horizontal edges never cross the center of a pixel row
+  if (edges_n_==edges_alloc_) {
+    edges_alloc_ = edges_alloc_ ? 2*edges_alloc_ : 32;
+    edges_ = (double*)realloc(edges_, 4*edges_alloc_*sizeof(double));
+  }
+  double *e = edges_ + 4*edges_n_++;
+  if (y0<y1) {
+    e[0] = x0; e[1] = y0; e[2] = x1; e[3] = y1;
+  } else {
+    e[0] = x1; e[1] = y1; e[2] = x0; e[3] = y0;
+  }
+}
+
+
+// Fills the polygon made of all edges added by add_edge() with the even-odd
+// rule, one row of pixels at a time. A pixel is filled if its center is
+// inside the polygon, so that a polygon with the corners of a rectangle
+// covers the same pixels as rectf().
+void Fl_Pico_Graphics_Driver::fill_edges()
+{
+  if (!edges_n_) return;
+  double ymin = edges_[1], ymax = edges_[3];
+  int i, j;
+  for (i=1; i<edges_n_; i++) {
+    if (edges_[4*i+1]<ymin) ymin = edges_[4*i+1];
+    if (edges_[4*i+3]>ymax) ymax = edges_[4*i+3];
+  }
+  double *xs = (double*)malloc(edges_n_*sizeof(double));
+  int y, y1 = (int)ceil(ymax-0.5);
+  for (y=(int)ceil(ymin-0.5); y<y1; y++) {
+    double yc = y + 0.5;
+    int n = 0;
+    for (i=0; i<edges_n_; i++) {
+      const double *e = edges_ + 4*i;
+      if (e[1]<=yc && yc<e[3]) {
+        double x = e[0] + (yc-e[1]) * (e[2]-e[0]) / (e[3]-e[1]);
+        for (j=n++; j>0 && xs[j-1]>x; j--) xs[j] = xs[j-1];
+        xs[j] = x;
+      }
+    }
+    for (i=0; i+1<n; i+=2) {
+      int xa = (int)ceil(xs[i]-0.5), xb = (int)ceil(xs[i+1]-0.5);
+      if (xb>xa) rectf(xa, y, xb-xa, 1);
+    }
+  }
+  free(xs);
+  edges_n_ = 0;
 }
 
 
@@ -256,12 +332,13 @@ void Fl_Pico_Graphics_Driver::begin_polygon()
 
 void Fl_Pico_Graphics_Driver::transformed_vertex(double x, double y)
 {
-  if (pn>0) {
+  if (what==POINT_) {
+    point(x, y);
+  } else if (pn>0) {
     switch (what) {
-      case POINT_:  point(x, y); break;
       case LINE:    line(px, py, x, y); break;
       case LOOP:    line(px, py, x, y); break;
-      case POLYGON: line(px, py, x, y); break; // FIXME: fill!
+      case POLYGON: add_edge(px, py, x, y); break;
     }
   }
   if (pn==0 ) { pxf = x; pyf = y; }
@@ -297,20 +374,21 @@ void Fl_Pico_Graphics_Driver::end_loop()
 
 void Fl_Pico_Graphics_Driver::end_polygon()
 {
-  line(px, py, pxf, pyf);  // FIXME: fill!
-  pn = 0;
+  gap();
+  fill_edges();
 }
 
 
 void Fl_Pico_Graphics_Driver::end_complex_polygon()
 {
-  line(px, py, pxf, pyf);  // FIXME: fill!
-  pn = 0;
+  gap();
+  fill_edges();
 }
 
 
 void Fl_Pico_Graphics_Driver::gap()
 {
+  if (what==POLYGON && pn>1) add_edge(px, py, pxf, pyf);
   pn = 0;
 }
 
@@ -363,21 +441,44 @@ void Fl_Pico_Graphics_Driver::arc(int xi, int yi, int w, int h, double a1, doubl
   a2 = a2/180*M_PI;
   double step = (a2-a1)/segs;
 
-  int nx = x + sin(a1)*rx;
-  int ny = y - cos(a1)*ry;
+  int nx = x + cos(a1)*rx;
+  int ny = y - sin(a1)*ry;
   for (i=segs; i>0; i--) {
     a1+=step;
     px = nx; py = ny;
-    nx = x + sin(a1)*rx;
-    ny = y - cos(a1)*ry;
+    nx = x + cos(a1)*rx;
+    ny = y - sin(a1)*ry;
     line(px, py, nx, ny);
   }
 }
 
 
-void Fl_Pico_Graphics_Driver::pie(int x, int y, int w, int h, double a1, double a2)
+void Fl_Pico_Graphics_Driver::pie(int xi, int yi, int w, int h, double a1, double a2)
 {
-  // FIXME: implement this
+  if (a2<=a1 || w<=0 || h<=0) return;
+
+  double rx = w/2.0;
+  double ry = h/2.0;
+  double x = xi + rx;
+  double y = yi + ry;
+  double circ = M_PI*0.5*(rx+ry);
+  int i, segs = circ * (a2-a1) / 1000;  // every line is about three pixels long
+  if (segs<3) segs = 3;
+
+  a1 = a1/180*M_PI;
+  a2 = a2/180*M_PI;
+  double step = (a2-a1)/segs;
+
+  double px = x, py = y;
+  for (i=segs; i>=0; i--) {
+    double nx = x + cos(a1)*rx;
+    double ny = y - sin(a1)*ry;
+    add_edge(px, py, nx, ny);
+    px = nx; py = ny;
+    a1+=step;
+  }
+  add_edge(px, py, x, y);
+  fill_edges();
 }
 
 
@@ -469,36 +570,123 @@ int Fl_Pico_Graphics_Driver::height() {
 }
 
 
+/*
+ Text is drawn from a cache of rendered glyphs. Each glyph is stored as a
+ list of horizontal runs of pixels, relative to the text origin, so that a
+ character is drawn with a few rectf() calls instead of rasterizing all of
+ its strokes again.
+ */
+
+struct Pico_Glyph {
+  int size;     // font size, 0 if the cache entry is unused
+  char c;       // the character
+  int n;        // number of runs
+  int *runs;    // x, y and length of each run
+};
+
+static Pico_Glyph glyph_cache[256];
+
+
+// Sets the pixels of a stroke in the bitmap the same way line() would draw it.
+static void glyph_stroke(uchar *bits, int bw, int x, int y, int x1, int y1)
+{
+  int w = x1 - x, dx = abs(w);
+  int h = y1 - y, dy = abs(h);
+  int dx1 = sign(w), dy1 = sign(h), dx2, dy2;
+  int min, max;
+  if (dx < dy) {
+    min = dx; max = dy;
+    dx2 = 0;
+    dy2 = dy1;
+  } else {
+    min = dy; max = dx;
+    dx2 = dx1;
+    dy2 = 0;
+  }
+  int num = max/2;
+  for (int i=max+1; i>0; i--) {
+    bits[y*bw+x] = 1;
+    num += min;
+    if (num>=max) {
+      num -= max;
+      x += dx1;
+      y += dy1;
+    } else {
+      x += dx2;
+      y += dy2;
+    }
+  }
+}
+
+
+// Returns the glyph of character c in the given size, rendering it if needed.
+static const Pico_Glyph *glyph(char c, int size)
+{
+  Pico_Glyph *g = glyph_cache + ((c * 7 + size * 131) & 255);
+  if (g->size==size && g->c==c) return g;
+
+  // collect the stroke points, 0x7fff marks the start of a new stroke
+  const char *fd = font_data[(int)c];
+  int pts[2*64], np = 0, i;
+  int xmin = 0, ymin = 0, xmax = 0, ymax = 0;
+  for (;;) {
+    char cmd = *fd++;
+    if (cmd==0) break;
+    if (cmd>63) {
+      if (cmd=='\100' && np && pts[2*np-2]!=0x7fff) { pts[2*np] = pts[2*np+1] = 0x7fff; np++; }
+      continue;
+    }
+    int vx = (cmd & '\70')>>3;
+    int vy = (cmd & '\07');
+    int px = (int)floor(0.5+vx*size*0.5/8.0);
+    int py = (int)floor(0.5+vy*size/8.0-0.8*size);
+    if (np==0 || px<xmin) xmin = px;
+    if (np==0 || px>xmax) xmax = px;
+    if (np==0 || py<ymin) ymin = py;
+    if (np==0 || py>ymax) ymax = py;
+    pts[2*np] = px; pts[2*np+1] = py; np++;
+  }
+
+  // rasterize the strokes into a bitmap and convert its rows into runs
+  int bw = xmax-xmin+1, bh = ymax-ymin+1;
+  uchar *bits = (uchar*)calloc(bw*bh, 1);
+  for (i=1; i<np; i++) {
+    const int *p = pts + 2*i;
+    if (p[0]==0x7fff || p[-2]==0x7fff) continue;
+    glyph_stroke(bits, bw, p[-2]-xmin, p[-1]-ymin, p[0]-xmin, p[1]-ymin);
+  }
+  int n = 0, x, y;
+  for (i=0; i<bw*bh; i++) if (bits[i] && (i%bw==0 || !bits[i-1])) n++;
+  free(g->runs);
+  g->runs = (int*)malloc(3*n*sizeof(int));
+  g->n = 0;
+  for (y=0; y<bh; y++) {
+    const uchar *row = bits + y*bw;
+    for (x=0; x<bw; x++) {
+      if (!row[x]) continue;
+      int x0 = x;
+      while (x<bw && row[x]) x++;
+      int *r = g->runs + 3*g->n++;
+      r[0] = x0+xmin; r[1] = y+ymin; r[2] = x-x0;
+    }
+  }
+  free(bits);
+  g->size = size;
+  g->c = c;
+  return g;
+}
+
+
 void Fl_Pico_Graphics_Driver::draw(const char *str, int n, int x, int y)
 {
   int i;
   for (i=0; i<n; i++) {
     char c = str[i] & 0x7f;
-    const char *fd = font_data[(int)c];
-    if (fd) {
-      char rendering = 0;
-      float px=0.0f, py=0.0f;
-      for (;;) {
-        char cmd = *fd++;
-        if (cmd==0) {
-          if (rendering) {
-            end_line();
-            rendering = 0;
-          }
-          break;
-        } else if (cmd>63) {
-          if (cmd=='\100' && rendering) {
-            end_line();
-            rendering = 0;
-          }
-        } else {
-          if (!rendering) { begin_line(); rendering = 1; }
-          int vx = (cmd & '\70')>>3;
-          int vy = (cmd & '\07');
-          px = (int)(0.5+x+vx*size_*0.5/8.0);
-          py = (int)(0.5+y+vy*size_/8.0-0.8*size_);
-          vertex(px, py);
-        }
+    if (font_data[(int)c]) {
+      const Pico_Glyph *g = glyph(c, size_);
+      const int *r = g->runs;
+      for (int j=g->n; j>0; j--, r+=3) {
+        rectf(x+r[0], y+r[1], r[2], 1);
       }
     }
     x += size_*0.5;
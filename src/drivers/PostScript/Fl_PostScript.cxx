@@ -24,6 +24,7 @@
 #include <FL/Fl_Native_File_Chooser.H>
 #include "../../Fl_System_Driver.H"
 #include <FL/fl_string.h>
+#include "../../flstring.h"
 #include <stdarg.h>
 #include <time.h>
 
@@ -127,9 +128,19 @@ Fl_PostScript_File_Device::~Fl_PostScript_File_Device() {
 
 int Fl_PostScript_Graphics_Driver::clocale_printf(const char *format, ...)
 {
+  // Format the numbers without switching the locale when possible,
+  // otherwise let the system driver do it
+  char buffer[512];
   va_list args;
   va_start(args, format);
-  int retval = Fl::system_driver()->clocale_printf(output, format, args);
+  int retval = fl_clocale_vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  if (retval >= 0) {
+    fwrite(buffer, retval, 1, output);
+    return retval;
+  }
+  va_start(args, format);
+  retval = Fl::system_driver()->clocale_printf(output, format, args);
   va_end(args);
   return retval;
 }
@@ -1091,10 +1102,7 @@ void Fl_PostScript_Graphics_Driver::transformed_draw_extra(const char* str, int
   void *rle85 = prepare_rle85();
   for (int j = h - 1; j >= 0; j--){
     di = img_mask + j * wmask;
-    for (int i = 0; i < wmask; i++){
-      write_rle85(*di, rle85);
-      di++;
-    }
+    write_rle85(di, wmask, rle85);
   }
   close_rle85(rle85); fputc('\n', output);
   delete[] img_mask;
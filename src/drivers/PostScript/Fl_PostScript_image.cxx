@@ -72,19 +72,31 @@ void Fl_PostScript_Graphics_Driver::write85(void *data, const uchar *p, int len)
 {
   struct85 *big = (struct85 *)data;
   const uchar *last = p + len;
+  uchar out[1024]; // the output is collected here and written in one call
+  int n = 0;
   while (p < last) {
-    int c = 4 - big->l4;
-    if (last-p < c) c = last-p;
-    memcpy(big->bytes4 + big->l4, p, c);
-    p += c;
-    big->l4 += c;
-    if (big->l4 == 4) {
-      c = convert85(big->bytes4, big->chars5);
-      fwrite(big->chars5, c, 1, output);
+    const uchar *bytes4;
+    if (big->l4 == 0 && last - p >= 4) { // encode directly from the input
+      bytes4 = p;
+      p += 4;
+    } else {
+      int c = 4 - big->l4;
+      if (last-p < c) c = last-p;
+      memcpy(big->bytes4 + big->l4, p, c);
+      p += c;
+      big->l4 += c;
+      if (big->l4 < 4) break;
+      bytes4 = big->bytes4;
       big->l4 = 0;
-      if (++big->blocks >= 16) { fputc('\n', output); big->blocks = 0; }
+    }
+    n += convert85(bytes4, out + n);
+    if (++big->blocks >= 16) { out[n++] = '\n'; big->blocks = 0; }
+    if (n > (int)sizeof(out) - 6) {
+      fwrite(out, n, 1, output);
+      n = 0;
     }
   }
+  if (n) fwrite(out, n, 1, output);
 }
 
 
@@ -130,39 +142,54 @@ void *Fl_PostScript_Graphics_Driver::prepare_rle85() // prepare to produce RLE+A
 
 
 void Fl_PostScript_Graphics_Driver::write_rle85(uchar b, void *data) // sends one input byte to RLE+ASCII85 encoding
+{
+  write_rle85(&b, 1, data);
+}
+
+
+void Fl_PostScript_Graphics_Driver::write_rle85(const uchar *p, int len, void *data) // sends len input bytes to RLE+ASCII85 encoding
 {
   struct_rle85 *rle = (struct_rle85 *)data;
+  const uchar *last = p + len;
   uchar c;
-  if (rle->run_length > 0) { // if within a run
-    if (b == rle->buffer[0] &&  rle->run_length < 128) { // the run can be extended
-      rle->run_length++;
-      return;
-    } else { // output the run
-      c = (uchar)(257 - rle->run_length);
-      write85(rle->data85, &c, 1); // the run-length info
-      write85(rle->data85, rle->buffer, 1); // the byte of the run
-      rle->run_length = 0;
+  while (p < last) {
+    uchar b = *p++;
+    if (rle->run_length > 0) { // if within a run
+      if (b == rle->buffer[0] &&  rle->run_length < 128) { // the run can be extended
+        rle->run_length++;
+        while (p < last && *p == b && rle->run_length < 128) { // as far as possible
+          rle->run_length++;
+          p++;
+        }
+        continue;
+      } else { // output the run
+        c = (uchar)(257 - rle->run_length);
+        write85(rle->data85, &c, 1); // the run-length info
+        write85(rle->data85, rle->buffer, 1); // the byte of the run
+        rle->run_length = 0;
+      }
     }
-  }
-  if (rle->count >= 2 && b == rle->buffer[rle->count-1] && b == rle->buffer[rle->count-2]) {
-    // about to begin a run
-    if (rle->count > 2) { // there is non-run data before the run in the buffer
-      c = (uchar)(rle->count-2 - 1);
-      write85(rle->data85, &c, 1); // length of non-run data
-      write85(rle->data85, rle->buffer, rle->count-2); // non-run data
+    if (rle->count >= 2 && b == rle->buffer[rle->count-1] && b == rle->buffer[rle->count-2]) {
+      // about to begin a run
+      if (rle->count > 2) { // there is non-run data before the run in the buffer
+        c = (uchar)(rle->count-2 - 1);
+        write85(rle->data85, &c, 1); // length of non-run data
+        write85(rle->data85, rle->buffer, rle->count-2); // non-run data
+      }
+      rle->run_length = 3;
+      rle->buffer[0] = b;
+      rle->count = 0;
+      continue;
     }
-    rle->run_length = 3;
-    rle->buffer[0] = b;
-    rle->count = 0;
-    return;
-  }
-  if (rle->count >= 128) { // the non-run buffer is full, output it
-    c = (uchar)(rle->count - 1);
-    write85(rle->data85, &c, 1); // length of non-run data
-    write85(rle->data85, rle->buffer, rle->count); // non-run data
-    rle->count = 0;
+    if (rle->count >= 128) { // the non-run buffer is full, output it
+      uchar block[129];
+      block[0] = (uchar)(rle->count - 1); // length of non-run data
+      memcpy(block + 1, rle->buffer, rle->count); // non-run data
+      write85(rle->data85, block, rle->count + 1);
+      rle->count = 0;
+    }
+    rle->buffer[rle->count++] = b; // add byte to end of non-run buffer
   }
-  rle->buffer[rle->count++] = b; // add byte to end of non-run buffer
 }
 
 
@@ -346,6 +373,12 @@ static inline uchar swap_byte(const uchar b) {
 }
 
 
+// bitwise inversion of n bytes of mask data
+static void swap_bytes(const uchar *from, int n, uchar *to) {
+  for (int i = 0; i < n; i++) to[i] = swap_byte(from[i]);
+}
+
+
 struct callback_data {
   const uchar *data;
   int D, LD;
@@ -406,27 +439,30 @@ void Fl_PostScript_Graphics_Driver::draw_image(Fl_Draw_Image_Cb call, void *data
 
   int LD=iw*D;
   uchar *rgbdata=new uchar[LD];
+  uchar *row = new uchar[iw * 3]; // the RGB data of a row, then sent in one call
+  int mask_ld = (mx+7)/8; // mask line width in bytes
+  uchar *mask_row = mask ? new uchar[mask_ld] : NULL;
   uchar *curmask=mask;
   void *big = prepare_rle85();
 
   if (level2_mask) {
     for (j = ih - 1; j >= 0; j--) { // output full image data
       call(data, 0, j, iw, rgbdata);
-      uchar *curdata = rgbdata;
+      uchar *curdata = rgbdata, *q = row;
       for (i=0 ; i<iw ; i++) {
-        write_rle85(curdata[0], big); write_rle85(curdata[1], big); write_rle85(curdata[2], big);
+        *q++ = curdata[0]; *q++ = curdata[1]; *q++ = curdata[2];
         curdata += D;
       }
+      write_rle85(row, iw * 3, big);
     }
     close_rle85(big); fputc('\n', output);
     big = prepare_rle85();
     for (j = ih - 1; j >= 0; j--) { // output mask data
-      curmask = mask + j * (my/ih) * ((mx+7)/8);
+      curmask = mask + j * (my/ih) * mask_ld;
       for (k=0; k < my/ih; k++) {
-        for (i=0; i < ((mx+7)/8); i++) {
-          write_rle85(swap_byte(*curmask), big);
-          curmask++;
-        }
+        swap_bytes(curmask, mask_ld, mask_row);
+        write_rle85(mask_row, mask_ld, big);
+        curmask += mask_ld;
       }
     }
   }
@@ -434,14 +470,17 @@ void Fl_PostScript_Graphics_Driver::draw_image(Fl_Draw_Image_Cb call, void *data
     for (j=0; j<ih;j++) {
       if (mask && lang_level_ > 2) {  // InterleaveType 2 mask data
         for (k=0; k<my/ih;k++) { //for alpha pseudo-masking
-          for (i=0; i<((mx+7)/8);i++) {
-            write_rle85(swap_byte(*curmask), big);
-            curmask++;
-          }
+          swap_bytes(curmask, mask_ld, mask_row);
+          write_rle85(mask_row, mask_ld, big);
+          curmask += mask_ld;
         }
       }
       call(data,0,j,iw,rgbdata);
-      uchar *curdata=rgbdata;
+      if (D == 3) { // the data can be sent as is
+        write_rle85(rgbdata, iw * 3, big);
+        continue;
+      }
+      uchar *curdata=rgbdata, *q = row;
       for (i=0 ; i<iw ; i++) {
         uchar r = curdata[0];
         uchar g =  curdata[1];
@@ -455,15 +494,17 @@ void Fl_PostScript_Graphics_Driver::draw_image(Fl_Draw_Image_Cb call, void *data
           b = (a2 * b + bg_b * a)/255;
         }
 
-        write_rle85(r, big); write_rle85(g, big); write_rle85(b, big);
+        *q++ = r; *q++ = g; *q++ = b;
         curdata +=D;
       }
-
+      write_rle85(row, iw * 3, big);
     }
   }
   close_rle85(big);
   fprintf(output,"\nrestore\n");
   delete[] rgbdata;
+  delete[] row;
+  delete[] mask_row;
 }
 
 void Fl_PostScript_Graphics_Driver::draw_image_mono(const uchar *data, int ix, int iy, int iw, int ih, int D, int LD) {
@@ -492,18 +533,24 @@ void Fl_PostScript_Graphics_Driver::draw_image_mono(const uchar *data, int ix, i
 
   int bg = (bg_r + bg_g + bg_b)/3;
 
+  uchar *row = new uchar[iw]; // the data of a row, then sent in one call
+  int mask_ld = (mx+7)/8; // mask line width in bytes
+  uchar *mask_row = mask ? new uchar[mask_ld] : NULL;
   uchar *curmask=mask;
   void *big = prepare_rle85();
   for (j=0; j<ih;j++){
     if (mask){
       for (k=0;k<my/ih;k++){
-        for (i=0; i<((mx+7)/8);i++){
-          write_rle85(swap_byte(*curmask), big);
-          curmask++;
-        }
+        swap_bytes(curmask, mask_ld, mask_row);
+        write_rle85(mask_row, mask_ld, big);
+        curmask += mask_ld;
       }
     }
     const uchar *curdata=data+j*LD;
+    if (D == 1) { // the data can be sent as is
+      write_rle85(curdata, iw, big);
+      continue;
+    }
     for (i=0 ; i<iw ; i++) {
       uchar r = curdata[0];
       if (lang_level_<3 && D>1) { //can do  mixing
@@ -512,13 +559,15 @@ void Fl_PostScript_Graphics_Driver::draw_image_mono(const uchar *data, int ix, i
         unsigned int a = 255-a2;
         r = (a2 * r + bg * a)/255;
       }
-      write_rle85(r, big);
+      row[i] = r;
       curdata +=D;
     }
-
+    write_rle85(row, iw, big);
   }
   close_rle85(big);
   fprintf(output,"restore\n");
+  delete[] row;
+  delete[] mask_row;
 }
 
 
@@ -541,28 +590,31 @@ void Fl_PostScript_Graphics_Driver::draw_image_mono(Fl_Draw_Image_Cb call, void
 
   int LD=iw*D;
   uchar *rgbdata=new uchar[LD];
+  int mask_ld = (mx+7)/8; // mask line width in bytes
+  uchar *mask_row = mask ? new uchar[mask_ld] : NULL;
   uchar *curmask=mask;
   void *big = prepare_rle85();
   for (j=0; j<ih;j++){
 
     if (mask && lang_level_>2){  // InterleaveType 2 mask data
       for (k=0; k<my/ih;k++){ //for alpha pseudo-masking
-        for (i=0; i<((mx+7)/8);i++){
-          write_rle85(swap_byte(*curmask), big);
-          curmask++;
-        }
+        swap_bytes(curmask, mask_ld, mask_row);
+        write_rle85(mask_row, mask_ld, big);
+        curmask += mask_ld;
       }
     }
     call(data,0,j,iw,rgbdata);
     uchar *curdata=rgbdata;
-    for (i=0 ; i<iw ; i++) {
-      write_rle85(curdata[0], big);
+    for (i=0 ; i<iw ; i++) { // keep the first byte of each pixel
+      rgbdata[i] = *curdata;
       curdata +=D;
     }
+    write_rle85(rgbdata, iw, big);
   }
   close_rle85(big);
   fprintf(output,"restore\n");
   delete[] rgbdata;
+  delete[] mask_row;
 }
 
 
@@ -603,15 +655,16 @@ void Fl_PostScript_Graphics_Driver::draw_bitmap(Fl_Bitmap * bitmap,int XP, int Y
   if (scale_for_image_(bitmap, XP, YP, WP, HP, cx, cy)) return;
   WP = bitmap->data_w(), HP = bitmap->data_h();
   const uchar * di = bitmap->array;
-  int i, j, xx = (WP+7)/8;
+  int j, xx = (WP+7)/8;
   fprintf(output , "%i %i %i %i %i %i MI\n", 0, HP, WP, -HP, WP, HP);
+  uchar *row = new uchar[xx];
   void *rle85 = prepare_rle85();
   for (j=0; j<HP; j++){
-    for (i=0; i<xx; i++){
-      write_rle85(swap_byte(*di), rle85);
-      di++;
-    }
+    swap_bytes(di, xx, row);
+    write_rle85(row, xx, rle85);
+    di += xx;
   }
+  delete[] row;
   close_rle85(rle85); fputc('\n', output);
   clocale_printf("GR GR\n");
   pop_clip(); // matches push_no_clip in scale_for_image_
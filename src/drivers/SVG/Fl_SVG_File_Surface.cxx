@@ -29,6 +29,8 @@
 #include <FL/Fl_Pixmap.H>
 #include <FL/Fl_Bitmap.H>
 #include <FL/fl_string.h>
+#include "../../flstring.h"
+#include <stdarg.h>
 
 extern "C" {
 #if defined(HAVE_LIBPNG)
@@ -64,15 +66,32 @@ class Fl_SVG_Graphics_Driver : public Fl_Graphics_Driver {
   };
   Clip * clip_; // top of pile of clips
   int clip_count_; // to generate distinct SVG clip Ids
-  char *last_rgb_name_; // NULL or SVG Id of last defined RGB image
+  class Image_Def {
+  public:
+    unsigned hash1, hash2; // two hashes of the pixel data
+    int w, h, data_w, data_h, d; // size and depth of the image
+    uchar *pixels; // copy of the pixel data, compared when the hashes match
+  };
+  Image_Def *images_; // images already defined in the SVG file, Id is "FLimg<index>"
+  int image_count_, image_alloc_;
+  int unlisted_images_; // images defined but not in images_, for lack of memory
+  char *path_; // data of the path made of consecutive strokes or fills of same style
+  int path_len_, path_size_;
+  char path_kind_; // 0, 'S' if path_ holds strokes, 'F' if it holds fills, 'P' for a polygon
   const char *family_;
   const char *bold_;
   const char *style_;
 public:
   Fl_SVG_Graphics_Driver(FILE*);
   ~Fl_SVG_Graphics_Driver();
-  FILE* file() {return out_;}
+  FILE* file() {flush_path(); return out_;}
+  int clocale_printf(const char *format, ...);
+  int compression_level_; // of PNG images, -1 for the default of zlib
 protected:
+  void path_printf(char kind, const char *format, ...);
+  void flush_path();
+  int image_name(Fl_RGB_Image *rgb, char *name);
+  void use_rgb(Fl_RGB_Image *rgb, int XP, int YP, int WP, int HP, int cx, int cy, bool jpeg);
   void rect(int x, int y, int w, int h);
   void rectf(int x, int y, int w, int h);
   void compute_dasharray(float s, char *dashes=0);
@@ -91,8 +110,8 @@ protected:
   int height() ;
   int descent() ;
   void draw_rgb(Fl_RGB_Image *rgb, int XP, int YP, int WP, int HP, int cx, int cy);
-  void define_rgb_png(Fl_RGB_Image *rgb, const char *name, int x, int y);
-  void define_rgb_jpeg(Fl_RGB_Image *rgb, const char *name, int x, int y);
+  void define_rgb_png(Fl_RGB_Image *rgb, const char *name);
+  void define_rgb_jpeg(Fl_RGB_Image *rgb, const char *name);
   void draw_pixmap(Fl_Pixmap *pxm,int XP, int YP, int WP, int HP, int cx, int cy);
   void draw_bitmap(Fl_Bitmap *bm,int XP, int YP, int WP, int HP, int cx, int cy);
   void draw_image(const uchar* buf, int x, int y, int w, int h, int d, int l);
@@ -142,7 +161,12 @@ Fl_SVG_Graphics_Driver::Fl_SVG_Graphics_Driver(FILE *f) {
   dasharray_ = fl_strdup("none");
   p_size = 0;
   p = NULL;
-  last_rgb_name_ = NULL;
+  images_ = NULL;
+  image_count_ = image_alloc_ = unlisted_images_ = 0;
+  path_ = NULL;
+  path_len_ = path_size_ = 0;
+  path_kind_ = 0;
+  compression_level_ = -1;
 }
 
 Fl_SVG_Graphics_Driver::~Fl_SVG_Graphics_Driver()
@@ -154,18 +178,110 @@ Fl_SVG_Graphics_Driver::~Fl_SVG_Graphics_Driver()
     clip_= clip_->prev;
     delete c;
   }
-  if (last_rgb_name_) free(last_rgb_name_);
+  for (int i = 0; i < image_count_; i++) free(images_[i].pixels);
+  free(images_);
+  free(path_);
+}
+
+// Outputs formatted data with '.' as decimal point whatever the current locale
+int Fl_SVG_Graphics_Driver::clocale_printf(const char *format, ...) {
+  flush_path();
+  char buffer[1024], *big = NULL;
+  size_t size = sizeof(buffer);
+  int n;
+  va_list args;
+  for (;;) {
+    va_start(args, format);
+    n = fl_clocale_vsnprintf(big ? big : buffer, size, format, args);
+    va_end(args);
+    if (n >= 0 || size >= 0x100000) break;
+    char *b = (char*)realloc(big, size * 4); // e.g. for a long string
+    if (!b) break;
+    big = b;
+    size *= 4;
+  }
+  if (n >= 0) fwrite(big ? big : buffer, n, 1, out_);
+  else { // an unsupported format
+    va_start(args, format);
+    n = vfprintf(out_, format, args);
+    va_end(args);
+  }
+  free(big);
+  return n;
 }
 
+#define MAX_PATH_LENGTH 65536 // longer paths are split in several <path> elements
+
+// Appends formatted data to the path of consecutive strokes ('S'), fills ('F')
+// or to the path of a polygon ('P'). Data of another kind than the pending path
+// starts a new path, and so may a new subpath of a long path.
+void Fl_SVG_Graphics_Driver::path_printf(char kind, const char *format, ...) {
+  if (path_kind_ != kind || (path_len_ > MAX_PATH_LENGTH && kind != 'P' && *format == 'M')) {
+    flush_path();
+    path_kind_ = kind;
+  }
+  int room = 512; // fl_clocale_vsnprintf() needs room for the longest number
+  for (;;) {
+    if (path_size_ - path_len_ < room) {
+      int size = path_size_ ? 2 * path_size_ : 4096;
+      while (size - path_len_ < room) size *= 2;
+      char *path = (char*)realloc(path_, size);
+      if (!path) { // out of memory: output what we have and start a new path
+        if (!path_len_) return;
+        flush_path();
+        path_kind_ = kind;
+        continue;
+      }
+      path_ = path;
+      path_size_ = size;
+    }
+    va_list args;
+    va_start(args, format);
+    int n = fl_clocale_vsnprintf(path_ + path_len_, path_size_ - path_len_, format, args);
+    va_end(args);
+    if (n >= 0) {
+      path_len_ += n;
+      return;
+    }
+    if (room >= 0x100000) { // an unsupported format
+      va_start(args, format);
+      n = vsnprintf(path_ + path_len_, path_size_ - path_len_, format, args);
+      va_end(args);
+      if (n >= 0 && n < path_size_ - path_len_) path_len_ += n;
+      return;
+    }
+    room *= 4; // the data did not fit
+  }
+}
+
+// Outputs the pending path, if any, as a single <path> element
+void Fl_SVG_Graphics_Driver::flush_path() {
+  char kind = path_kind_;
+  if (!kind) return;
+  path_kind_ = 0;
+  fputs("<path d=\"", out_);
+  fwrite(path_, path_len_, 1, out_);
+  path_len_ = 0;
+  if (kind != 'S')
+    clocale_printf("\" fill=\"rgb(%u,%u,%u)\" />\n", red_, green_, blue_);
+  else
+    clocale_printf("\" fill=\"none\" stroke=\"rgb(%u,%u,%u)\" stroke-width=\"%d\" stroke-dasharray=\"%s\""
+                   " stroke-linecap=\"%s\" stroke-linejoin=\"%s\" />\n",
+                   red_, green_, blue_, width_, dasharray_, linecap_, linejoin_);
+}
+
+// Lines, rectangles and polylines drawn consecutively with the same color and
+// line style are output as a single path. The dash pattern restarts at each
+// subpath, so the result is the same as with separate elements.
 void Fl_SVG_Graphics_Driver::rect(int x, int y, int w, int h) {
-  fprintf(out_, "<rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\" "
-          "fill=\"none\" stroke=\"rgb(%u,%u,%u)\" stroke-width=\"%d\" stroke-dasharray=\"%s\""
-          " stroke-linecap=\"%s\" stroke-linejoin=\"%s\"/>\n", x, y, w-1, h-1, red_, green_, blue_, width_, dasharray_, linecap_, linejoin_);
+  path_printf('S', "M%d %dh%dv%dh%dz", x, y, w-1, h-1, 1-w);
 }
 
+// Filled rectangles of the same color also share a path. They all turn in
+// the same direction, so they can't make holes in each other.
 void Fl_SVG_Graphics_Driver::rectf(int x, int y, int w, int h) {
-  fprintf(out_, "<rect x=\"%.3f\" y=\"%.3f\" width=\"%d\" height=\"%d\" "
-          "fill=\"rgb(%u,%u,%u)\" />\n", x-.5, y-.5, w, h, red_, green_, blue_);
+  if (w <= 0 || h <= 0) return;
+  path_printf('F', "M%g %gh%dv%dh%dz", x-.5, y-.5, w, h, -w);
 }
 
 void Fl_SVG_Graphics_Driver::point(int x, int y) {
@@ -173,10 +289,7 @@ void Fl_SVG_Graphics_Driver::point(int x, int y) {
 }
 
 void Fl_SVG_Graphics_Driver::line(int x1, int y1, int x2, int y2) {
-  fprintf(out_,
-          "<line x1=\"%d\" y1=\"%d\" x2=\"%d\" y2=\"%d\" "
-          "style=\"stroke:rgb(%u,%u,%u);stroke-width:%d;stroke-linecap:%s;stroke-linejoin:%s;stroke-dasharray:%s\" />\n",
-          x1,y1,x2,y2, red_, green_, blue_, width_, linecap_, linejoin_, dasharray_);
+  path_printf('S', "M%d %dL%d %d", x1, y1, x2, y2);
 }
 
 void Fl_SVG_Graphics_Driver::font_(int ft, int s) {
@@ -198,13 +311,26 @@ void Fl_SVG_Graphics_Driver::font(int ft, int s) {
   font_(ft, s);
 }
 
+// snprintf() with '.' as decimal point whatever the current locale
+static void svg_snprintf(char *to, size_t size, const char *format, ...) {
+  char buffer[256];
+  va_list args;
+  va_start(args, format);
+  int n = fl_clocale_vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  if (n < 0) n = 0;
+  if ((size_t)n >= size) n = (int)size - 1;
+  memcpy(to, buffer, n);
+  to[n] = 0;
+}
+
 void Fl_SVG_Graphics_Driver::compute_dasharray(float s, char *dashes) {
   if (user_dash_array_ && user_dash_array_ != dashes) {free(user_dash_array_); user_dash_array_ = NULL;}
   if (dashes && *dashes) {
     if (dasharray_) free(dasharray_);
     dasharray_ = (char*)calloc(10*strlen(dashes) + 1, 1);
     for (char *p = dashes; *p; p++) {
-      sprintf(dasharray_+strlen(dasharray_), "%.3f,", (*p)/s);
+      svg_snprintf(dasharray_+strlen(dasharray_), 11, "%.3f,", (*p)/s);
     }
     dasharray_[strlen(dasharray_) - 1] = 0;
     if (user_dash_array_ != dashes) user_dash_array_ = fl_strdup(dashes);
@@ -224,14 +350,15 @@ void Fl_SVG_Graphics_Driver::compute_dasharray(float s, char *dashes) {
     float big = (is_flat ? 3*width_/s : width_*2.5/s);
     if (dasharray_) free(dasharray_);
     dasharray_ = (char*)malloc(61);
-    if (dash_part == FL_DOT) sprintf(dasharray_, "%.3f,%.3f", dot, gap);
-    else if (dash_part == FL_DASH) sprintf(dasharray_, "%.3f,%.3f", big, gap);
-    else if (dash_part == FL_DASHDOT) sprintf(dasharray_, "%.3f,%.3f,%.3f,%.3f", big, gap, dot, gap);
-    else sprintf(dasharray_, "%.3f,%.3f,%.3f,%.3f,%.3f,%.3f", big, gap, dot, gap, dot, gap);
+    if (dash_part == FL_DOT) svg_snprintf(dasharray_, 61, "%.3f,%.3f", dot, gap);
+    else if (dash_part == FL_DASH) svg_snprintf(dasharray_, 61, "%.3f,%.3f", big, gap);
+    else if (dash_part == FL_DASHDOT) svg_snprintf(dasharray_, 61, "%.3f,%.3f,%.3f,%.3f", big, gap, dot, gap);
+    else svg_snprintf(dasharray_, 61, "%.3f,%.3f,%.3f,%.3f,%.3f,%.3f", big, gap, dot, gap, dot, gap);
   }
 }
 
 void Fl_SVG_Graphics_Driver::line_style(int style, int width, char *dashes) {
+  flush_path();
   line_style_ = style;
   if (width == 0) width = 1;
   width_ = width;
@@ -250,15 +377,21 @@ void Fl_SVG_Graphics_Driver::line_style(int style, int width, char *dashes) {
 void Fl_SVG_Graphics_Driver::draw(const char *str, int n, int x, int y) {
   // Caution: Internet Explorer ignores the xml:space="preserve" attribute
   // work-around: replace all spaces by no-break space = U+00A0 = 0xC2-0xA0 (UTF-8) before sending to IE
-  fprintf(out_, "<text x=\"%d\" y=\"%d\" font-family=\"%s\"%s%s font-size=\"%d\" "
+  clocale_printf("<text x=\"%d\" y=\"%d\" font-family=\"%s\"%s%s font-size=\"%d\" "
           "xml:space=\"preserve\" "
           " fill=\"rgb(%u,%u,%u)\" textLength=\"%d\">", x, y, family_, bold_, style_, size(), red_, green_, blue_, (int)width(str, n));
-  for (int i = 0; i < n; i++) {
-    if (str[i] == '&') fputs("&amp;", out_);
-    else if (str[i] == '<') fputs("&lt;", out_);
-    else if (str[i] == '>') fputs("&gt;", out_);
-    else fputc(str[i], out_);
+  int i = 0, start = 0;
+  for (; i < n; i++) { // write runs of characters that need no escaping at once
+    const char *entity;
+    if (str[i] == '&') entity = "&amp;";
+    else if (str[i] == '<') entity = "&lt;";
+    else if (str[i] == '>') entity = "&gt;";
+    else continue;
+    fwrite(str + start, i - start, 1, out_);
+    fputs(entity, out_);
+    start = i + 1;
   }
+  fwrite(str + start, i - start, 1, out_);
   fputs("</text>\n", out_);
 }
 
@@ -267,7 +400,7 @@ void Fl_SVG_Graphics_Driver::draw(const char* str, int n, float fx, float fy) {
 }
 
 void Fl_SVG_Graphics_Driver::draw(int angle, const char* str, int n, int x, int y) {
-  fprintf(out_, "<g transform=\"translate(%d,%d) rotate(%d)\">", x, y, -angle);
+  clocale_printf("<g transform=\"translate(%d,%d) rotate(%d)\">", x, y, -angle);
   draw(str, n, 0, 0);
   fputs("</g>\n", out_);
 }
@@ -279,10 +412,13 @@ void Fl_SVG_Graphics_Driver::rtl_draw(const char *str, int n, int x, int y) {
 
 void Fl_SVG_Graphics_Driver::color(Fl_Color c) {
   Fl_Graphics_Driver::color(c);
-  Fl::get_color(c, red_, green_, blue_);
+  uchar r, g, b;
+  Fl::get_color(c, r, g, b);
+  color(r, g, b);
 }
 
 void Fl_SVG_Graphics_Driver::color(uchar r, uchar g, uchar b) {
+  if (path_kind_ && (r != red_ || g != green_ || b != blue_)) flush_path();
   red_ = r;
   green_ = g;
   blue_ = b;
@@ -316,7 +452,7 @@ Fl_SVG_File_Surface::Fl_SVG_File_Surface(int w, int h, FILE *f) : Fl_Widget_Surf
           "<svg width=\"%dpx\" height=\"%dpx\" viewBox=\"0 0 %d %d\"\n"
           "xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n", sw, sh, sw, sh);
   width_ = w; height_ = h;
-  fprintf(f, "<g transform=\"scale(%f)\">\n", s);
+  ((Fl_SVG_Graphics_Driver*)driver())->clocale_printf("<g transform=\"scale(%f)\">\n", s);
   fputs("<g transform=\"translate(0,0)\">\n", f);
 }
 
@@ -345,7 +481,7 @@ int Fl_SVG_File_Surface::close() {
 
 void Fl_SVG_File_Surface::translate(int x, int y) {
   Fl_SVG_Graphics_Driver *driver = (Fl_SVG_Graphics_Driver*)this->driver();
-  fprintf(driver->file(), "<g transform=\"translate(%d,%d) \">\n", x, y);
+  driver->clocale_printf("<g transform=\"translate(%d,%d) \">\n", x, y);
 }
 
 void Fl_SVG_File_Surface::untranslate() {
@@ -355,10 +491,21 @@ void Fl_SVG_File_Surface::untranslate() {
 
 void Fl_SVG_File_Surface::origin(int x, int y) {
   Fl_SVG_Graphics_Driver *driver = (Fl_SVG_Graphics_Driver*)this->driver();
-  fprintf(driver->file(), "</g><g transform=\"translate(%d,%d) \">\n", x, y);
+  driver->clocale_printf("</g><g transform=\"translate(%d,%d) \">\n", x, y);
   Fl_Widget_Surface::origin(x, y);
 }
 
+void Fl_SVG_File_Surface::compression_level(int level) {
+  Fl_SVG_Graphics_Driver *driver = (Fl_SVG_Graphics_Driver*)this->driver();
+  if (level > 9) level = 9;
+  driver->compression_level_ = (level < 0 ? -1 : level);
+}
+
+int Fl_SVG_File_Surface::compression_level() {
+  Fl_SVG_Graphics_Driver *driver = (Fl_SVG_Graphics_Driver*)this->driver();
+  return driver->compression_level_;
+}
+
 int Fl_SVG_File_Surface::printable_rect(int *w, int *h) {
   *w = width_;
   *h = height_;
@@ -372,66 +519,94 @@ struct svg_base64_t { // holds data useful to perform base64-encoding of a strea
   int lbuf; // # of valid bytes in buff
 };
 
-// Performs base64 encoding of up to 3 bytes.
-// To be called successively with 3 consecutive bytes (l=3),
-// and possibly with l=1 or l=2 only at the end of the byte stream.
-// Always writes 4 printable characters to the output FILE.
-static void to_base64(uchar *p, int l, svg_base64_t *svg_base64) {
-  static char base64_table[] =
-    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-  uchar B0 = *p++;
-  uchar B1 = (l == 1 ? 0 : *p++);
-  uchar B2 = (l <= 2 ? 0 : *p);
-  fputc(base64_table[ B0 >> 2 ], svg_base64->svg);
-  fputc(base64_table[ ((B0 & 0x3) << 4) + (B1 >> 4) ], svg_base64->svg);
-  fputc( (l == 1 ? '=' : base64_table[ ((B1 & 0xF) << 2) + (B2 >> 6) ]), svg_base64->svg );
-  fputc( (l < 3 ? '=' : base64_table[ B2 & 0x3F ]), svg_base64->svg );
-  svg_base64->lline += 4;
-  if (svg_base64->lline >= 80) {
-    fputc('\n', svg_base64->svg);
-    svg_base64->lline = 0;
+static const char base64_table[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static char base64_pairs[4096][2]; // the 2 characters encoding each 12-bit value
+
+// Writes ngroups groups of 3 bytes in base64-encoded form, 4 characters per group
+// and 80 characters per line. Each 12 bits are encoded with one table lookup.
+static void base64_groups(const uchar *p, size_t ngroups, svg_base64_t *svg_base64) {
+  if (!base64_pairs[0][0]) {
+    for (int i = 0; i < 4096; i++) {
+      base64_pairs[i][0] = base64_table[i >> 6];
+      base64_pairs[i][1] = base64_table[i & 0x3F];
+    }
   }
+  char out[4096];
+  int n = 0;
+  while (ngroups) {
+    size_t g = (80 - svg_base64->lline) / 4; // groups until the end of the line
+    if (g > ngroups) g = ngroups;
+    ngroups -= g;
+    svg_base64->lline += 4 * (int)g;
+    while (g--) {
+      unsigned v = (p[0] << 16) | (p[1] << 8) | p[2];
+      p += 3;
+      out[n] = base64_pairs[v >> 12][0];
+      out[n+1] = base64_pairs[v >> 12][1];
+      out[n+2] = base64_pairs[v & 0xFFF][0];
+      out[n+3] = base64_pairs[v & 0xFFF][1];
+      n += 4;
+    }
+    if (svg_base64->lline >= 80) {
+      out[n++] = '\n';
+      svg_base64->lline = 0;
+    }
+    if (n > (int)sizeof(out) - 81) { // no room for another line
+      fwrite(out, n, 1, svg_base64->svg);
+      n = 0;
+    }
+  }
+  if (n) fwrite(out, n, 1, svg_base64->svg);
 }
 
 // Writes to the svg file, in base64-encoded form, a block of length bytes.
-// 1 or 2 bytes may remain unprocessed after return.
-// Returns the number of remaining unprocessed bytes.
-static size_t write_by_3(uchar *data, size_t length, svg_base64_t *svg_base64) {
-  while (length >= 3) {
-    to_base64(data, 3, svg_base64);
-    data += 3;
-    length -= 3;
+// The 1 or 2 bytes that remain after the last group of 3 are kept in buff
+// and encoded with the next block or by end_base64().
+static void write_base64(const uchar *data, size_t length, svg_base64_t *svg_base64) {
+  if (svg_base64->lbuf) {
+    while (svg_base64->lbuf < 3 && length) {
+      svg_base64->buff[svg_base64->lbuf++] = *data++;
+      length--;
+    }
+    if (svg_base64->lbuf < 3) return;
+    base64_groups(svg_base64->buff, 1, svg_base64);
+  }
+  base64_groups(data, length / 3, svg_base64);
+  svg_base64->lbuf = (int)(length % 3);
+  memcpy(svg_base64->buff, data + length - svg_base64->lbuf, svg_base64->lbuf);
+}
+
+// Encodes the last 1 or 2 bytes of the byte stream, if any
+static void end_base64(svg_base64_t *svg_base64) {
+  int l = svg_base64->lbuf;
+  if (!l) return;
+  uchar B0 = svg_base64->buff[0];
+  uchar B1 = (l == 1 ? 0 : svg_base64->buff[1]);
+  char out[5];
+  out[0] = base64_table[ B0 >> 2 ];
+  out[1] = base64_table[ ((B0 & 0x3) << 4) + (B1 >> 4) ];
+  out[2] = (l == 1 ? '=' : base64_table[ (B1 & 0xF) << 2 ]);
+  out[3] = '=';
+  svg_base64->lline += 4;
+  if (svg_base64->lline >= 80) {
+    out[4] = '\n';
+    svg_base64->lline = 0;
   }
-  return length;
+  fwrite(out, svg_base64->lline ? 4 : 5, 1, svg_base64->svg);
+  svg_base64->lbuf = 0;
 }
 
 #ifdef HAVE_LIBPNG
 
 // processes length bytes of the png stream under construction
 static void user_write_data(png_structp png_ptr, png_bytep data, png_size_t length) {
-  svg_base64_t *svg_base64_data = (svg_base64_t*)png_get_io_ptr(png_ptr);
-  if (svg_base64_data->lbuf == 1 && length >= 2) {
-    svg_base64_data->buff[1] = *data++; length--;
-    svg_base64_data->buff[2] = *data++; length--;
-    write_by_3(svg_base64_data->buff, 3, svg_base64_data);
-  }  else if (svg_base64_data->lbuf == 2 && length >= 1) {
-    svg_base64_data->buff[2] = *data++; length--;
-    write_by_3(svg_base64_data->buff, 3, svg_base64_data);
-  }
-  size_t new_l = length;
-  if (length >= 3) {
-    new_l = write_by_3(data, length, svg_base64_data);
-  }
-  svg_base64_data->lbuf = new_l;
-  if (new_l) {
-    memcpy(svg_base64_data->buff, data + length - new_l, new_l);
-  }
+  write_base64(data, length, (svg_base64_t*)png_get_io_ptr(png_ptr));
 }
 
 // processes last bytes to be base64 encoded
 static void user_flush_data(png_structp png_ptr) {
-  svg_base64_t *svg_base64_data = (svg_base64_t*)png_get_io_ptr(png_ptr);
-  if (svg_base64_data->lbuf) to_base64(svg_base64_data->buff, svg_base64_data->lbuf, svg_base64_data);
+  end_base64((svg_base64_t*)png_get_io_ptr(png_ptr));
 }
 
 /* How to define first the image data and next use it, possibly several times:
@@ -452,7 +627,7 @@ AxhQP6QxgAEM+LYBf9sdYcTRmp6pAAAAAElFTkSuQmCCAAAAAElFTkSuQmCC"/>
  AxhQP6QxgAEM+LYBf9sdYcTRmp6pAAAAAElFTkSuQmCCAAAAAElFTkSuQmCC"/>
  */
 
-void Fl_SVG_Graphics_Driver::define_rgb_png(Fl_RGB_Image *rgb, const char *name, int x, int y) {
+void Fl_SVG_Graphics_Driver::define_rgb_png(Fl_RGB_Image *rgb, const char *name) {
   png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
   if (!png_ptr) return;
   png_infop info_ptr = png_create_info_struct(png_ptr);
@@ -460,14 +635,9 @@ void Fl_SVG_Graphics_Driver::define_rgb_png(Fl_RGB_Image *rgb, const char *name,
     png_destroy_write_struct(&png_ptr, (png_infopp)NULL);
     return;
   }
-  if (name) {
-    if (last_rgb_name_) free(last_rgb_name_);
-    last_rgb_name_ = fl_strdup(name);
-  }
   float f = rgb->data_w() > rgb->data_h() ? float(rgb->w()) / rgb->data_w(): float(rgb->h()) / rgb->data_h();
-  if (name) fprintf(out_, "<defs><image id=\"%s\" ", name);
-  else fprintf(out_, "<image x=\"%d\" y=\"%d\" ", x, y);
-  fprintf(out_, "width=\"%f\" height=\"%f\" href=\"data:image/png;base64,\n", f*rgb->data_w(), f*rgb->data_h());
+  clocale_printf("<defs><image id=\"%s\" width=\"%f\" height=\"%f\" href=\"data:image/png;base64,\n",
+                 name, f*rgb->data_w(), f*rgb->data_h());
   // Transforms the image into a stream of bytes in PNG format,
   // base64-encode this byte stream, and outputs the result to the svg FILE.
   svg_base64_t svg_base64_data;
@@ -492,6 +662,7 @@ void Fl_SVG_Graphics_Driver::define_rgb_png(Fl_RGB_Image *rgb, const char *name,
       color_type = PNG_COLOR_TYPE_RGB_ALPHA;
   }
   png_set_IHDR(png_ptr, info_ptr, rgb->data_w(), rgb->data_h(), 8, color_type, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+  if (compression_level_ >= 0) png_set_compression_level(png_ptr, compression_level_);
   const uchar **row_pointers = new const uchar*[rgb->data_h()];
   int ld = rgb->ld() ? rgb->ld() : rgb->d() * rgb->data_w();
   for (int i=0; i < rgb->data_h(); i++) row_pointers[i] = (rgb->array + i*ld);
@@ -501,8 +672,7 @@ void Fl_SVG_Graphics_Driver::define_rgb_png(Fl_RGB_Image *rgb, const char *name,
   user_flush_data(png_ptr);
   png_destroy_write_struct(&png_ptr, &info_ptr);
   delete[] row_pointers;
-  if (name) fputs("\"/></defs>\n", out_);
-  else fputs("\"/>\n", out_);
+  fputs("\"/></defs>\n", out_);
 }
 
 #endif // HAVE_LIBPNG
@@ -521,42 +691,24 @@ static void init_destination(jpeg_compress_struct *cinfo) {
   cinfo->dest->free_in_buffer = client_data->size;
 }
 
-static size_t process_jpeg_chunk(jpeg_compress_struct *cinfo, size_t length) {
-  jpeg_client_data_struct *client_data = (jpeg_client_data_struct*)(cinfo->client_data);
-  JOCTET *data = client_data->JPEG_BUFFER;
-  size_t new_l = length;
-  if (length >= 3) {
-    new_l = write_by_3(data, length, &client_data->base64_data);
-    if (new_l) memmove(client_data->JPEG_BUFFER, data + length - new_l, new_l);
-  }
-  cinfo->dest->next_output_byte = client_data->JPEG_BUFFER + new_l;
-  cinfo->dest->free_in_buffer = client_data->size - new_l;
-  return new_l;
-}
-
 static boolean empty_output_buffer(jpeg_compress_struct *cinfo) {
   jpeg_client_data_struct *client_data = (jpeg_client_data_struct*)(cinfo->client_data);
-  process_jpeg_chunk(cinfo, client_data->size);
+  write_base64(client_data->JPEG_BUFFER, client_data->size, &client_data->base64_data);
+  init_destination(cinfo);
   return TRUE;
 }
 
 static void term_destination(jpeg_compress_struct *cinfo) {
   jpeg_client_data_struct *client_data = (jpeg_client_data_struct*)(cinfo->client_data);
-  size_t new_l = process_jpeg_chunk(cinfo, client_data->size - cinfo->dest->free_in_buffer);
-  if (new_l) {
-    to_base64(client_data->JPEG_BUFFER, new_l, &client_data->base64_data);
-  }
+  write_base64(client_data->JPEG_BUFFER, client_data->size - cinfo->dest->free_in_buffer,
+               &client_data->base64_data);
+  end_base64(&client_data->base64_data);
 }
 
-void Fl_SVG_Graphics_Driver::define_rgb_jpeg(Fl_RGB_Image *rgb, const char *name, int x, int y) {
-  if (name) {
-    if (last_rgb_name_) free(last_rgb_name_);
-    last_rgb_name_ = fl_strdup(name);
-  }
+void Fl_SVG_Graphics_Driver::define_rgb_jpeg(Fl_RGB_Image *rgb, const char *name) {
   float f = rgb->data_w() > rgb->data_h() ? float(rgb->w()) / rgb->data_w(): float(rgb->h()) / rgb->data_h();
-  if (name) fprintf(out_, "<defs><image id=\"%s\" ", name);
-  else fprintf(out_, "<image x=\"%d\" y=\"%d\" ", x, y);
-  fprintf(out_, "width=\"%f\" height=\"%f\" href=\"data:image/jpeg;base64,\n", f*rgb->data_w(), f*rgb->data_h());
+  clocale_printf("<defs><image id=\"%s\" width=\"%f\" height=\"%f\" href=\"data:image/jpeg;base64,\n",
+                 name, f*rgb->data_w(), f*rgb->data_h());
   // Transforms the image into a stream of bytes in JPEG format,
   // base64-encode this byte stream, and outputs the result to the svg FILE.
   jpeg_compress_struct cinfo;
@@ -588,111 +740,139 @@ void Fl_SVG_Graphics_Driver::define_rgb_jpeg(Fl_RGB_Image *rgb, const char *name
   }
   jpeg_finish_compress(&cinfo);
   jpeg_destroy_compress(&cinfo);
-  if (name) fputs("\"/></defs>\n", out_);
-  else fputs("\"/>\n", out_);
+  fputs("\"/></defs>\n", out_);
 }
 #endif // HAVE_LIBJPEG
 
-void Fl_SVG_Graphics_Driver::draw_rgb(Fl_RGB_Image *rgb, int XP, int YP, int WP, int HP, int cx, int cy) {
 #if defined(HAVE_LIBPNG)
+
+// Computes the name of the SVG image definition of the pixels of rgb.
+// Returns 1 if these pixels are already defined in the SVG file, 0 if they must be.
+int Fl_SVG_Graphics_Driver::image_name(Fl_RGB_Image *rgb, char *name) {
+  Image_Def def;
+  def.w = rgb->w(); def.h = rgb->h();
+  def.data_w = rgb->data_w(); def.data_h = rgb->data_h(); def.d = rgb->d();
+  // two hashes select the candidates, whose pixels are then compared
+  def.hash1 = 2166136261U; def.hash2 = 5381;
+  int ld = rgb->ld() ? rgb->ld() : rgb->data_w() * rgb->d();
+  int row = def.data_w * def.d;
+  for (int j = 0; j < def.data_h; j++) {
+    const uchar *q = rgb->array + j * ld, *e = q + row;
+    while (q < e) {
+      def.hash1 = (def.hash1 ^ *q) * 16777619U;
+      def.hash2 = def.hash2 * 33 + *q++;
+    }
+  }
+  int i;
+  for (i = 0; i < image_count_; i++) {
+    Image_Def &u = images_[i];
+    if (u.hash1 == def.hash1 && u.hash2 == def.hash2 && u.w == def.w && u.h == def.h &&
+        u.data_w == def.data_w && u.data_h == def.data_h && u.d == def.d && u.pixels) {
+      int j;
+      for (j = 0; j < def.data_h; j++)
+        if (memcmp(u.pixels + j * row, rgb->array + j * ld, row)) break;
+      if (j == def.data_h) break;
+    }
+  }
+  sprintf(name, "FLimg%d", i);
+  if (i < image_count_) return 1;
+  if (image_count_ >= image_alloc_) {
+    int alloc = image_alloc_ ? 2 * image_alloc_ : 16;
+    Image_Def *images = (Image_Def*)realloc(images_, alloc * sizeof(Image_Def));
+    if (!images) { // define the image under a name of its own, but don't remember it
+      sprintf(name, "FLimgx%d", unlisted_images_++);
+      return 0;
+    }
+    images_ = images;
+    image_alloc_ = alloc;
+  }
+  // without a copy of its pixels, the image is never reused
+  def.pixels = (uchar*)malloc(row * def.data_h);
+  if (def.pixels) {
+    for (int j = 0; j < def.data_h; j++)
+      memcpy(def.pixels + j * row, rgb->array + j * ld, row);
+  }
+  images_[image_count_++] = def;
+  return 0;
+}
+
+// Draws an image with a <use> element. Its pixels are defined in the SVG file
+// the first time they are drawn, so images drawn several times are stored once.
+void Fl_SVG_Graphics_Driver::use_rgb(Fl_RGB_Image *rgb, int XP, int YP, int WP, int HP, int cx, int cy, bool jpeg) {
   char name[24];
-  bool need_clip = (cx || cy || WP != rgb->w() || HP != rgb->h());
-  void *p = (void*)*Fl_Graphics_Driver::id(rgb);
-  if (p) sprintf(name, "FLrgb%p", p); else name[0] = 0;
-  if (!p || !last_rgb_name_ || strcmp(name, last_rgb_name_) != 0) {
-    if (*name==0 && need_clip) push_clip(XP, YP, WP, HP);
+  if (!image_name(rgb, name)) {
 #if defined(HAVE_LIBJPEG)
-    if (rgb->d() == 3 || rgb->d() == 1) define_rgb_jpeg(rgb, *name ? name : NULL, XP-cx, YP-cy);
+    if (jpeg && (rgb->d() == 3 || rgb->d() == 1)) define_rgb_jpeg(rgb, name);
     else
 #endif // HAVE_LIBJPEG
-      define_rgb_png(rgb, *name ? name : NULL, XP-cx, YP-cy);
-    if (*name==0 && need_clip) pop_clip();
-  }
-  if (*name) {
-    if (need_clip) push_clip(XP, YP, WP, HP);
-    fprintf(out_, "<use href=\"#%s\" x=\"%d\" y=\"%d\"/>\n", last_rgb_name_, XP-cx, YP-cy);
-    if (need_clip) pop_clip();
+      define_rgb_png(rgb, name);
   }
+  bool need_clip = (cx || cy || WP != rgb->w() || HP != rgb->h());
+  if (need_clip) push_clip(XP, YP, WP, HP);
+  clocale_printf("<use href=\"#%s\" x=\"%d\" y=\"%d\"/>\n", name, XP-cx, YP-cy);
+  if (need_clip) pop_clip();
+}
+
+#endif // HAVE_LIBPNG
+
+void Fl_SVG_Graphics_Driver::draw_rgb(Fl_RGB_Image *rgb, int XP, int YP, int WP, int HP, int cx, int cy) {
+#if defined(HAVE_LIBPNG)
+  use_rgb(rgb, XP, YP, WP, HP, cx, cy, true);
 #endif // HAVE_LIBPNG
 }
 
 void Fl_SVG_Graphics_Driver::draw_pixmap(Fl_Pixmap *pxm, int XP, int YP, int WP, int HP, int cx, int cy) {
 #if defined(HAVE_LIBPNG)
-  char name[24];
-  bool need_clip = (cx || cy || WP != pxm->w() || HP != pxm->h());
-  void *p = (void*)*Fl_Graphics_Driver::id(pxm);
-  if (p) sprintf(name, "FLpx%p", p); else name[0] = 0;
-  if (!p || !last_rgb_name_ || strcmp(name, last_rgb_name_) != 0) {
-    Fl_RGB_Image *rgb = new Fl_RGB_Image(pxm);
-    if (*name==0 && need_clip) push_clip(XP, YP, WP, HP);
-    define_rgb_png(rgb, *name ? name : NULL, XP-cx, YP-cy);
-    if (*name==0 && need_clip) pop_clip();
-    delete rgb;
-  }
-  if (*name) {
-    if (need_clip) push_clip(XP, YP, WP, HP);
-    fprintf(out_, "<use href=\"#%s\" x=\"%d\" y=\"%d\"/>\n", last_rgb_name_, XP-cx, YP-cy);
-    if (need_clip) pop_clip();
-  }
+  Fl_RGB_Image *rgb = new Fl_RGB_Image(pxm);
+  use_rgb(rgb, XP, YP, WP, HP, cx, cy, false);
+  delete rgb;
 #endif // HAVE_LIBPNG
 }
 
 void Fl_SVG_Graphics_Driver::draw_bitmap(Fl_Bitmap *bm, int XP, int YP, int WP, int HP, int cx, int cy) {
 #if defined(HAVE_LIBPNG)
-  char name[45];
-  bool need_clip = (cx || cy || WP != bm->w() || HP != bm->h());
-  void *p = (void*)*Fl_Graphics_Driver::id(bm);
-  if (p) sprintf(name, "FLbm%p%X", p, fl_color()); else name[0] = 0;
-  if (!p || !last_rgb_name_ || strcmp(name, last_rgb_name_) != 0) {
-    uchar R, G, B;
-    Fl::get_color(fl_color(), R, G, B);
-    uchar *data = new uchar[bm->data_w() * bm->data_h() * 4];
-    memset(data, 0, bm->data_w() * bm->data_h() * 4);
-    Fl_RGB_Image *rgb = new Fl_RGB_Image(data, bm->data_w(), bm->data_h(), 4);
-    rgb->alloc_array = 1;
-    int rowBytes = (bm->data_w()+7)>>3 ;
-    for (int j = 0; j < bm->data_h(); j++) {
-      const uchar *p = bm->array + j*rowBytes;
-      for (int i = 0; i < rowBytes; i++) {
-        uchar q = *p;
-        int last = bm->data_w() - 8*i; if (last > 8) last = 8;
-        for (int k=0; k < last; k++) {
-          if (q&1) {
-            uchar *r = (uchar*)rgb->array + j*bm->data_w()*4 + i*8*4 + k*4;
-            *r++ = R; *r++ = G; *r++ = B; *r = ~0;
-          }
-          q >>= 1;
+  uchar R, G, B;
+  Fl::get_color(fl_color(), R, G, B);
+  uchar *data = new uchar[bm->data_w() * bm->data_h() * 4];
+  memset(data, 0, bm->data_w() * bm->data_h() * 4);
+  Fl_RGB_Image *rgb = new Fl_RGB_Image(data, bm->data_w(), bm->data_h(), 4);
+  rgb->alloc_array = 1;
+  int rowBytes = (bm->data_w()+7)>>3 ;
+  for (int j = 0; j < bm->data_h(); j++) {
+    const uchar *p = bm->array + j*rowBytes;
+    for (int i = 0; i < rowBytes; i++) {
+      uchar q = *p;
+      int last = bm->data_w() - 8*i; if (last > 8) last = 8;
+      for (int k=0; k < last; k++) {
+        if (q&1) {
+          uchar *r = (uchar*)rgb->array + j*bm->data_w()*4 + i*8*4 + k*4;
+          *r++ = R; *r++ = G; *r++ = B; *r = ~0;
         }
-        p++;
+        q >>= 1;
       }
+      p++;
     }
-    if (*name==0 && need_clip) push_clip(XP, YP, WP, HP);
-    define_rgb_png(rgb, *name ? name : NULL, XP-cx, YP-cy);
-    if (*name==0 && need_clip) pop_clip();
-    delete rgb;
-  }
-  if (*name) {
-    if (need_clip) push_clip(XP, YP, WP, HP);
-    fprintf(out_, "<use href=\"#%s\" x=\"%d\" y=\"%d\"/>\n", last_rgb_name_, XP-cx, YP-cy);
-    if (need_clip) pop_clip();
   }
+  rgb->scale(bm->w(), bm->h(), 0, 1);
+  use_rgb(rgb, XP, YP, WP, HP, cx, cy, false);
+  delete rgb;
 #endif // HAVE_LIBPNG
 }
 
 void Fl_SVG_Graphics_Driver::draw_image(const uchar* buf, int x, int y, int w, int h, int d, int l) {
   if (d < 0) {
-    fprintf(out_, "<g transform=\"translate(%d,%d) scale(-1,1)\">\n", x, y);
+    clocale_printf("<g transform=\"translate(%d,%d) scale(-1,1)\">\n", x, y);
     x = -w; y = 0; buf -= (w-1)*abs(d);
   }
   if (l < 0) {
-    fprintf(out_, "<g transform=\"translate(%d,%d) scale(1,-1)\">\n", x, y);
+    clocale_printf("<g transform=\"translate(%d,%d) scale(1,-1)\">\n", x, y);
     x = 0; y = -h; buf -= (h-1)*abs(l);
   }
   Fl_RGB_Image *rgb = new Fl_RGB_Image(buf, w, h, abs(d), abs(l));
   rgb->draw(x, y);
   delete rgb;
-  if (d < 0) fprintf(out_, "</g>\n");
-  if (l < 0) fprintf(out_, "</g>\n");
+  if (d < 0) clocale_printf("</g>\n");
+  if (l < 0) clocale_printf("</g>\n");
 }
 
 void Fl_SVG_Graphics_Driver::draw_image(Fl_Draw_Image_Cb cb, void* data, int x, int y, int w, int h, int d) {
@@ -736,27 +916,27 @@ void Fl_SVG_Graphics_Driver::push_clip(int x, int y, int w, int h) {
   c->prev=clip_;
   sprintf(c->Id, "FLclip%d", clip_count_++);
   clip_=c;
-  fprintf(out_, "<clipPath id=\"%s\"><rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\"/></clipPath><g clip-path=\"url(#%s)\">\n",
+  clocale_printf("<clipPath id=\"%s\"><rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\"/></clipPath><g clip-path=\"url(#%s)\">\n",
           c->Id, clip_->x , clip_->y , clip_->w, clip_->h, c->Id);
 }
 
 void Fl_SVG_Graphics_Driver::push_no_clip() {
   Clip * c=clip_;
   while (c) {
-    fprintf(out_, "</g>");
+    clocale_printf("</g>");
     c = c->prev;
   }
   c=new Clip();
   c->prev=clip_;
   strcpy(c->Id, "none"); // mark of no_clip
   clip_=c;
-  fprintf(out_, "<g clip-path=\"none\">\n");
+  clocale_printf("<g clip-path=\"none\">\n");
 }
 
 void Fl_SVG_Graphics_Driver::pop_clip() {
   Clip *c;
   bool was_no_clip = clip_ && (strcmp(clip_->Id, "none") == 0);
-  fprintf(out_, "</g>");
+  clocale_printf("</g>");
   if (clip_) {
     c = clip_;
     clip_ = clip_->prev;
@@ -772,13 +952,13 @@ void Fl_SVG_Graphics_Driver::pop_clip() {
       c = c->prev;
     }
     while (next) {
-      fprintf(out_, "<g clip-path=\"url(#%s)\">", next->Id);
+      clocale_printf("<g clip-path=\"url(#%s)\">", next->Id);
       c = next->prev;
       delete next;
       next = c;
     }
   }
-  fprintf(out_, "\n");
+  clocale_printf("\n");
 }
 
 int Fl_SVG_Graphics_Driver::clip_box(int x, int y, int w, int h, int& X, int& Y, int& W, int& H) {
@@ -825,23 +1005,23 @@ int Fl_SVG_Graphics_Driver::not_clipped(int x, int y, int w, int h) {
 }
 
 void Fl_SVG_Graphics_Driver::polygon(int x0, int y0, int x1, int y1, int x2, int y2) {
-  fprintf(out_, "<path d=\"M %d %d L %d %d L %d %d z\" fill=\"rgb(%u,%u,%u)\" />\n",
+  clocale_printf("<path d=\"M %d %d L %d %d L %d %d z\" fill=\"rgb(%u,%u,%u)\" />\n",
           x0, y0, x1, y1, x2, y2, red_, green_, blue_);
 }
 
 void Fl_SVG_Graphics_Driver::polygon(int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3) {
-  fprintf(out_, "<path d=\"M %d %d L %d %d L %d %d L %d %d z\" fill=\"rgb(%u,%u,%u)\" />\n",
+  clocale_printf("<path d=\"M %d %d L %d %d L %d %d L %d %d z\" fill=\"rgb(%u,%u,%u)\" />\n",
           x0, y0, x1, y1, x2, y2, x3, y3, red_, green_, blue_);
 }
 
 void Fl_SVG_Graphics_Driver::loop(int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3) {
-  fprintf(out_, "<path d=\"M %d %d L %d %d L %d %d L %d %d z\" fill=\"none\" stroke=\"rgb(%u,%u,%u)\" "
+  clocale_printf("<path d=\"M %d %d L %d %d L %d %d L %d %d z\" fill=\"none\" stroke=\"rgb(%u,%u,%u)\" "
           "stroke-width=\"%d\" stroke-linejoin=\"%s\" stroke-linecap=\"%s\" stroke-dasharray=\"%s\"/>\n",
           x0, y0, x1, y1, x2, y2, x3, y3, red_, green_, blue_, width_, linejoin_, linecap_, dasharray_);
 }
 
 void Fl_SVG_Graphics_Driver::loop(int x0, int y0, int x1, int y1, int x2, int y2) {
-  fprintf(out_, "<path d=\"M %d %d L %d %d L %d %d z\" fill=\"none\" stroke=\"rgb(%u,%u,%u)\" "
+  clocale_printf("<path d=\"M %d %d L %d %d L %d %d z\" fill=\"none\" stroke=\"rgb(%u,%u,%u)\" "
           "stroke-width=\"%d\" stroke-linejoin=\"%s\" stroke-linecap=\"%s\" stroke-dasharray=\"%s\"/>\n",
           x0, y0, x1, y1, x2, y2, red_, green_, blue_, width_, linejoin_, linecap_, dasharray_);
 }
@@ -868,7 +1048,7 @@ void Fl_SVG_Graphics_Driver::vertex(double x,double y) {
 
 void Fl_SVG_Graphics_Driver::end_points() {
   for (int i=0; i<n; i++) {
-    fprintf(out_, "<path d=\"M %f %f L %f %f\" fill=\"none\" stroke=\"rgb(%u,%u,%u)\" stroke-width=\"%d\" />\n",
+    clocale_printf("<path d=\"M %f %f L %f %f\" fill=\"none\" stroke=\"rgb(%u,%u,%u)\" stroke-width=\"%d\" />\n",
         p[i].x, p[i].y, p[i].x, p[i].y, red_, green_, blue_, width_);
   }
 }
@@ -879,11 +1059,9 @@ void Fl_SVG_Graphics_Driver::end_line() {
     return;
   }
   if (n<=1) return;
-  fprintf(out_, "<path d=\"M %f %f", p[0].x, p[0].y);
+  path_printf('S', "M%g %g", p[0].x, p[0].y);
   for (int i=1; i<n; i++)
-    fprintf(out_, " L %f %f", p[i].x, p[i].y);
-  fprintf(out_, "\" fill=\"none\" stroke=\"rgb(%u,%u,%u)\" stroke-width=\"%d\" stroke-dasharray=\"%s\" stroke-linecap=\"%s\" stroke-linejoin=\"%s\" />\n",
-          red_, green_, blue_, width_, dasharray_, linecap_, linejoin_);
+    path_printf('S', "L%g %g", p[i].x, p[i].y);
 }
 
 void Fl_SVG_Graphics_Driver::fixloop() {  // remove equal points from closed path
@@ -903,10 +1081,12 @@ void Fl_SVG_Graphics_Driver::end_polygon() {
     return;
   }
   if (n<=1) return;
-  fprintf(out_, "<path d=\"M %f %f", p[0].x, p[0].y);
+  // a polygon is never merged with other fills, which could make holes in it
+  path_printf('P', "M%g %g", p[0].x, p[0].y);
   for (int i=1; i<n; i++)
-    fprintf(out_, " L %f %f", p[i].x, p[i].y);
-  fprintf(out_, " z\" fill=\"rgb(%u,%u,%u)\" />\n", red_, green_, blue_);
+    path_printf('P', "L%g %g", p[i].x, p[i].y);
+  path_printf('P', "z");
+  flush_path();
 }
 
 void Fl_SVG_Graphics_Driver::circle(double x, double y, double r) {
@@ -918,12 +1098,12 @@ void Fl_SVG_Graphics_Driver::circle(double x, double y, double r) {
   int w = (int)rint(xt+rx)-llx;
   int lly = (int)rint(yt-ry);
   int h = (int)rint(yt+ry)-lly;
-  fprintf(out_, "<circle cx=\"%g\" cy=\"%g\" r=\"%g\"", xt, yt, (w+h)*0.25f);
+  clocale_printf("<circle cx=\"%g\" cy=\"%g\" r=\"%g\"", xt, yt, (w+h)*0.25f);
   if (what == POLYGON)
-    fprintf(out_, " fill");
+    clocale_printf(" fill");
   else
-    fprintf(out_, " fill=\"none\" stroke-width=\"%d\" stroke-dasharray=\"%s\" stroke-linecap=\"%s\" stroke", width_, dasharray_,linecap_);
-  fprintf(out_, "=\"rgb(%u,%u,%u)\" />\n", red_, green_, blue_);
+    clocale_printf(" fill=\"none\" stroke-width=\"%d\" stroke-dasharray=\"%s\" stroke-linecap=\"%s\" stroke", width_, dasharray_,linecap_);
+  clocale_printf("=\"rgb(%u,%u,%u)\" />\n", red_, green_, blue_);
 }
 
 void Fl_SVG_Graphics_Driver::begin_complex_polygon() {
@@ -948,10 +1128,12 @@ void Fl_SVG_Graphics_Driver::end_complex_polygon() {
     return;
   }
   if (n<=1) return;
-  fprintf(out_, "<path d=\"M %f %f", p[0].x, p[0].y);
+  // a polygon is never merged with other fills, which could make holes in it
+  path_printf('P', "M%g %g", p[0].x, p[0].y);
   for (int i=1; i<n; i++)
-    fprintf(out_, " L %f %f", p[i].x, p[i].y);
-  fprintf(out_, " z\" fill=\"rgb(%u,%u,%u)\" />\n", red_, green_, blue_);
+    path_printf('P', "L%g %g", p[i].x, p[i].y);
+  path_printf('P', "z");
+  flush_path();
 }
 
 void Fl_SVG_Graphics_Driver::arc(int x, int y, int w, int h, double a1, double a2) {
@@ -985,25 +1167,25 @@ void Fl_SVG_Graphics_Driver::arc_pie(char AorP, int x, int y, int w, int h, doub
     sx = sy = 2*r;
     stroke_width /= sx;
   }
-  fprintf(out_, "<g transform=\"translate(%f,%f) scale(%f,%f)\">\n", cx, cy, sx, sy);
+  clocale_printf("<g transform=\"translate(%f,%f) scale(%f,%f)\">\n", cx, cy, sx, sy);
   if (AorP == 'A') compute_dasharray((sx+sy)/2, user_dash_array_);
   if (full) {
-    fprintf(out_, "<circle cx=\"0\" cy=\"0\" r=\"0.5\" style=\"fill");
+    clocale_printf("<circle cx=\"0\" cy=\"0\" r=\"0.5\" style=\"fill");
     if (AorP == 'A')
-      fprintf(out_, ":none;stroke-width:%f;stroke-linecap:%s;stroke-dasharray:%s;stroke", stroke_width, linecap_, dasharray_);
+      clocale_printf(":none;stroke-width:%f;stroke-linecap:%s;stroke-dasharray:%s;stroke", stroke_width, linecap_, dasharray_);
   } else {
     double x1 = 0.5*cos(a1), y1 = 0.5 * sin(a1);
     double x2 = 0.5*cos(a2), y2 = 0.5 * sin(a2);
     int fA = fabs(a2-a1) > M_PI ? 1 : 0;
     if (AorP == 'A')
-      fprintf(out_, "<path d=\"M %f,%f A 0.5,0.5 0 %d,0 %f,%f\" "
+      clocale_printf("<path d=\"M %f,%f A 0.5,0.5 0 %d,0 %f,%f\" "
               "style=\"fill:none;stroke-width:%f;stroke-linecap:%s;stroke-dasharray:%s;stroke",
               x1, y1, fA, x2, y2, stroke_width, linecap_, dasharray_);
     else
-      fprintf(out_, "<path d=\"M 0,0 L %f,%f A 0.5,0.5 0 %d,0 %f,%f z\" style=\"fill",
+      clocale_printf("<path d=\"M 0,0 L %f,%f A 0.5,0.5 0 %d,0 %f,%f z\" style=\"fill",
               x1, y1, fA, x2, y2);
   }
-  fprintf(out_, ":rgb(%u,%u,%u)\"/>\n</g>\n", red_, green_, blue_);
+  clocale_printf(":rgb(%u,%u,%u)\"/>\n</g>\n", red_, green_, blue_);
   if (AorP == 'A') compute_dasharray(1., user_dash_array_);
 }
 
@@ -1019,5 +1201,7 @@ void Fl_SVG_File_Surface::origin(int x, int y) {}
 void Fl_SVG_File_Surface::translate(int x, int y) {}
 void Fl_SVG_File_Surface::untranslate() {}
 int Fl_SVG_File_Surface::printable_rect(int *w, int *h) {return 0;}
+void Fl_SVG_File_Surface::compression_level(int level) {}
+int Fl_SVG_File_Surface::compression_level() {return -1;}
 
 #endif // FLTK_USE_SVG
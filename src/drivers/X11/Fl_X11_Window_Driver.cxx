@@ -24,11 +24,13 @@
 #include <FL/Fl_Overlay_Window.H>
 #include <FL/Fl_Menu_Window.H>
 #include <FL/Fl_Tooltip.H>
+#include <FL/Fl_Rect.H>
 #include <FL/fl_draw.H>
 #include <FL/fl_ask.H>
 #include <FL/Fl.H>
 #include <FL/platform.H>
 #include <string.h>
+#include <stdio.h>
 #if HAVE_DLFCN_H
 #include <dlfcn.h>
 #endif
@@ -45,6 +47,90 @@ extern uchar fl_overlay; // changes how fl_color(x) works
 
 Window fl_window;
 
+// Damage regions with more rectangles are used as they are
+static const int max_dirty_rects = 32;
+// Dirty rectangles are merged until there are at most this many left
+static const int max_clip_rects = 8;
+
+static long area(const Fl_Rect &r) { return (long)r.w() * r.h(); }
+
+static Fl_Rect bounding_box(const Fl_Rect &a, const Fl_Rect &b) {
+  int x = a.x() < b.x() ? a.x() : b.x();
+  int y = a.y() < b.y() ? a.y() : b.y();
+  int r = a.r() > b.r() ? a.r() : b.r();
+  int bt = a.b() > b.b() ? a.b() : b.b();
+  return Fl_Rect(x, y, r - x, bt - y);
+}
+
+// Print the area drawn by each window flush if the FLTK_DRAW_STATS
+// environment variable is set (see osissues.dox)
+static void draw_stats(Fl_Window *win, long drawn, int rects, long bbox) {
+  static int enabled = -1;
+  if (enabled < 0) enabled = fl_getenv("FLTK_DRAW_STATS") != NULL;
+  if (!enabled) return;
+  fprintf(stderr, "FLTK: window %p (%s) drew %ld pixels in %d rectangle%s, damage bounding box %ld pixels\n",
+          (void*)win, win->label() ? win->label() : "", drawn, rects, rects > 1 ? "s" : "", bbox);
+}
+
+/*
+ Draw the damage region of the window.
+
+ Neighbouring rectangles of the damage region are merged while that adds
+ few pixels, so that the clip region holds a few rectangles. The window
+ is then drawn once, clipped to these rectangles: widgets outside all of
+ them are skipped by fl_not_clipped(), and nothing outside them is drawn.
+ */
+void Fl_X11_Window_Driver::draw_damage() {
+  Fl_X *i = Fl_X::i(pWindow);
+  Fl_Region r = i->region;
+  i->region = 0;
+  long drawn = (long)w() * h(), bbox_area = drawn;
+  int nrects = 1;
+  if (r && r->numRects > 1 && r->numRects <= max_dirty_rects) {
+    Fl_Rect dirty[max_dirty_rects];
+    int n = r->numRects, k;
+    for (k = 0; k < n; k++) {
+      BOX &b = r->rects[k];
+      dirty[k] = Fl_Rect(b.x1, b.y1, b.x2 - b.x1, b.y2 - b.y1);
+    }
+    // merge the two rectangles whose bounding box adds the fewest pixels
+    // while that is less than 1/8 of it, or while there are too many
+    while (n > 1) {
+      long best = -1, best_area = 0;
+      int bi = 0, bj = 1;
+      for (int a = 0; a < n; a++) for (int b = a + 1; b < n; b++) {
+        long u = area(bounding_box(dirty[a], dirty[b]));
+        long waste = u - area(dirty[a]) - area(dirty[b]);
+        if (best < 0 || waste < best) { best = waste; best_area = u; bi = a; bj = b; }
+      }
+      if (n <= max_clip_rects && best * 8 > best_area) break;
+      dirty[bi] = bounding_box(dirty[bi], dirty[bj]);
+      dirty[bj] = dirty[--n];
+    }
+    Fl_Graphics_Driver &d = Fl_Graphics_Driver::default_driver();
+    d.XDestroyRegion(r);
+    r = d.XRectangleRegion(dirty[0].x(), dirty[0].y(), dirty[0].w(), dirty[0].h());
+    Fl_Rect bbox = dirty[0];
+    drawn = area(dirty[0]);
+    for (k = 1; k < n; k++) {
+      d.add_rectangle_to_region(r, dirty[k].x(), dirty[k].y(), dirty[k].w(), dirty[k].h());
+      bbox = bounding_box(bbox, dirty[k]);
+      drawn += area(dirty[k]);
+    }
+    bbox_area = area(bbox);
+    nrects = n;
+  } else if (r) {
+    drawn = 0;
+    for (int k = 0; k < r->numRects; k++)
+      drawn += (long)(r->rects[k].x2 - r->rects[k].x1) * (r->rects[k].y2 - r->rects[k].y1);
+    bbox_area = (long)(r->extents.x2 - r->extents.x1) * (r->extents.y2 - r->extents.y1);
+    nrects = r->numRects;
+  }
+  fl_clip_region(r);
+  draw();
+  draw_stats(pWindow, drawn, nrects, bbox_area);
+}
+
 #if USE_XDBE
 #include <X11/extensions/Xdbe.h>
 
@@ -90,9 +176,8 @@ void Fl_X11_Window_Driver::flush_double_dbe(int erase_overlay)
   }
   // Redraw as needed...
   if (pWindow->damage()) {
-    fl_clip_region(i->region); i->region = 0;
     fl_window = other_xid;
-    draw();
+    draw_damage();
     fl_window = i->xid;
   }
   // Copy contents of back buffer to window...
@@ -226,9 +311,8 @@ void Fl_X11_Window_Driver::flush_double(int erase_overlay)
     pWindow->clear_damage(FL_DAMAGE_ALL);
   }
     if (pWindow->damage() & ~FL_DAMAGE_EXPOSE) {
-      fl_clip_region(i->region); i->region = 0;
       fl_window = other_xid;
-      draw();
+      draw_damage();
       fl_window = i->xid;
     }
   if (erase_overlay) fl_clip_region(0);
@@ -476,6 +560,9 @@ void Fl_X11_Window_Driver::hide() {
 # if USE_XFT
   Fl_Xlib_Graphics_Driver::destroy_xft_draw(ip->xid);
   screen_num_ = -1;
+# endif
+# if HAVE_XRENDER
+  ((Fl_Xlib_Graphics_Driver&)Fl_Graphics_Driver::default_driver()).destroy_aa_picture(ip->xid);
 # endif
   // this test makes sure ip->xid has not been destroyed already
   if (ip->xid) XDestroyWindow(fl_display, ip->xid);
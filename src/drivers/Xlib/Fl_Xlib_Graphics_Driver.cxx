@@ -18,6 +18,9 @@
 #include "../../config_lib.h"
 #include "Fl_Xlib_Graphics_Driver.H"
 #include "Fl_Font.H"
+#if HAVE_XRENDER
+#include "../../Fl_Scanline_Rasterizer.H"
+#endif
 #include <FL/fl_draw.H>
 #include <FL/platform.H>
 
@@ -39,6 +42,9 @@ Fl_Graphics_Driver *Fl_Graphics_Driver::newMainGraphicsDriver()
 }
 
 GC Fl_Xlib_Graphics_Driver::gc_ = NULL;
+GC Fl_Xlib_Graphics_Driver::clip_gc_ = NULL;
+char Fl_Xlib_Graphics_Driver::clip_gc_set_ = 0;
+XRectangle Fl_Xlib_Graphics_Driver::clip_gc_rect_;
 
 /* Reference to the current graphics context
  For back-compatibility only. The preferred procedure to get this pointer is
@@ -57,10 +63,31 @@ Fl_Xlib_Graphics_Driver::Fl_Xlib_Graphics_Driver(void) {
   offset_x_ = 0; offset_y_ = 0;
   depth_ = 0;
   clip_max_ = 32760; // clipping limit (2**15 - 8)
+  memset(is_rect_clip_, 0, sizeof(is_rect_clip_));
+#if HAVE_XRENDER
+  antialias_ = 0;
+  line_style_ = line_dashed_ = 0;
+  fp_ = NULL;
+  fp_size_ = fn_ = fgap_ = 0;
+  rasterizer_ = NULL;
+  aa_mask_ = 0;
+  aa_mask_picture_ = 0;
+  aa_mask_gc_ = 0;
+  aa_mask_w_ = aa_mask_h_ = 0;
+  aa_fill_picture_ = 0;
+  aa_fill_rgb_ = 0;
+  aa_dst_picture_ = 0;
+  aa_dst_ = 0;
+#endif
 }
 
 Fl_Xlib_Graphics_Driver::~Fl_Xlib_Graphics_Driver() {
   if (p) free(p);
+#if HAVE_XRENDER
+  if (fp_) free(fp_);
+  delete rasterizer_;
+  release_aa();
+#endif
 }
 
 
@@ -104,6 +131,9 @@ void Fl_Xlib_Graphics_Driver::add_rectangle_to_region(Fl_Region r, int X, int Y,
 
 void Fl_Xlib_Graphics_Driver::transformed_vertex0(float fx, float fy) {
   short x = short(fx), y = short(fy);
+#if HAVE_XRENDER
+  if (!n) fn_ = fgap_ = 0;
+#endif
   if (!n || x != p[n-1].x || y != p[n-1].y) {
     if (n >= p_size) {
       p_size = p ? 2*p_size : 16;
@@ -113,6 +143,9 @@ void Fl_Xlib_Graphics_Driver::transformed_vertex0(float fx, float fy) {
     p[n].y = y + line_delta_;
     n++;
   }
+#if HAVE_XRENDER
+  if (antialias_) add_fvertex(fx + line_delta_, fy + line_delta_);
+#endif
 }
 
 void Fl_Xlib_Graphics_Driver::fixloop() {  // remove equal points from closed path
@@ -240,8 +273,9 @@ void Fl_Xlib_Graphics_Driver::font_name(int num, const char *name) {
 
 
 Region Fl_Xlib_Graphics_Driver::scale_clip(float f) {
-  Region r = rstack[rstackptr];
-  if (r == 0 || (f == 1 && offset_x_ == 0 && offset_y_ == 0) ) return 0;
+  if (f == 1 && offset_x_ == 0 && offset_y_ == 0) return 0;
+  Region r = clip_region();
+  if (r == 0) return 0;
   int deltaf = f/2;
   Region r2 = XCreateRegion();
   for (int i = 0; i < r->numRects; i++) {
@@ -18,6 +18,10 @@
 #include "Fl_Xlib_Graphics_Driver.H"
 #include <FL/fl_draw.H>
 #include <FL/platform.H>
+#include <FL/math.h>
+#if HAVE_XRENDER
+#include "../../Fl_Scanline_Rasterizer.H"
+#endif
 
 /**
   \file Fl_Xlib_Graphics_Driver_arci.cxx
@@ -26,6 +30,19 @@
 
 void Fl_Xlib_Graphics_Driver::arc_unscaled(float x,float y,float w,float h,double a1,double a2) {
   if (w <= 0 || h <= 0) return;
+#if HAVE_XRENDER
+  if (antialias_ && !line_dashed_) {
+    // same geometry as XDrawArc(): the line follows the centers of the
+    // pixels of the inner edge of the bounding box
+    float rx = (w-1)/2, ry = (h-1)/2;
+    fn_ = 0;
+    arc_fvertices(x + offset_x_*scale() + rx, y + offset_y_*scale() + ry, rx, ry, a1, a2);
+    int closed = (fabs(a2 - a1) >= 360);
+    if (closed && fn_ > 2) fn_--; // the last vertex repeats the first one
+    stroke_aa(closed);
+    return;
+  }
+#endif
   XDrawArc(fl_display, fl_window, gc_, int(x+offset_x_*scale()), int(y+offset_y_*scale()), int(w-1), int(h-1), int(a1*64),int((a2-a1)*64));
 }
 
@@ -33,6 +50,19 @@ void Fl_Xlib_Graphics_Driver::pie_unscaled(float x,float y,float w,float h,doubl
   if (w <= 0 || h <= 0) return;
   x += offset_x_*scale();
   y += offset_y_*scale();
+#if HAVE_XRENDER
+  if (antialias_) {
+    // XDrawArc() + XFillArc() cover the whole bounding box
+    float rx = w/2, ry = h/2;
+    fn_ = 0;
+    if (fabs(a2 - a1) < 360) add_fvertex(x + rx, y + ry);
+    arc_fvertices(x + rx, y + ry, rx, ry, a1, a2);
+    if (!rasterizer_) rasterizer_ = new Fl_Scanline_Rasterizer();
+    rasterizer_->add_polygon(fp_, fn_);
+    render_aa(Fl_Scanline_Rasterizer::NON_ZERO);
+    return;
+  }
+#endif
   XDrawArc(fl_display, fl_window, gc_, x,y,w-1,h-1, int(a1*64),int((a2-a1)*64));
   XFillArc(fl_display, fl_window, gc_, x,y,w-1,h-1, int(a1*64),int((a2-a1)*64));
 }
@@ -637,6 +637,31 @@ void Fl_Xlib_Graphics_Driver::draw_fixed(Fl_Bitmap *bm, int X, int Y, int W, int
 }
 
 
+// Divide by 255 with exact rounding, for 0 <= v <= 255*255
+#define DIV255(v) (((v) + 128 + (((v) + 128) >> 8)) >> 8)
+
+// Composite one row of W pixels of an image with alpha (d = 2 or 4)
+// over an RGB row. Written as a plain loop without branches on the
+// pixel values so that compilers can vectorize it.
+static void alpha_blend_row(const uchar *src, int d, uchar *dst, int W) {
+  if (d == 2) {
+    for (int x = 0; x < W; x++, src += 2, dst += 3) {
+      unsigned a = src[1], na = 255 - a;
+      unsigned g = src[0] * a;
+      dst[0] = (uchar)DIV255(g + dst[0] * na);
+      dst[1] = (uchar)DIV255(g + dst[1] * na);
+      dst[2] = (uchar)DIV255(g + dst[2] * na);
+    }
+  } else {
+    for (int x = 0; x < W; x++, src += 4, dst += 3) {
+      unsigned a = src[3], na = 255 - a;
+      dst[0] = (uchar)DIV255(src[0] * a + dst[0] * na);
+      dst[1] = (uchar)DIV255(src[1] * a + dst[1] * na);
+      dst[2] = (uchar)DIV255(src[2] * a + dst[2] * na);
+    }
+  }
+}
+
 // Composite an image with alpha on systems that don't have accelerated
 // alpha compositing...
 static void alpha_blend(Fl_RGB_Image *img, int X, int Y, int W, int H, int cx, int cy) {
@@ -647,55 +672,17 @@ static void alpha_blend(Fl_RGB_Image *img, int X, int Y, int W, int H, int cx, i
   if (W <= 0 || H <= 0) return;
   int ld = img->ld();
   if (ld == 0) ld = img->data_w() * img->d();
-  uchar *srcptr = (uchar*)img->array + cy * ld + cx * img->d();
-  int srcskip = ld - img->d() * W;
+  const uchar *srcptr = (const uchar*)img->array + cy * ld + cx * img->d();
 
   uchar *dst = new uchar[W * H * 3];
-  uchar *dstptr = dst;
 
   fl_read_image(dst, X, Y, W, H, 0);
 
-  uchar srcr, srcg, srcb, srca;
-  uchar dstr, dstg, dstb, dsta;
-
-  if (img->d() == 2) {
-    // Composite grayscale + alpha over RGB...
-    for (int y = H; y > 0; y--, srcptr+=srcskip)
-      for (int x = W; x > 0; x--) {
-        srcg = *srcptr++;
-        srca = *srcptr++;
-
-        dstr = dstptr[0];
-        dstg = dstptr[1];
-        dstb = dstptr[2];
-        dsta = 255 - srca;
-
-        *dstptr++ = (srcg * srca + dstr * dsta) >> 8;
-        *dstptr++ = (srcg * srca + dstg * dsta) >> 8;
-        *dstptr++ = (srcg * srca + dstb * dsta) >> 8;
-      }
-  } else {
-    // Composite RGBA over RGB...
-    for (int y = H; y > 0; y--, srcptr+=srcskip)
-      for (int x = W; x > 0; x--) {
-        srcr = *srcptr++;
-        srcg = *srcptr++;
-        srcb = *srcptr++;
-        srca = *srcptr++;
-
-        dstr = dstptr[0];
-        dstg = dstptr[1];
-        dstb = dstptr[2];
-        dsta = 255 - srca;
-
-        *dstptr++ = (srcr * srca + dstr * dsta) >> 8;
-        *dstptr++ = (srcg * srca + dstg * dsta) >> 8;
-        *dstptr++ = (srcb * srca + dstb * dsta) >> 8;
-      }
-  }
+  uchar *dstptr = dst;
+  for (int y = 0; y < H; y++, srcptr += ld, dstptr += W * 3)
+    alpha_blend_row(srcptr, img->d(), dstptr, W);
 
   fl_draw_image(dst, X, Y, W, H, 3, 0);
-
   delete[] dst;
 }
 
@@ -752,6 +739,11 @@ void Fl_Xlib_Graphics_Driver::draw_fixed(Fl_RGB_Image *img, int X, int Y, int W,
 
 #if HAVE_XRENDER
 
+// X resource ids have their 3 top bits clear, so a kept Picture id can carry
+// a flag telling that a scaling transform is set on that Picture
+#define PICTURE_SCALED ((fl_uintptr_t)1 << 31)
+static inline Picture picture_of(fl_uintptr_t p) { return (Picture)(p & ~PICTURE_SCALED); }
+
 void Fl_Xlib_Graphics_Driver::draw_rgb(Fl_RGB_Image *rgb, int XP, int YP, int WP, int HP, int cx, int cy) {
   if (!fl_can_do_alpha_blending()) {
     Fl_Graphics_Driver::draw_rgb(rgb, XP, YP, WP, HP, cx, cy);
@@ -767,22 +759,32 @@ void Fl_Xlib_Graphics_Driver::draw_rgb(Fl_RGB_Image *rgb, int XP, int YP, int WP
   cache_size(W, H);
   int Wfull = rgb->w(), Hfull = rgb->h();
   cache_size(Wfull, Hfull);
+  // the image's Picture is kept in its mask, see uncache(Fl_RGB_Image*, ...)
   scale_and_render_pixmap( *Fl_Graphics_Driver::id(rgb), rgb->d(),
                                  rgb->data_w() / double(Wfull), rgb->data_h() / double(Hfull),
-                          cx*scale(), cy*scale(), (X + offset_x_)*scale(), (Y + offset_y_)*scale(), W, H);
+                          cx*scale(), cy*scale(), (X + offset_x_)*scale(), (Y + offset_y_)*scale(), W, H,
+                          Fl_Graphics_Driver::mask(rgb));
 }
 
 /* Draws with Xrender an Fl_Offscreen with optional scaling and accounting for transparency if necessary.
- XP,YP,WP,HP are in drawing units
+ XP,YP,WP,HP are in drawing units.
+ If src_picture is not NULL, it holds the Picture of pixmap, which is created if
+ *src_picture is 0, and kept for the next call; the caller must free it.
+ Bit PICTURE_SCALED of *src_picture is set while a scaling transform is set on
+ the Picture, see picture_of().
  */
-int Fl_Xlib_Graphics_Driver::scale_and_render_pixmap(Fl_Offscreen pixmap, int depth, double scale_x, double scale_y, int srcx, int srcy, int XP, int YP, int WP, int HP) {
+int Fl_Xlib_Graphics_Driver::scale_and_render_pixmap(Fl_Offscreen pixmap, int depth, double scale_x, double scale_y, int srcx, int srcy, int XP, int YP, int WP, int HP, fl_uintptr_t *src_picture) {
   bool has_alpha = (depth == 2 || depth == 4);
   XRenderPictureAttributes srcattr;
   memset(&srcattr, 0, sizeof(XRenderPictureAttributes));
   static XRenderPictFormat *fmt24 = XRenderFindStandardFormat(fl_display, PictStandardRGB24);
   static XRenderPictFormat *fmt32 = XRenderFindStandardFormat(fl_display, PictStandardARGB32);
   static XRenderPictFormat *dstfmt = XRenderFindVisualFormat(fl_display, fl_visual->visual);
-  Picture src = XRenderCreatePicture(fl_display, pixmap, has_alpha ?fmt32:fmt24, 0, &srcattr);
+  Picture src = src_picture ? picture_of(*src_picture) : 0;
+  if (!src) {
+    src = XRenderCreatePicture(fl_display, pixmap, has_alpha ?fmt32:fmt24, 0, &srcattr);
+    if (src_picture) *src_picture = (fl_uintptr_t)src;
+  }
   Picture dst = XRenderCreatePicture(fl_display, fl_window, dstfmt, 0, &srcattr);
   if (!src || !dst) {
     fprintf(stderr, "Failed to create Render pictures (%lu %lu)\n", src, dst);
@@ -800,10 +802,20 @@ int Fl_Xlib_Graphics_Driver::scale_and_render_pixmap(Fl_Offscreen pixmap, int de
       { XDoubleToFixed( 0 ),       XDoubleToFixed( 0 ),       XDoubleToFixed( 1 ) }
     }};
     XRenderSetPictureTransform(fl_display, src, &mat);
+    if (src_picture) *src_picture |= PICTURE_SCALED;
+  } else if (src_picture && (*src_picture & PICTURE_SCALED)) {
+    // reset the transform set by a previous scaled draw
+    XTransform mat = {{
+      { XDoubleToFixed( 1 ), XDoubleToFixed( 0 ), XDoubleToFixed( 0 ) },
+      { XDoubleToFixed( 0 ), XDoubleToFixed( 1 ), XDoubleToFixed( 0 ) },
+      { XDoubleToFixed( 0 ), XDoubleToFixed( 0 ), XDoubleToFixed( 1 ) }
+    }};
+    XRenderSetPictureTransform(fl_display, src, &mat);
+    *src_picture &= ~PICTURE_SCALED;
   }
   XRenderComposite(fl_display, (has_alpha ? PictOpOver : PictOpSrc), src, None, dst, srcx, srcy, 0, 0,
                    XP, YP, WP, HP);
-  XRenderFreePicture(fl_display, src);
+  if (!src_picture) XRenderFreePicture(fl_display, src);
   XRenderFreePicture(fl_display, dst);
   return 1;
 }
@@ -812,6 +824,12 @@ int Fl_Xlib_Graphics_Driver::scale_and_render_pixmap(Fl_Offscreen pixmap, int de
 
 void Fl_Xlib_Graphics_Driver::uncache(Fl_RGB_Image*, fl_uintptr_t &id_, fl_uintptr_t &mask_)
 {
+#if HAVE_XRENDER
+  if (mask_) { // the XRender Picture of id_, see draw_rgb()
+    XRenderFreePicture(fl_display, picture_of(mask_));
+    mask_ = 0;
+  }
+#endif
   if (id_) {
     XFreePixmap(fl_display, (Fl_Offscreen)id_);
     id_ = 0;
@@ -862,6 +880,7 @@ void Fl_Xlib_Graphics_Driver::draw_fixed(Fl_Pixmap *pxm, int X, int Y, int W, in
     }
     // put the old clip region back
     XSetClipOrigin(fl_display, gc_, 0, 0);
+    clip_gc_ = 0; // the clip mask of gc_ was changed above
     float s = scale(); Fl_Graphics_Driver::scale(1);
     restore_clip();
     Fl_Graphics_Driver::scale(s);
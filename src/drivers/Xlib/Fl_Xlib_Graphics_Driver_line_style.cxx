@@ -60,4 +60,8 @@ if (*dashes == 0) ndashes = 0;//against error with very small scaling
                      ndashes ? LineOnOffDash : LineSolid,
                      Cap[(style>>8)&3], Join[(style>>12)&3]);
   if (ndashes) XSetDashes(fl_display, gc_, 0, dashes, ndashes);
+#if HAVE_XRENDER
+  line_style_ = style;
+  line_dashed_ = (ndashes != 0);
+#endif
 }
@@ -343,26 +343,92 @@ void Fl_Xlib_Graphics_Driver::draw_clipped_line(int x1, int y1, int x2, int y2)
 // --- clipping
 
 void Fl_Xlib_Graphics_Driver::push_clip(int x, int y, int w, int h) {
-  Fl_Region r;
-  if (w > 0 && h > 0) {
-    r = XRectangleRegion(x, y, w, h); // does X coordinate clipping
-    Fl_Region current = rstack[rstackptr];
-    if (current) {
+  if (rstackptr >= region_stack_max) {
+    Fl::warning("Fl_Xlib_Graphics_Driver::push_clip: clip stack overflow!\n");
+    restore_clip();
+    return;
+  }
+  Fl_Region current = rstack[rstackptr];
+  if (!current || is_rect_clip_[rstackptr]) {
+    // the clip stays a rectangle: no Region is needed
+    if (clip_rect(x, y, w, h)) x = y = w = h = 0; // does X coordinate clipping
+    if (is_rect_clip_[rstackptr]) {
+      const Clip_Rect &c = clip_rect_[rstackptr];
+      int r = x + w, b = y + h;
+      if (x < c.x) x = c.x;
+      if (y < c.y) y = c.y;
+      if (r > c.x + c.w) r = c.x + c.w;
+      if (b > c.y + c.h) b = c.y + c.h;
+      w = r - x; h = b - y;
+      if (w <= 0 || h <= 0) x = y = w = h = 0;
+    }
+    rstack[++rstackptr] = 0;
+    is_rect_clip_[rstackptr] = 1;
+    Clip_Rect &c = clip_rect_[rstackptr];
+    c.x = x; c.y = y; c.w = w; c.h = h;
+  } else {
+    Fl_Region r;
+    if (w > 0 && h > 0) {
+      r = XRectangleRegion(x, y, w, h); // does X coordinate clipping
       Fl_Region temp = XCreateRegion();
       XIntersectRegion(current, r, temp);
       XDestroyRegion(r);
       r = temp;
+    } else { // make empty clip region:
+      r = XCreateRegion();
     }
-  } else { // make empty clip region:
-    r = XCreateRegion();
+    rstack[++rstackptr] = r;
   }
-  if (rstackptr < region_stack_max) rstack[++rstackptr] = r;
-  else Fl::warning("Fl_Xlib_Graphics_Driver::push_clip: clip stack overflow!\n");
   restore_clip();
 }
 
+void Fl_Xlib_Graphics_Driver::push_no_clip() {
+  if (rstackptr < region_stack_max) is_rect_clip_[rstackptr + 1] = 0;
+  Fl_Graphics_Driver::push_no_clip();
+}
+
+void Fl_Xlib_Graphics_Driver::pop_clip() {
+  if (rstackptr > 0) is_rect_clip_[rstackptr] = 0;
+  Fl_Graphics_Driver::pop_clip();
+}
+
+Fl_Region Fl_Xlib_Graphics_Driver::clip_region() {
+  if (is_rect_clip_[rstackptr] && !rstack[rstackptr]) {
+    const Clip_Rect &c = clip_rect_[rstackptr];
+    rstack[rstackptr] = XRectangleRegion(c.x, c.y, c.w, c.h);
+  }
+  return rstack[rstackptr];
+}
+
+void Fl_Xlib_Graphics_Driver::clip_region(Fl_Region r) {
+  // a region made of one rectangle, e.g. the damage of a window, is also
+  // a rectangle clip so that clips pushed inside it need no Region
+  is_rect_clip_[rstackptr] = (r && r->numRects == 1);
+  if (is_rect_clip_[rstackptr]) {
+    Clip_Rect &c = clip_rect_[rstackptr];
+    c.x = r->extents.x1; c.y = r->extents.y1;
+    c.w = r->extents.x2 - c.x; c.h = r->extents.y2 - c.y;
+  }
+  Fl_Graphics_Driver::clip_region(r);
+}
+
 int Fl_Xlib_Graphics_Driver::clip_box(int x, int y, int w, int h, int& X, int& Y, int& W, int& H) {
   X = x; Y = y; W = w; H = h;
+  if (is_rect_clip_[rstackptr]) {
+    const Clip_Rect &c = clip_rect_[rstackptr];
+    int r = x + w, b = y + h;
+    if (x >= c.x && y >= c.y && r <= c.x + c.w && b <= c.y + c.h) return 0; // completely inside
+    if (X < c.x) X = c.x;
+    if (Y < c.y) Y = c.y;
+    if (r > c.x + c.w) r = c.x + c.w;
+    if (b > c.y + c.h) b = c.y + c.h;
+    W = r - X; H = b - Y;
+    if (W <= 0 || H <= 0) { // completely outside
+      W = H = 0;
+      return 2;
+    }
+    return 1;
+  }
   Fl_Region r = rstack[rstackptr];
   if (!r) return 0;
   switch (XRectInRegion(r, x, y, w, h)) {
@@ -388,9 +454,15 @@ int Fl_Xlib_Graphics_Driver::clip_box(int x, int y, int w, int h, int& X, int& Y
 int Fl_Xlib_Graphics_Driver::not_clipped(int x, int y, int w, int h) {
   if (x+w <= 0 || y+h <= 0) return 0;
   Fl_Region r = rstack[rstackptr];
-  if (!r) return 1;
+  if (!r && !is_rect_clip_[rstackptr]) return 1;
   // get rid of coordinates outside the 16-bit range the X calls take.
   if (clip_rect(x,y,w,h)) return 0;     // clipped
+  if (is_rect_clip_[rstackptr]) {
+    const Clip_Rect &c = clip_rect_[rstackptr];
+    if (c.w <= 0 || x >= c.x + c.w || y >= c.y + c.h || x + w <= c.x || y + h <= c.y) return 0;
+    if (x >= c.x && y >= c.y && x + w <= c.x + c.w && y + h <= c.y + c.h) return RectangleIn;
+    return RectanglePart;
+  }
   return XRectInRegion(r, x, y, w, h);
 }
 
@@ -402,7 +474,38 @@ void Fl_Xlib_Graphics_Driver::restore_clip() {
       Region r2 = scale_clip(scale());
       XSetRegion(fl_display, gc_, rstack[rstackptr]);
       unscale_clip(r2);
+      clip_gc_ = 0;
+    } else if (is_rect_clip_[rstackptr]) {
+      // same rectangle as scale_clip() would compute
+      const Clip_Rect &c = clip_rect_[rstackptr];
+      XRectangle R;
+      float f = scale();
+      if (c.w <= 0) {
+        R.x = R.y = 0; R.width = R.height = 0;
+      } else if (f == 1 && offset_x_ == 0 && offset_y_ == 0) {
+        R.x = c.x; R.y = c.y; R.width = c.w; R.height = c.h;
+      } else {
+        int deltaf = f/2;
+        int x = (c.x + offset_x_)*f;
+        int y = (c.y + offset_y_)*f;
+        int w = int((c.x + c.w + offset_x_) * f) - x;
+        int h = int((c.y + c.h + offset_y_) * f) - y;
+        x += line_delta_ - deltaf;
+        y += line_delta_ - deltaf;
+        if (clip_rect(x, y, w, h)) x = y = w = h = 0;
+        R.x = x; R.y = y; R.width = w; R.height = h;
+      }
+      if (clip_gc_ == gc_ && clip_gc_set_ && R.x == clip_gc_rect_.x && R.y == clip_gc_rect_.y &&
+          R.width == clip_gc_rect_.width && R.height == clip_gc_rect_.height) return;
+      XSetClipRectangles(fl_display, gc_, 0, 0, &R, R.width ? 1 : 0, YXBanded);
+      clip_gc_ = gc_;
+      clip_gc_set_ = 1;
+      clip_gc_rect_ = R;
+    } else {
+      if (clip_gc_ == gc_ && !clip_gc_set_) return;
+      XSetClipMask(fl_display, gc_, 0);
+      clip_gc_ = gc_;
+      clip_gc_set_ = 0;
     }
-    else XSetClipMask(fl_display, gc_, 0);
   }
 }
@@ -26,6 +26,165 @@
 #include <FL/fl_draw.H>
 #include <FL/platform.H>
 #include <FL/math.h>
+#if HAVE_XRENDER
+#include <FL/Fl_Window.H>
+#include "../../Fl_Scanline_Rasterizer.H"
+#include <X11/extensions/Xrender.h>
+#include <stdlib.h>
+#include <string.h>
+#endif
+
+#if HAVE_XRENDER
+
+void Fl_Xlib_Graphics_Driver::antialias(int state) {
+  antialias_ = (state && fl_can_do_alpha_blending());
+}
+
+int Fl_Xlib_Graphics_Driver::antialias() {
+  return antialias_;
+}
+
+// Store the unrounded vertices of the current path for anti-aliased drawing
+void Fl_Xlib_Graphics_Driver::add_fvertex(float x, float y) {
+  if (fn_ && x == fp_[2*fn_-2] && y == fp_[2*fn_-1]) return;
+  if (fn_ >= fp_size_) {
+    fp_size_ = fp_ ? 2*fp_size_ : 16;
+    fp_ = (float*)realloc((void*)fp_, 2*fp_size_*sizeof(float));
+  }
+  fp_[2*fn_] = x;
+  fp_[2*fn_+1] = y;
+  fn_++;
+}
+
+// Add the vertices of an elliptical arc from a1 to a2 degrees, counter-clockwise
+// from 3 o'clock, with the same precision as fl_arc(x, y, r, start, end)
+void Fl_Xlib_Graphics_Driver::arc_fvertices(float cx, float cy, float rx, float ry, double a1, double a2) {
+  double r = rx > ry ? rx : ry;
+  if (r < 2) r = 2;
+  double epsilon = 2*acos(1.0 - 0.125/r);
+  double A1 = a1*(M_PI/180), A = (a2 - a1)*(M_PI/180);
+  int steps = int(ceil(fabs(A)/epsilon));
+  if (steps < 1) steps = 1;
+  for (int i = 0; i <= steps; i++) {
+    double a = A1 + A*i/steps;
+    add_fvertex(float(cx + rx*cos(a)), float(cy - ry*sin(a)));
+  }
+}
+
+// Draw the stored vertices as an anti-aliased line with the current line style
+void Fl_Xlib_Graphics_Driver::stroke_aa(int closed) {
+  if (!rasterizer_) rasterizer_ = new Fl_Scanline_Rasterizer();
+  // a line of width 1 at integer coordinates covers exactly one row or column of pixels
+  for (int i = 0; i < 2*fn_; i++) fp_[i] += 0.5f;
+  rasterizer_->stroke(fp_, fn_, closed, float(line_width_), line_style_ & 0xf00, line_style_ & 0xf000);
+  render_aa(Fl_Scanline_Rasterizer::NON_ZERO);
+}
+
+// Blend the current color into the drawable through the coverage mask of
+// the rasterizer: the mask is uploaded once and composited by XRender.
+// The mask, the fill and the Picture of the drawable are kept for the
+// next call, see release_aa() and destroy_aa_picture().
+void Fl_Xlib_Graphics_Driver::render_aa(int rule) {
+  fn_ = fgap_ = 0;
+  Fl_Region r = scale_clip(scale());
+  Fl_Region clipr = clip_region();
+  int cx = clip_min(), cy = clip_min(), cw = clip_max() - clip_min(), ch = cw;
+  Fl_Window *win = Fl_Window::current();
+  if (clipr) {
+    cx = clipr->extents.x1; cy = clipr->extents.y1;
+    cw = clipr->extents.x2 - cx; ch = clipr->extents.y2 - cy;
+  } else if (win && fl_window == fl_xid(win)) {
+    cx = cy = 0;
+    cw = int(win->w() * scale()); ch = int(win->h() * scale());
+  }
+  int X, Y, W, H;
+  const uchar *mask = rasterizer_->render(rule, cx, cy, cw, ch, X, Y, W, H);
+  if (mask) {
+    if (W > aa_mask_w_ || H > aa_mask_h_) {
+      if (aa_mask_) {
+        XRenderFreePicture(fl_display, aa_mask_picture_);
+        XFreePixmap(fl_display, aa_mask_);
+      }
+      if (W > aa_mask_w_) aa_mask_w_ = W;
+      if (H > aa_mask_h_) aa_mask_h_ = H;
+      aa_mask_ = XCreatePixmap(fl_display, RootWindow(fl_display, fl_screen), aa_mask_w_, aa_mask_h_, 8);
+      if (!aa_mask_gc_) aa_mask_gc_ = XCreateGC(fl_display, aa_mask_, 0, 0);
+      aa_mask_picture_ = XRenderCreatePicture(fl_display, aa_mask_,
+                                              XRenderFindStandardFormat(fl_display, PictStandardA8), 0, 0);
+    }
+    XImage img;
+    memset(&img, 0, sizeof(img));
+    img.width = W;
+    img.height = H;
+    img.format = ZPixmap;
+    img.data = (char*)mask;
+    img.byte_order = ImageByteOrder(fl_display);
+    img.bitmap_unit = img.bitmap_pad = img.depth = img.bits_per_pixel = 8;
+    img.bitmap_bit_order = MSBFirst;
+    img.bytes_per_line = W;
+    XInitImage(&img);
+    XPutImage(fl_display, aa_mask_, aa_mask_gc_, &img, 0, 0, 0, 0, W, H);
+
+    uchar red, green, blue;
+    Fl::get_color(color(), red, green, blue);
+    unsigned rgb = (red << 16) | (green << 8) | blue;
+    if (!aa_fill_picture_ || rgb != aa_fill_rgb_) {
+      if (aa_fill_picture_) XRenderFreePicture(fl_display, aa_fill_picture_);
+      XRenderColor c = {(unsigned short)(red * 257), (unsigned short)(green * 257),
+                        (unsigned short)(blue * 257), 0xffff};
+      aa_fill_picture_ = XRenderCreateSolidFill(fl_display, &c);
+      aa_fill_rgb_ = rgb;
+    }
+    if (!aa_dst_picture_ || aa_dst_ != fl_window) {
+      if (aa_dst_picture_) XRenderFreePicture(fl_display, aa_dst_picture_);
+      static XRenderPictFormat *dstfmt = XRenderFindVisualFormat(fl_display, fl_visual->visual);
+      aa_dst_picture_ = XRenderCreatePicture(fl_display, fl_window, dstfmt, 0, 0);
+      aa_dst_ = fl_window;
+    }
+    if (clipr) {
+      XRenderSetPictureClipRegion(fl_display, aa_dst_picture_, clipr);
+    } else {
+      XRenderPictureAttributes pa;
+      pa.clip_mask = None;
+      XRenderChangePicture(fl_display, aa_dst_picture_, CPClipMask, &pa);
+    }
+    XRenderComposite(fl_display, PictOpOver, aa_fill_picture_, aa_mask_picture_, aa_dst_picture_,
+                     0, 0, 0, 0, X, Y, W, H);
+  }
+  unscale_clip(r);
+}
+
+// Free the XRender resources kept by render_aa()
+void Fl_Xlib_Graphics_Driver::release_aa() {
+  if (!fl_display) return;
+  if (aa_mask_) {
+    XRenderFreePicture(fl_display, aa_mask_picture_);
+    XFreePixmap(fl_display, aa_mask_);
+  }
+  if (aa_mask_gc_) XFreeGC(fl_display, aa_mask_gc_);
+  if (aa_fill_picture_) XRenderFreePicture(fl_display, aa_fill_picture_);
+  if (aa_dst_picture_) XRenderFreePicture(fl_display, aa_dst_picture_);
+  aa_mask_ = 0;
+  aa_mask_picture_ = 0;
+  aa_mask_gc_ = 0;
+  aa_mask_w_ = aa_mask_h_ = 0;
+  aa_fill_picture_ = 0;
+  aa_dst_picture_ = 0;
+  aa_dst_ = 0;
+}
+
+/* Frees the Picture kept for drawable \p d, which is about to be destroyed.
+ The X server frees the Pictures of a window itself when it destroys it,
+ so this must be called before the window is destroyed. */
+void Fl_Xlib_Graphics_Driver::destroy_aa_picture(Drawable d) {
+  if (aa_dst_picture_ && aa_dst_ == d) {
+    XRenderFreePicture(fl_display, aa_dst_picture_);
+    aa_dst_picture_ = 0;
+    aa_dst_ = 0;
+  }
+}
+
+#endif // HAVE_XRENDER
 
 
 void Fl_Xlib_Graphics_Driver::end_points() {
@@ -37,10 +196,23 @@ void Fl_Xlib_Graphics_Driver::end_line() {
     end_points();
     return;
   }
+#if HAVE_XRENDER
+  if (antialias_ && !line_dashed_ && fn_ > 1) {
+    stroke_aa(0);
+    return;
+  }
+#endif
   if (n>1) XDrawLines(fl_display, fl_window, gc_, (XPoint*)p, n, 0);
 }
 
 void Fl_Xlib_Graphics_Driver::end_loop() {
+#if HAVE_XRENDER
+  if (antialias_ && !line_dashed_ && n && fn_ > 2) {
+    while (fn_ > 2 && fp_[2*fn_-2] == fp_[0] && fp_[2*fn_-1] == fp_[1]) fn_--;
+    stroke_aa(1);
+    return;
+  }
+#endif
   fixloop();
   if (n>2) {
     transformed_vertex0(p[0].x - line_delta_, p[0].y - line_delta_);
@@ -54,15 +226,33 @@ void Fl_Xlib_Graphics_Driver::end_polygon() {
     end_line();
     return;
   }
+#if HAVE_XRENDER
+  if (antialias_ && fn_ > 2) {
+    if (!rasterizer_) rasterizer_ = new Fl_Scanline_Rasterizer();
+    rasterizer_->add_polygon(fp_, fn_);
+    render_aa(Fl_Scanline_Rasterizer::EVEN_ODD);
+    return;
+  }
+#endif
   if (n>2) XFillPolygon(fl_display, fl_window, gc_, (XPoint*)p, n, Convex, 0);
 }
 
 void Fl_Xlib_Graphics_Driver::begin_complex_polygon() {
   begin_polygon();
   gap_ = 0;
+#if HAVE_XRENDER
+  if (rasterizer_) rasterizer_->clear();
+#endif
 }
 
 void Fl_Xlib_Graphics_Driver::gap() {
+#if HAVE_XRENDER
+  int fn = fn_;
+  if (antialias_ && fn - fgap_ > 2) {
+    if (!rasterizer_) rasterizer_ = new Fl_Scanline_Rasterizer();
+    rasterizer_->add_polygon(fp_ + 2*fgap_, fn - fgap_);
+  }
+#endif
   while (n>gap_+2 && p[n-1].x == p[gap_].x && p[n-1].y == p[gap_].y) n--;
   if (n > gap_+2) {
     transformed_vertex0(p[gap_].x - line_delta_, p[gap_].y - line_delta_);
@@ -70,10 +260,19 @@ void Fl_Xlib_Graphics_Driver::gap() {
   } else {
     n = gap_;
   }
+#if HAVE_XRENDER
+  fn_ = fgap_ = fn; // drop the vertex added above to close the contour
+#endif
 }
 
 void Fl_Xlib_Graphics_Driver::end_complex_polygon() {
   gap();
+#if HAVE_XRENDER
+  if (antialias_ && rasterizer_ && !rasterizer_->empty()) {
+    render_aa(Fl_Scanline_Rasterizer::EVEN_ODD);
+    return;
+  }
+#endif
   if (n < 3) {
     end_line();
     return;
@@ -90,6 +289,21 @@ void Fl_Xlib_Graphics_Driver::ellipse_unscaled(double xt, double yt, double rx,
   int lly = (int)rint(yt-ry);
   int h = (int)rint(yt+ry)-lly;
 
+#if HAVE_XRENDER
+  if (antialias_ && (what == POLYGON || !line_dashed_)) {
+    fn_ = 0;
+    arc_fvertices(float(xt) + line_delta_, float(yt) + line_delta_, float(rx), float(ry), 0, 360);
+    fn_--; // the last vertex repeats the first one
+    if (what == POLYGON) {
+      if (!rasterizer_) rasterizer_ = new Fl_Scanline_Rasterizer();
+      rasterizer_->add_polygon(fp_, fn_);
+      render_aa(Fl_Scanline_Rasterizer::NON_ZERO);
+    } else {
+      stroke_aa(1);
+    }
+    return;
+  }
+#endif
   (what == POLYGON ? XFillArc : XDrawArc)
     (fl_display, fl_window, gc_, llx, lly, w, h, 0, 360*64);
 }
@@ -0,0 +1,266 @@
+//
+// Box tile cache for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2020 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+/**
+  \file fl_box_cache.cxx
+  \brief cache of pre-rendered tiles for the shaded box types.
+*/
+
+#include <FL/Fl.H>
+#include <FL/Fl_Image_Surface.H>
+#include <FL/Fl_Image.H>
+#include <FL/fl_draw.H>
+#include <stdlib.h>
+
+/*
+  Implementation notes:
+
+  The shaded box types of the "gleam", "gtk+" and "plastic" schemes and
+  the round box types draw many lines, arcs and pies with interpolated
+  colors. Their drawing only depends on the height of the box as long as
+  the box is wider than high: the left and right ends hold the corners,
+  and all columns between them are identical.
+
+  Such a box is drawn once at a fixed width into an image surface, and
+  the image is cut in two tiles: the ends (the left and the right k
+  columns, k = h/2 + 4) and a strip of MIDDLE columns. A box of any
+  width w >= 2k is then drawn by copying both ends and repeating the
+  strip. The box is drawn on a black and on a white background, so that
+  the pixels it does not paint (e.g. round corners) become transparent.
+  Tiles that are entirely opaque are stored without alpha channel and
+  are copied without blending.
+
+  A gradient that depends on the height can't be stretched vertically,
+  so boxes that are higher than wide are always drawn directly. So are
+  boxes drawn at a non-integer scale factor, because their pixels then
+  depend on the position of the box, and boxes drawn to other surfaces
+  than the display, e.g. when printing.
+
+  The cache is cleared when a color of the colormap or a box type
+  changes, i.e. by Fl::set_color(), Fl::background(), Fl::scheme()
+  and Fl::set_boxtype().
+*/
+
+#define MIDDLE 128      // width of the repeated strip
+#define MAX_HEIGHT 256  // higher boxes are not cached
+
+int Fl::box_cache_size_ = 64;
+
+struct Box_Tile {
+  Fl_Box_Draw_F *f;     // box drawing function
+  Fl_Color c;           // box color
+  int h;                // box height
+  float s;              // scale factor
+  char active;          // Fl::draw_box_active()
+  char antialias;       // fl_antialias()
+  unsigned used;        // last use, to find the least recently used tile
+  Fl_RGB_Image *ends;   // left and right ends, NULL if the box can't be cached
+  Fl_RGB_Image *middle; // repeated strip
+};
+
+static Box_Tile *tiles = 0;
+static int num_tiles = 0;
+static unsigned use_count = 0;
+
+// Returns an image of the columns x0 to x0+W-1 of the box drawn on black
+// and white, or NULL if the image is not opaque and can't be blended.
+static Fl_RGB_Image *cut_tile(Fl_RGB_Image *black, Fl_RGB_Image *white,
+                              int x0, int W, int fltk_w, int fltk_h) {
+  int d = black->d(), H = black->data_h();
+  int ldb = black->ld() ? black->ld() : black->data_w() * d;
+  int ldw = white->ld() ? white->ld() : white->data_w() * d;
+  const uchar *b0 = (const uchar*)black->data()[0];
+  const uchar *w0 = (const uchar*)white->data()[0];
+  uchar *rgba = new uchar[W * H * 4];
+  uchar *q = rgba;
+  int opaque = 1;
+  for (int y = 0; y < H; y++) {
+    const uchar *b = b0 + y * ldb + x0 * d;
+    const uchar *w = w0 + y * ldw + x0 * d;
+    for (int x = 0; x < W; x++, b += d, w += d, q += 4) {
+      // the difference between both backgrounds is the transparency
+      int diff = 0;
+      for (int i = 0; i < 3; i++) {
+        int di = w[i] - b[i];
+        if (di > diff) diff = di;
+      }
+      int a = 255 - diff;
+      if (a < 255) opaque = 0;
+      for (int i = 0; i < 3; i++) {
+        int v = a ? b[i] * 255 / a : 0;
+        q[i] = uchar(v > 255 ? 255 : v);
+      }
+      q[3] = uchar(a);
+    }
+  }
+  if (!opaque && !fl_can_do_alpha_blending()) {
+    delete[] rgba;
+    return 0;
+  }
+  if (opaque) { // drop the alpha channel
+    uchar *p = rgba;
+    for (int i = 0; i < W * H; i++, p += 3) {
+      p[0] = rgba[4*i]; p[1] = rgba[4*i+1]; p[2] = rgba[4*i+2];
+    }
+  }
+  Fl_RGB_Image *img = new Fl_RGB_Image(rgba, W, H, opaque ? 3 : 4);
+  img->alloc_array = 1;
+  img->scale(fltk_w, fltk_h, 0, 1);
+  return img;
+}
+
+// Draws the box on a surface of 2k + MIDDLE columns and cuts it in tiles
+static void make_tiles(Box_Tile &t, int k) {
+  int W = 2 * k + MIDDLE, H = t.h;
+  Fl_Image_Surface *surf = new Fl_Image_Surface(W, H, 1);
+  Fl_Surface_Device::push_current(surf);
+  fl_antialias(t.antialias);
+  fl_color(0, 0, 0);
+  fl_rectf(0, 0, W, H);
+  t.f(0, 0, W, H, t.c);
+  Fl_RGB_Image *black = surf->image();
+  fl_color(255, 255, 255);
+  fl_rectf(0, 0, W, H);
+  t.f(0, 0, W, H, t.c);
+  Fl_RGB_Image *white = surf->image();
+  Fl_Surface_Device::pop_current();
+  delete surf;
+
+  int s = int(t.s), pk = k * s;
+  t.ends = 0;
+  t.middle = cut_tile(black, white, pk, MIDDLE * s, MIDDLE, H);
+  if (t.middle) {
+    // the ends are cut in two halves and put side by side
+    Fl_RGB_Image *left = cut_tile(black, white, 0, pk, k, H);
+    Fl_RGB_Image *right = cut_tile(black, white, (W - k) * s, pk, k, H);
+    if (left && right) {
+      int d = (left->d() == 4 || right->d() == 4) ? 4 : 3;
+      int ph = black->data_h();
+      uchar *both = new uchar[2 * pk * ph * d];
+      Fl_RGB_Image *half[2] = {left, right};
+      for (int j = 0; j < 2; j++) {
+        int dj = half[j]->d();
+        const uchar *p = (const uchar*)half[j]->data()[0];
+        for (int y = 0; y < ph; y++) {
+          uchar *q = both + (y * 2 * pk + j * pk) * d;
+          for (int x = 0; x < pk; x++, p += dj, q += d) {
+            q[0] = p[0]; q[1] = p[1]; q[2] = p[2];
+            if (d == 4) q[3] = (dj == 4) ? p[3] : 255;
+          }
+        }
+      }
+      t.ends = new Fl_RGB_Image(both, 2 * pk, ph, d);
+      t.ends->alloc_array = 1;
+      t.ends->scale(2 * k, H, 0, 1);
+    }
+    delete left;
+    delete right;
+  }
+  if (!t.ends) {
+    delete t.middle;
+    t.middle = 0;
+  }
+  delete black;
+  delete white;
+}
+
+/**
+  Draws a box with its cached tiles.
+
+  Returns 0 if the box can't be drawn from the cache and must be drawn
+  directly by the caller, otherwise the tiles are created if needed and
+  the box is drawn.
+*/
+int fl_draw_cached_box(Fl_Box_Draw_F *f, int x, int y, int w, int h, Fl_Color c) {
+  if (Fl::box_cache_size() <= 0 || h <= 0 || h > MAX_HEIGHT) return 0;
+  int k = h / 2 + 4;
+  if (w < 2 * k) return 0;
+  if (Fl_Surface_Device::surface() != Fl_Display_Device::display_device()) return 0;
+  float s = fl_graphics_driver->scale();
+  if (s != int(s)) return 0;
+  char active = (char)Fl::draw_box_active();
+  char antialias = (char)(fl_antialias() != 0);
+
+  Box_Tile *t = 0;
+  for (int i = 0; i < num_tiles; i++) {
+    Box_Tile &u = tiles[i];
+    if (u.f == f && u.c == c && u.h == h && u.s == s &&
+        u.active == active && u.antialias == antialias) {
+      t = &u;
+      break;
+    }
+  }
+  if (!t) {
+    if (!tiles) tiles = (Box_Tile*)calloc(Fl::box_cache_size(), sizeof(Box_Tile));
+    if (num_tiles < Fl::box_cache_size()) {
+      t = tiles + num_tiles++;
+    } else { // replace the least recently used tile
+      t = tiles;
+      for (int i = 1; i < num_tiles; i++)
+        if (tiles[i].used < t->used) t = tiles + i;
+      delete t->ends;
+      delete t->middle;
+    }
+    t->f = f; t->c = c; t->h = h; t->s = s;
+    t->active = active; t->antialias = antialias;
+    make_tiles(*t, k);
+  }
+  t->used = ++use_count;
+  if (!t->ends) return 0;
+
+  t->ends->draw(x, y, k, h, 0, 0);
+  t->ends->draw(x + w - k, y, k, h, k, 0);
+  for (int X = x + k; X < x + w - k; X += MIDDLE) {
+    int W = x + w - k - X;
+    t->middle->draw(X, y, W < MIDDLE ? W : MIDDLE, h, 0, 0);
+  }
+  return 1;
+}
+
+/** Removes all tiles from the cache of box tiles. */
+void fl_clear_box_cache() {
+  for (int i = 0; i < num_tiles; i++) {
+    delete tiles[i].ends;
+    delete tiles[i].middle;
+  }
+  num_tiles = 0;
+  use_count = 0;
+}
+
+/**
+  Sets the number of boxes kept in the cache of box tiles.
+
+  The box types of the "gleam", "gtk+" and "plastic" schemes and the
+  round box types draw their shading with many lines and arcs. FLTK
+  keeps pre-rendered tiles of these boxes for the most recently used
+  combinations of box type, color and height, and draws a box by copying
+  these tiles. Each cached box uses about (h + 136) * h * 4 bytes of
+  memory, where h is the box height in pixels.
+
+  Boxes that are higher than wide, higher than 256 pixels, or drawn at a
+  non-integer scale factor are always drawn directly.
+
+  \param[in] n maximum number of cached boxes, 0 disables the cache.
+      The default is 64.
+  \see Fl::box_cache_size()
+  \since 1.4.0
+*/
+void Fl::box_cache_size(int n) {
+  fl_clear_box_cache();
+  free(tiles);
+  tiles = 0;
+  box_cache_size_ = n < 0 ? 0 : n;
+}
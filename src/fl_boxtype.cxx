@@ -28,6 +28,9 @@
 #include <FL/fl_draw.H>
 #include <config.h>
 
+extern int fl_draw_cached_box(Fl_Box_Draw_F *f, int x, int y, int w, int h, Fl_Color c);
+extern void fl_clear_box_cache();
+
 ////////////////////////////////////////////////////////////////
 
 static const uchar active_ramp[24] = {
@@ -286,72 +289,73 @@ static struct {
   Fl_Box_Draw_F *f;
   uchar dx, dy, dw, dh;
   int set;
+  int cached; // drawn with fl_draw_cached_box()
 } fl_box_table[256] = {
 // must match list in Enumerations.H!!!
-  {fl_no_box,           0,0,0,0,1},
-  {fl_flat_box,         0,0,0,0,1}, // FL_FLAT_BOX
-  {fl_up_box,           D1,D1,D2,D2,1},
-  {fl_down_box,         D1,D1,D2,D2,1},
-  {fl_up_frame,         D1,D1,D2,D2,1},
-  {fl_down_frame,       D1,D1,D2,D2,1},
-  {fl_thin_up_box,      1,1,2,2,1},
-  {fl_thin_down_box,    1,1,2,2,1},
-  {fl_thin_up_frame,    1,1,2,2,1},
-  {fl_thin_down_frame,  1,1,2,2,1},
-  {fl_engraved_box,     2,2,4,4,1},
-  {fl_embossed_box,     2,2,4,4,1},
-  {fl_engraved_frame,   2,2,4,4,1},
-  {fl_embossed_frame,   2,2,4,4,1},
-  {fl_border_box,       1,1,2,2,1},
-  {fl_border_box,       1,1,5,5,0}, // _FL_SHADOW_BOX
-  {fl_border_frame,     1,1,2,2,1},
-  {fl_border_frame,     1,1,5,5,0}, // _FL_SHADOW_FRAME
-  {fl_border_box,       1,1,2,2,0}, // _FL_ROUNDED_BOX
-  {fl_border_box,       1,1,2,2,0}, // _FL_RSHADOW_BOX
-  {fl_border_frame,     1,1,2,2,0}, // _FL_ROUNDED_FRAME
-  {fl_flat_box,         0,0,0,0,0}, // _FL_RFLAT_BOX
-  {fl_up_box,           3,3,6,6,0}, // _FL_ROUND_UP_BOX
-  {fl_down_box,         3,3,6,6,0}, // _FL_ROUND_DOWN_BOX
-  {fl_up_box,           0,0,0,0,0}, // _FL_DIAMOND_UP_BOX
-  {fl_down_box,         0,0,0,0,0}, // _FL_DIAMOND_DOWN_BOX
-  {fl_border_box,       1,1,2,2,0}, // _FL_OVAL_BOX
-  {fl_border_box,       1,1,2,2,0}, // _FL_OVAL_SHADOW_BOX
-  {fl_border_frame,     1,1,2,2,0}, // _FL_OVAL_FRAME
-  {fl_flat_box,         0,0,0,0,0}, // _FL_OVAL_FLAT_BOX
-  {fl_up_box,           4,4,8,8,0}, // _FL_PLASTIC_UP_BOX
-  {fl_down_box,         2,2,4,4,0}, // _FL_PLASTIC_DOWN_BOX
-  {fl_up_frame,         2,2,4,4,0}, // _FL_PLASTIC_UP_FRAME
-  {fl_down_frame,       2,2,4,4,0}, // _FL_PLASTIC_DOWN_FRAME
-  {fl_up_box,           2,2,4,4,0}, // _FL_PLASTIC_THIN_UP_BOX
-  {fl_down_box,         2,2,4,4,0}, // _FL_PLASTIC_THIN_DOWN_BOX
-  {fl_up_box,           2,2,4,4,0}, // _FL_PLASTIC_ROUND_UP_BOX
-  {fl_down_box,         2,2,4,4,0}, // _FL_PLASTIC_ROUND_DOWN_BOX
-  {fl_up_box,           2,2,4,4,0}, // _FL_GTK_UP_BOX
-  {fl_down_box,         2,2,4,4,0}, // _FL_GTK_DOWN_BOX
-  {fl_up_frame,         2,2,4,4,0}, // _FL_GTK_UP_FRAME
-  {fl_down_frame,       2,2,4,4,0}, // _FL_GTK_DOWN_FRAME
-  {fl_up_frame,         1,1,2,2,0}, // _FL_GTK_THIN_UP_FRAME
-  {fl_down_frame,       1,1,2,2,0}, // _FL_GTK_THIN_DOWN_FRAME
-  {fl_up_box,           1,1,2,2,0}, // _FL_GTK_THIN_ROUND_UP_BOX
-  {fl_down_box,         1,1,2,2,0}, // _FL_GTK_THIN_ROUND_DOWN_BOX
-  {fl_up_box,           2,2,4,4,0}, // _FL_GTK_ROUND_UP_BOX
-  {fl_down_box,         2,2,4,4,0}, // _FL_GTK_ROUND_DOWN_BOX
-  {fl_up_box,           2,2,4,4,0}, // _FL_GLEAM_UP_BOX
-  {fl_down_box,         2,2,4,4,0}, // _FL_GLEAM_DOWN_BOX
-  {fl_up_frame,         2,2,4,4,0}, // _FL_GLEAM_UP_FRAME
-  {fl_down_frame,       2,2,4,4,0}, // _FL_GLEAM_DOWN_FRAME
-  {fl_up_box,           2,2,4,4,0}, // _FL_GLEAM_THIN_UP_BOX
-  {fl_down_box,         2,2,4,4,0}, // _FL_GLEAM_THIN_DOWN_BOX
-  {fl_up_box,           2,2,4,4,0}, // _FL_GLEAM_ROUND_UP_BOX
-  {fl_down_box,         2,2,4,4,0}, // _FL_GLEAM_ROUND_DOWN_BOX
-  {fl_up_box,           3,3,6,6,0}, // FL_FREE_BOX+0
-  {fl_down_box,         3,3,6,6,0}, // FL_FREE_BOX+1
-  {fl_up_box,           3,3,6,6,0}, // FL_FREE_BOX+2
-  {fl_down_box,         3,3,6,6,0}, // FL_FREE_BOX+3
-  {fl_up_box,           3,3,6,6,0}, // FL_FREE_BOX+4
-  {fl_down_box,         3,3,6,6,0}, // FL_FREE_BOX+5
-  {fl_up_box,           3,3,6,6,0}, // FL_FREE_BOX+6
-  {fl_down_box,         3,3,6,6,0}  // FL_FREE_BOX+7
+  {fl_no_box,           0,0,0,0,1,0},
+  {fl_flat_box,         0,0,0,0,1,0}, // FL_FLAT_BOX
+  {fl_up_box,           D1,D1,D2,D2,1,0},
+  {fl_down_box,         D1,D1,D2,D2,1,0},
+  {fl_up_frame,         D1,D1,D2,D2,1,0},
+  {fl_down_frame,       D1,D1,D2,D2,1,0},
+  {fl_thin_up_box,      1,1,2,2,1,0},
+  {fl_thin_down_box,    1,1,2,2,1,0},
+  {fl_thin_up_frame,    1,1,2,2,1,0},
+  {fl_thin_down_frame,  1,1,2,2,1,0},
+  {fl_engraved_box,     2,2,4,4,1,0},
+  {fl_embossed_box,     2,2,4,4,1,0},
+  {fl_engraved_frame,   2,2,4,4,1,0},
+  {fl_embossed_frame,   2,2,4,4,1,0},
+  {fl_border_box,       1,1,2,2,1,0},
+  {fl_border_box,       1,1,5,5,0,0}, // _FL_SHADOW_BOX
+  {fl_border_frame,     1,1,2,2,1,0},
+  {fl_border_frame,     1,1,5,5,0,0}, // _FL_SHADOW_FRAME
+  {fl_border_box,       1,1,2,2,0,0}, // _FL_ROUNDED_BOX
+  {fl_border_box,       1,1,2,2,0,0}, // _FL_RSHADOW_BOX
+  {fl_border_frame,     1,1,2,2,0,0}, // _FL_ROUNDED_FRAME
+  {fl_flat_box,         0,0,0,0,0,0}, // _FL_RFLAT_BOX
+  {fl_up_box,           3,3,6,6,0,0}, // _FL_ROUND_UP_BOX
+  {fl_down_box,         3,3,6,6,0,0}, // _FL_ROUND_DOWN_BOX
+  {fl_up_box,           0,0,0,0,0,0}, // _FL_DIAMOND_UP_BOX
+  {fl_down_box,         0,0,0,0,0,0}, // _FL_DIAMOND_DOWN_BOX
+  {fl_border_box,       1,1,2,2,0,0}, // _FL_OVAL_BOX
+  {fl_border_box,       1,1,2,2,0,0}, // _FL_OVAL_SHADOW_BOX
+  {fl_border_frame,     1,1,2,2,0,0}, // _FL_OVAL_FRAME
+  {fl_flat_box,         0,0,0,0,0,0}, // _FL_OVAL_FLAT_BOX
+  {fl_up_box,           4,4,8,8,0,0}, // _FL_PLASTIC_UP_BOX
+  {fl_down_box,         2,2,4,4,0,0}, // _FL_PLASTIC_DOWN_BOX
+  {fl_up_frame,         2,2,4,4,0,0}, // _FL_PLASTIC_UP_FRAME
+  {fl_down_frame,       2,2,4,4,0,0}, // _FL_PLASTIC_DOWN_FRAME
+  {fl_up_box,           2,2,4,4,0,0}, // _FL_PLASTIC_THIN_UP_BOX
+  {fl_down_box,         2,2,4,4,0,0}, // _FL_PLASTIC_THIN_DOWN_BOX
+  {fl_up_box,           2,2,4,4,0,0}, // _FL_PLASTIC_ROUND_UP_BOX
+  {fl_down_box,         2,2,4,4,0,0}, // _FL_PLASTIC_ROUND_DOWN_BOX
+  {fl_up_box,           2,2,4,4,0,0}, // _FL_GTK_UP_BOX
+  {fl_down_box,         2,2,4,4,0,0}, // _FL_GTK_DOWN_BOX
+  {fl_up_frame,         2,2,4,4,0,0}, // _FL_GTK_UP_FRAME
+  {fl_down_frame,       2,2,4,4,0,0}, // _FL_GTK_DOWN_FRAME
+  {fl_up_frame,         1,1,2,2,0,0}, // _FL_GTK_THIN_UP_FRAME
+  {fl_down_frame,       1,1,2,2,0,0}, // _FL_GTK_THIN_DOWN_FRAME
+  {fl_up_box,           1,1,2,2,0,0}, // _FL_GTK_THIN_ROUND_UP_BOX
+  {fl_down_box,         1,1,2,2,0,0}, // _FL_GTK_THIN_ROUND_DOWN_BOX
+  {fl_up_box,           2,2,4,4,0,0}, // _FL_GTK_ROUND_UP_BOX
+  {fl_down_box,         2,2,4,4,0,0}, // _FL_GTK_ROUND_DOWN_BOX
+  {fl_up_box,           2,2,4,4,0,0}, // _FL_GLEAM_UP_BOX
+  {fl_down_box,         2,2,4,4,0,0}, // _FL_GLEAM_DOWN_BOX
+  {fl_up_frame,         2,2,4,4,0,0}, // _FL_GLEAM_UP_FRAME
+  {fl_down_frame,       2,2,4,4,0,0}, // _FL_GLEAM_DOWN_FRAME
+  {fl_up_box,           2,2,4,4,0,0}, // _FL_GLEAM_THIN_UP_BOX
+  {fl_down_box,         2,2,4,4,0,0}, // _FL_GLEAM_THIN_DOWN_BOX
+  {fl_up_box,           2,2,4,4,0,0}, // _FL_GLEAM_ROUND_UP_BOX
+  {fl_down_box,         2,2,4,4,0,0}, // _FL_GLEAM_ROUND_DOWN_BOX
+  {fl_up_box,           3,3,6,6,0,0}, // FL_FREE_BOX+0
+  {fl_down_box,         3,3,6,6,0,0}, // FL_FREE_BOX+1
+  {fl_up_box,           3,3,6,6,0,0}, // FL_FREE_BOX+2
+  {fl_down_box,         3,3,6,6,0,0}, // FL_FREE_BOX+3
+  {fl_up_box,           3,3,6,6,0,0}, // FL_FREE_BOX+4
+  {fl_down_box,         3,3,6,6,0,0}, // FL_FREE_BOX+5
+  {fl_up_box,           3,3,6,6,0,0}, // FL_FREE_BOX+6
+  {fl_down_box,         3,3,6,6,0,0}  // FL_FREE_BOX+7
 };
 
 /**
@@ -409,6 +413,21 @@ void fl_internal_boxtype(Fl_Boxtype t, Fl_Box_Draw_F* f) {
   }
 }
 
+/**
+  Sets the drawing function for a given box type, and draws the box type
+  with the tiles of the box cache.
+  \param[in] t box type
+  \param[in] f box drawing function
+  \see Fl::box_cache_size(int)
+*/
+void fl_internal_cached_boxtype(Fl_Boxtype t, Fl_Box_Draw_F* f) {
+  if (!fl_box_table[t].set) {
+    fl_box_table[t].f      = f;
+    fl_box_table[t].set    = 1;
+    fl_box_table[t].cached = 1;
+  }
+}
+
 /** Gets the current box drawing function for the specified box type. */
 Fl_Box_Draw_F *Fl::get_boxtype(Fl_Boxtype t) {
   return fl_box_table[t].f;
@@ -418,14 +437,17 @@ void Fl::set_boxtype(Fl_Boxtype t, Fl_Box_Draw_F* f,
                       uchar a, uchar b, uchar c, uchar d) {
   fl_box_table[t].f   = f;
   fl_box_table[t].set = 1;
+  fl_box_table[t].cached = 0;
   fl_box_table[t].dx  = a;
   fl_box_table[t].dy  = b;
   fl_box_table[t].dw  = c;
   fl_box_table[t].dh  = d;
+  fl_clear_box_cache();
 }
 /** Copies the from boxtype. */
 void Fl::set_boxtype(Fl_Boxtype to, Fl_Boxtype from) {
   fl_box_table[to] = fl_box_table[from];
+  fl_clear_box_cache();
 }
 
 /**
@@ -435,7 +457,10 @@ void Fl::set_boxtype(Fl_Boxtype to, Fl_Boxtype from) {
   \param[in] c color
 */
 void fl_draw_box(Fl_Boxtype t, int x, int y, int w, int h, Fl_Color c) {
-  if (t && fl_box_table[t].f) fl_box_table[t].f(x,y,w,h,c);
+  if (t && fl_box_table[t].f) {
+    if (fl_box_table[t].cached && fl_draw_cached_box(fl_box_table[t].f, x, y, w, h, c)) return;
+    fl_box_table[t].f(x,y,w,h,c);
+  }
 }
 
 //extern Fl_Widget *fl_boxcheat; // hack set by Fl_Window.cxx
@@ -462,6 +487,7 @@ void Fl_Widget::draw_box(Fl_Boxtype t, Fl_Color c) const {
 /** Draws a box of type t, of color c at the position X,Y and size W,H. */
 void Fl_Widget::draw_box(Fl_Boxtype t, int X, int Y, int W, int H, Fl_Color c) const {
   draw_it_active = active_r();
-  fl_box_table[t].f(X, Y, W, H, c);
+  if (!fl_box_table[t].cached || !fl_draw_cached_box(fl_box_table[t].f, X, Y, W, H, c))
+    fl_box_table[t].f(X, Y, W, H, c);
   draw_it_active = 1;
 }
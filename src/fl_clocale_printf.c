@@ -0,0 +1,260 @@
+/*
+ * Locale independent number formatting for the Fast Light Tool Kit (FLTK).
+ *
+ * Copyright 1998-2020 by Bill Spitzak and others.
+ *
+ * This library is free software. Distribution and use rights are outlined in
+ * the file "COPYING" which should have been included with this file.  If this
+ * file is missing or damaged, see the license at:
+ *
+ *     https://www.fltk.org/COPYING.php
+ *
+ * Please see the following page on how to report bugs and issues:
+ *
+ *     https://www.fltk.org/bugs.php
+ */
+
+#include "flstring.h"
+#include <locale.h>
+#include <math.h>
+#include <stdlib.h>
+
+/*
+ * Powers of 10 used to round numbers to a given number of decimals.
+ */
+
+static const double pow10_[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9
+};
+
+static const double bounds_[] = {       /* 10^(e+1) for e = -4 to 4 */
+  1e-3, 1e-2, 1e-1, 1e0, 1e1, 1e2, 1e3, 1e4, 1e5
+};
+
+
+/*
+ * 'round_()' - Round a positive number to an integer, or return 0 if it is
+ *              too close to a tie to know how the C library rounds it.
+ */
+
+static int
+round_(double r,                        /* I - Number to round */
+       double *m) {                     /* O - Rounded number */
+  double f = floor(r);
+  double d = r - f - 0.5;
+  if (d > -1e-12 * (r + 1) && d < 1e-12 * (r + 1)) return 0;
+  *m = d > 0 ? f + 1 : f;
+  return 1;
+}
+
+
+/*
+ * 'put_digits()' - Write an unsigned integer with n decimals, removing
+ *                  trailing zeros of the decimals if strip is set.
+ */
+
+static char *
+put_digits(char          *p,            /* O - Output buffer */
+           unsigned long m,             /* I - Value times 10^n */
+           int           n,             /* I - Number of decimals */
+           int           strip) {       /* I - Remove trailing zeros? */
+  char  tmp[32];                        /* Digits in reverse order */
+  int   i = 0;
+
+  do {
+    tmp[i++] = (char)('0' + m % 10);
+    m /= 10;
+  } while (m || i <= n);
+
+  if (strip) {
+    int z = 0;
+    while (z < n && tmp[z] == '0') z++;
+    if (z == n) { /* no decimals left */
+      while (i > n) *p++ = tmp[--i];
+      return p;
+    }
+    while (i > n) *p++ = tmp[--i];
+    *p++ = '.';
+    while (i > z) *p++ = tmp[--i];
+    return p;
+  }
+
+  while (i > n) *p++ = tmp[--i];
+  if (n) *p++ = '.';
+  while (i > 0) *p++ = tmp[--i];
+  return p;
+}
+
+
+/*
+ * 'put_g()' - Write a double like "%g" does, or return NULL if the value
+ *             needs the exponential notation.
+ */
+
+static char *
+put_g(char   *p,                        /* O - Output buffer */
+      double v) {                       /* I - Value */
+  int           e;                      /* Decimal exponent */
+  int           n;                      /* Number of decimals */
+  double        m;                      /* Rounded value times 10^n */
+
+  if (v == 0) {
+    if (1 / v < 0) *p++ = '-';
+    *p++ = '0';
+    return p;
+  }
+  if (v < 0) {
+    *p++ = '-';
+    v = -v;
+  }
+  if (!(v >= 1e-4 && v < 999999.5)) return NULL; /* also catches NaN */
+
+  /* "%g" writes 6 significant digits */
+  for (e = -4; e < 5 && v >= bounds_[e + 4]; e++) {/*empty*/}
+  n = 5 - e;
+  if (!round_(v * pow10_[n], &m)) return NULL;
+  if (m >= 1e6 && n > 0) { /* rounding added a digit */
+    n--;
+    if (!round_(v * pow10_[n], &m)) return NULL;
+  }
+  return put_digits(p, (unsigned long)m, n, 1);
+}
+
+
+/*
+ * 'put_f()' - Write a double like "%.nf" does, or return NULL if it is
+ *             too large.
+ */
+
+static char *
+put_f(char   *p,                        /* O - Output buffer */
+      double v,                         /* I - Value */
+      int    n) {                       /* I - Number of decimals */
+  double        m;                      /* Rounded value times 10^n */
+
+  if (v < 0 || (v == 0 && 1 / v < 0)) {
+    *p++ = '-';
+    v = -v;
+  }
+  if (!(v < 4e9 / pow10_[n])) return NULL; /* also catches NaN */
+  if (!round_(v * pow10_[n], &m)) return NULL;
+  return put_digits(p, (unsigned long)m, n, 0);
+}
+
+
+/*
+ * 'fl_clocale_vsnprintf()' - Format a string with '.' as the decimal point,
+ *                            whatever the current locale is.
+ *
+ * Supports the conversions %d, %i, %u, %x, %c, %s, %g, %f and %.nf, with
+ * optional flags and field width, which are all that the PostScript and
+ * SVG drivers use. Common numbers are formatted without calling the C
+ * library. Returns the length of the output, or -1 if the format has
+ * other conversions or the output does not fit in the buffer. The caller
+ * must then use another method.
+ */
+
+int                                     /* O - Length of output or -1 */
+fl_clocale_vsnprintf(char       *buffer,/* O - Output buffer */
+                     size_t     bufsize,/* I - Size of output buffer */
+                     const char *format,/* I - printf-style format string */
+                     va_list    ap) {   /* I - Arguments */
+  char          *p = buffer;            /* Current position in buffer */
+  char          *end = buffer + bufsize;/* End of buffer */
+  char          spec[32];               /* Conversion specification */
+  char          tmp[64];                /* Formatted number */
+
+  while (*format) {
+    const char  *start;                 /* Start of conversion */
+    char        *q;                     /* End of formatted value */
+    int         simple;                 /* No flags or width */
+    int         prec = -1;              /* Precision */
+    size_t      len;
+
+    if (p + 64 > end) return -1;        /* keep room for any number */
+    if (*format != '%') {
+      *p++ = *format++;
+      continue;
+    }
+    if (format[1] == '%') {
+      *p++ = '%';
+      format += 2;
+      continue;
+    }
+
+    start = format++;
+    while (*format && strchr("-+ #0", *format)) format++;
+    while (*format >= '0' && *format <= '9') format++;
+    simple = (format == start + 1);
+    if (*format == '.') {
+      format++;
+      prec = 0;
+      while (*format >= '0' && *format <= '9') prec = prec * 10 + *format++ - '0';
+    }
+    if (!*format || !strchr("diuxcsgf", *format)) return -1;
+    len = (size_t)(format - start + 1);
+    if (len >= sizeof(spec)) return -1;
+    memcpy(spec, start, len);
+    spec[len] = '\0';
+
+    q = NULL;
+    switch (*format++) {
+      case 'd' :
+      case 'i' : {
+        int v = va_arg(ap, int);
+        if (simple && prec < 0) {
+          unsigned long u = v < 0 ? 0UL - (unsigned long)v : (unsigned long)v;
+          q = tmp;
+          if (v < 0) *q++ = '-';
+          q = put_digits(q, u, 0, 0);
+        } else
+          q = tmp + snprintf(tmp, sizeof(tmp), spec, v);
+        break;
+      }
+      case 'u' :
+      case 'x' :
+      case 'c' :
+        q = tmp + snprintf(tmp, sizeof(tmp), spec, va_arg(ap, unsigned));
+        break;
+      case 's' : {
+        const char *s = va_arg(ap, const char *);
+        int n = snprintf(p, (size_t)(end - p), spec, s);
+        if (n < 0 || p + n >= end) return -1;
+        p += n;
+        continue;
+      }
+      case 'g' :
+      case 'f' : {
+        double v = va_arg(ap, double);
+        if (simple && format[-1] == 'g' && prec < 0)
+          q = put_g(tmp, v);
+        else if (simple && format[-1] == 'f' && prec <= 9)
+          q = put_f(tmp, v, prec < 0 ? 6 : prec);
+        if (!q) {
+          /* use the C library and replace the decimal point of the locale */
+          const char *dp = localeconv()->decimal_point;
+          int n = snprintf(tmp, sizeof(tmp), spec, v);
+          if (n < 0 || n >= (int)sizeof(tmp)) return -1;
+          q = tmp + n;
+          if (dp && strcmp(dp, ".")) {
+            char *d = strstr(tmp, dp);
+            if (d) {
+              size_t dl = strlen(dp);
+              *d = '.';
+              memmove(d + 1, d + dl, (size_t)(q - d - dl) + 1);
+              q -= dl - 1;
+            }
+          }
+        }
+        break;
+      }
+    }
+    if (q - tmp >= end - p) return -1;
+    memcpy(p, tmp, (size_t)(q - tmp));
+    p += q - tmp;
+  }
+
+  if (p >= end) return -1;
+  *p = '\0';
+  return (int)(p - buffer);
+}
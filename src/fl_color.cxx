@@ -33,6 +33,8 @@ unsigned fl_cmap[256] = {
 #include "fl_cmap.h" // this is a file produced by "cmap.cxx":
 };
 
+extern void fl_clear_box_cache();
+
 // -----------------------------------------------------------------------------
 // all driver code is now in drivers/XXX/Fl_XXX_Graphics_Driver_xyz.cxx
 // -----------------------------------------------------------------------------
@@ -68,6 +70,7 @@ void Fl::set_color(Fl_Color i, uchar red, uchar green, uchar blue) {
 void Fl::set_color(Fl_Color i, unsigned c)
 {
   Fl_Graphics_Driver::default_driver().set_color(i, c);
+  fl_clear_box_cache(); // the box tiles may use this color
 }
 
 
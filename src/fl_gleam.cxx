@@ -165,15 +165,16 @@ static void thin_down_box(int x, int y, int w, int h, Fl_Color c) {
 }
 
 extern void fl_internal_boxtype(Fl_Boxtype, Fl_Box_Draw_F*);
+extern void fl_internal_cached_boxtype(Fl_Boxtype, Fl_Box_Draw_F*);
 
 Fl_Boxtype fl_define_FL_GLEAM_UP_BOX() {
-  fl_internal_boxtype(_FL_GLEAM_UP_BOX, up_box);
-  fl_internal_boxtype(_FL_GLEAM_DOWN_BOX, down_box);
+  fl_internal_cached_boxtype(_FL_GLEAM_UP_BOX, up_box);
+  fl_internal_cached_boxtype(_FL_GLEAM_DOWN_BOX, down_box);
   fl_internal_boxtype(_FL_GLEAM_UP_FRAME, up_frame);
   fl_internal_boxtype(_FL_GLEAM_DOWN_FRAME, down_frame);
-  fl_internal_boxtype(_FL_GLEAM_THIN_UP_BOX, thin_up_box);
-  fl_internal_boxtype(_FL_GLEAM_THIN_DOWN_BOX, thin_down_box);
-  fl_internal_boxtype(_FL_GLEAM_ROUND_UP_BOX, up_box);
-  fl_internal_boxtype(_FL_GLEAM_ROUND_DOWN_BOX, down_box);
+  fl_internal_cached_boxtype(_FL_GLEAM_THIN_UP_BOX, thin_up_box);
+  fl_internal_cached_boxtype(_FL_GLEAM_THIN_DOWN_BOX, thin_down_box);
+  fl_internal_cached_boxtype(_FL_GLEAM_ROUND_UP_BOX, up_box);
+  fl_internal_cached_boxtype(_FL_GLEAM_ROUND_DOWN_BOX, down_box);
   return _FL_GLEAM_UP_BOX;
 }
@@ -25,6 +25,7 @@
 #include <FL/fl_draw.H>
 
 extern void fl_internal_boxtype(Fl_Boxtype, Fl_Box_Draw_F*);
+extern void fl_internal_cached_boxtype(Fl_Boxtype, Fl_Box_Draw_F*);
 
 
 static void gtk_color(Fl_Color c) {
@@ -271,16 +272,16 @@ static void gtk_round_down_box(int x, int y, int w, int h, Fl_Color c) {
 #endif
 
 Fl_Boxtype fl_define_FL_GTK_UP_BOX() {
-  fl_internal_boxtype(_FL_GTK_UP_BOX, gtk_up_box);
-  fl_internal_boxtype(_FL_GTK_DOWN_BOX, gtk_down_box);
+  fl_internal_cached_boxtype(_FL_GTK_UP_BOX, gtk_up_box);
+  fl_internal_cached_boxtype(_FL_GTK_DOWN_BOX, gtk_down_box);
   fl_internal_boxtype(_FL_GTK_UP_FRAME, gtk_up_frame);
   fl_internal_boxtype(_FL_GTK_DOWN_FRAME, gtk_down_frame);
-  fl_internal_boxtype(_FL_GTK_THIN_UP_BOX, gtk_thin_up_box);
-  fl_internal_boxtype(_FL_GTK_THIN_DOWN_BOX, gtk_thin_down_box);
+  fl_internal_cached_boxtype(_FL_GTK_THIN_UP_BOX, gtk_thin_up_box);
+  fl_internal_cached_boxtype(_FL_GTK_THIN_DOWN_BOX, gtk_thin_down_box);
   fl_internal_boxtype(_FL_GTK_THIN_UP_FRAME, gtk_thin_up_frame);
   fl_internal_boxtype(_FL_GTK_THIN_DOWN_FRAME, gtk_thin_down_frame);
-  fl_internal_boxtype(_FL_GTK_ROUND_UP_BOX, gtk_round_up_box);
-  fl_internal_boxtype(_FL_GTK_ROUND_DOWN_BOX, gtk_round_down_box);
+  fl_internal_cached_boxtype(_FL_GTK_ROUND_UP_BOX, gtk_round_up_box);
+  fl_internal_cached_boxtype(_FL_GTK_ROUND_DOWN_BOX, gtk_round_down_box);
 
   return _FL_GTK_UP_BOX;
 }
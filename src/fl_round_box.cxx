@@ -100,8 +100,9 @@ void fl_round_up_box(int x, int y, int w, int h, Fl_Color bgcolor) {
 }
 
 extern void fl_internal_boxtype(Fl_Boxtype, Fl_Box_Draw_F*);
+extern void fl_internal_cached_boxtype(Fl_Boxtype, Fl_Box_Draw_F*);
 Fl_Boxtype fl_define_FL_ROUND_UP_BOX() {
-  fl_internal_boxtype(_FL_ROUND_DOWN_BOX, fl_round_down_box);
-  fl_internal_boxtype(_FL_ROUND_UP_BOX, fl_round_up_box);
+  fl_internal_cached_boxtype(_FL_ROUND_DOWN_BOX, fl_round_down_box);
+  fl_internal_cached_boxtype(_FL_ROUND_UP_BOX, fl_round_up_box);
   return _FL_ROUND_UP_BOX;
 }
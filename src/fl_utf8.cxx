@@ -26,6 +26,13 @@
 #include <string.h>
 #include <stdlib.h>
 
+// Use SSE2 to skip ASCII text where it is always available (x86-64),
+// otherwise test one machine word at a time.
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#  include <emmintrin.h>
+#  define FL_UTF8_SSE2 1
+#endif
+
 #undef fl_open
 
 /** \addtogroup fl_unicode
@@ -117,6 +124,36 @@ int fl_utf8len1(char c)
 } // fl_utf8len1
 
 
+/*
+  Returns the number of bytes at the start of \p src that are ASCII
+  characters, i.e. the index of the first byte with the high bit set,
+  or \p srclen if there is none.
+
+  Most text is mostly ASCII, so the UTF-8 functions below use this to
+  skip ASCII runs 16 bytes (SSE2) or one machine word at a time before
+  they decode the next multibyte character.
+*/
+unsigned fl_utf8_ascii_span(const char *src, unsigned srclen)
+{
+  unsigned i = 0;
+#if FL_UTF8_SSE2
+  for (; i + 16 <= srclen; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+    if (_mm_movemask_epi8(v)) break;
+  }
+#else
+  const size_t high_bits = ((size_t)-1 / 0xff) * 0x80; // 0x8080...80
+  for (; i + sizeof(size_t) <= srclen; i += sizeof(size_t)) {
+    size_t w;
+    memcpy(&w, src + i, sizeof(w));
+    if (w & high_bits) break;
+  }
+#endif
+  while (i < srclen && !(src[i] & 0x80)) i++;
+  return i;
+}
+
+
 /**
   Returns the number of Unicode chars in the UTF-8 string.
 */
@@ -128,6 +165,12 @@ fl_utf_nb_char(
   int i = 0;
   int nbc = 0;
   while (i < len) {
+    if (!(buf[i] & 0x80)) {
+      int n = (int)fl_utf8_ascii_span((const char*)buf + i, len - i);
+      nbc += n;
+      i += n;
+      continue;
+    }
     int cl = fl_utf8len((buf+i)[0]);
     if (cl < 1) cl = 1;
     nbc++;
@@ -185,6 +228,8 @@ int fl_utf_strcasecmp(const char *s1, const char *s2)
 */
 int fl_tolower(unsigned int ucs)
 {
+  if (ucs < 0x80) // ASCII
+    return (ucs >= 'A' && ucs <= 'Z') ? ucs + ('a' - 'A') : ucs;
   return XUtf8Tolower(ucs);
 }
 
@@ -193,6 +238,8 @@ int fl_tolower(unsigned int ucs)
 */
 int fl_toupper(unsigned int ucs)
 {
+  if (ucs < 0x80) // ASCII
+    return (ucs >= 'a' && ucs <= 'z') ? ucs - ('a' - 'A') : ucs;
   return Toupper(ucs);
 }
 
@@ -989,7 +1036,12 @@ unsigned fl_utf8toUtf16(const char* src, unsigned srclen,
   if (dstlen) for (;;) {
     if (p >= e) {dst[count] = 0; return count;}
     if (!(*p & 0x80)) { /* ascii */
-      dst[count] = *p++;
+      unsigned n = fl_utf8_ascii_span(p, (unsigned)(e-p));
+      if (n > dstlen-count-1) n = dstlen-count-1;
+      for (unsigned i = 0; i < n; i++) dst[count+i] = p[i];
+      count += n; p += n;
+      if (count == dstlen-1) {dst[count] = 0; break;}
+      continue;
     } else {
       int len; unsigned ucs = fl_utf8decode(p,e,&len);
       p += len;
@@ -1006,8 +1058,11 @@ unsigned fl_utf8toUtf16(const char* src, unsigned srclen,
   }
   /* we filled dst, measure the rest: */
   while (p < e) {
-    if (!(*p & 0x80)) p++;
-    else {
+    if (!(*p & 0x80)) {
+      unsigned n = fl_utf8_ascii_span(p, (unsigned)(e-p));
+      p += n; count += n;
+      continue;
+    } else {
       int len; unsigned ucs = fl_utf8decode(p,e,&len);
       p += len;
       if (ucs >= 0x10000) ++count;
@@ -1048,7 +1103,14 @@ unsigned fl_utf8toa(const char* src, unsigned srclen,
     unsigned char c;
     if (p >= e) {dst[count] = 0; return count;}
     c = *(const unsigned char*)p;
-    if (c < 0xC2) { /* ascii or bad code */
+    if (c < 0x80) { /* ascii */
+      unsigned n = fl_utf8_ascii_span(p, (unsigned)(e-p));
+      if (n > dstlen-count-1) n = dstlen-count-1;
+      memcpy(dst+count, p, n);
+      count += n; p += n;
+      if (count == dstlen-1) {dst[count] = 0; break;}
+      continue;
+    } else if (c < 0xC2) { /* bad code */
       dst[count] = c;
       p++;
     } else {
@@ -1061,8 +1123,11 @@ unsigned fl_utf8toa(const char* src, unsigned srclen,
   }
   /* we filled dst, measure the rest: */
   while (p < e) {
-    if (!(*p & 0x80)) p++;
-    else {
+    if (!(*p & 0x80)) {
+      unsigned n = fl_utf8_ascii_span(p, (unsigned)(e-p));
+      p += n; count += n;
+      continue;
+    } else {
       int len;
       fl_utf8decode(p,e,&len);
       p += len;
@@ -1155,7 +1220,7 @@ int fl_utf8test(const char* src, unsigned srclen) {
       if (len > ret) ret = len;
       p += len;
     } else {
-      p++;
+      p += fl_utf8_ascii_span(p, (unsigned)(e-p));
     }
   }
   return ret;
@@ -1169,6 +1234,10 @@ static int mk_wcwidth(unsigned int ucs);
  */
 #include "xutf8/mk_wcwidth.c"
 
+/* the widths of mk_wcwidth() as a two-level table, see xutf8/utils/wcwidth_tbl.c
+ */
+#include "xutf8/headers/wcwidth.h"
+
 /** Wrapper to adapt Markus Kuhn's implementation of wcwidth() for FLTK.
   \param [in] ucs Unicode character value
   \returns width of character in columns
@@ -1183,7 +1252,8 @@ static int mk_wcwidth(unsigned int ucs);
   You are advised to use fl_width(const char* src) instead.
 */
 int fl_wcwidth_(unsigned int ucs) {
-  return mk_wcwidth(ucs);
+  if (ucs >= 0x110000) return mk_wcwidth(ucs);
+  return wcwidth_blocks[wcwidth_index[ucs >> 8]][ucs & 0xff];
 }
 
 /** extended wrapper around  fl_wcwidth_(unsigned int ucs) function.
@@ -1207,6 +1277,41 @@ int fl_wcwidth(const char* src) {
   return width;
 }
 
+/** Returns the width of a UTF-8 string in columns.
+
+  This is the sum of the widths of all characters in the string, as
+  returned by fl_wcwidth(). Like the POSIX function wcswidth(), this
+  returns -1 if the string contains a control character or DEL, and it
+  stops at the first NUL byte if there is one in the first \p srclen
+  bytes.
+
+  \param[in] src pointer to start of UTF-8 byte sequence
+  \param[in] srclen maximum number of bytes in \p src
+  \returns width of the string in columns, or -1
+  \see fl_wcwidth()
+  \since 1.4.0
+*/
+int fl_wcswidth(const char* src, int srclen) {
+  const char *p = src, *e = src + srclen;
+  int width = 0;
+  while (p < e) {
+    unsigned char c = *(const unsigned char*)p;
+    if (c < 0x80) { // ASCII
+      if (!c) break;
+      if (c < 0x20 || c == 0x7f) return -1;
+      width++;
+      p++;
+    } else {
+      int len;
+      int w = fl_wcwidth_(fl_utf8decode(p, e, &len));
+      if (w < 0) return -1;
+      width += w;
+      p += len;
+    }
+  }
+  return width;
+}
+
 /**
   Converts a UTF-8 string into a wide character string.
 
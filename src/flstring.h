@@ -92,6 +92,12 @@ FL_EXPORT extern size_t fl_strlcpy(char *, const char *, size_t);
  */
 FL_EXPORT extern int fl_ascii_strcasecmp(const char *s, const char *t);
 
+/*
+ * Locale independent printf for numbers in file formats like PostScript
+ * and SVG, returns -1 if the format or the buffer size is not supported
+ */
+FL_EXPORT extern int fl_clocale_vsnprintf(char *buffer, size_t bufsize, const char *format, va_list ap);
+
 #  ifdef __cplusplus
 }
 #  endif /* __cplusplus */
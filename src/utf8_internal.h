@@ -48,6 +48,12 @@ int
 XUtf8Toupper(
         int ucs);
 
+/* number of leading ASCII bytes in src (see fl_utf8.cxx) */
+unsigned
+fl_utf8_ascii_span(
+        const char *src,
+        unsigned srclen);
+
 
 #  ifdef __cplusplus
 }
@@ -0,0 +1,68 @@
+/*
+ * Generates the table of character widths used by fl_wcwidth_().
+ *
+ * Copyright 2006-2020 by Bill Spitzak and others.
+ *
+ * This library is free software. Distribution and use rights are outlined in
+ * the file "COPYING" which should have been included with this file.  If this
+ * file is missing or damaged, see the license at:
+ *
+ *     https://www.fltk.org/COPYING.php
+ *
+ * Please see the following page on how to report bugs and issues:
+ *
+ *     https://www.fltk.org/bugs.php
+ */
+
+/*
+ * The widths of mk_wcwidth() are stored in blocks of 256 characters.
+ * Identical blocks are stored once, and an index selects the block of
+ * each range of 256 characters. Usage:
+ *
+ *   ./wcwidth_tbl > ../headers/wcwidth.h
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+static int mk_wcwidth(unsigned int ucs);
+#include "../mk_wcwidth.c"
+
+#define NBLOCKS (0x110000 / 256)
+
+static signed char blocks[NBLOCKS][256];
+static int index_[NBLOCKS];
+
+int main(void) {
+  int nblocks = 0, b, i, j;
+  for (b = 0; b < NBLOCKS; b++) {
+    signed char w[256];
+    for (i = 0; i < 256; i++) w[i] = (signed char)mk_wcwidth(b * 256 + i);
+    for (j = 0; j < nblocks; j++)
+      if (!memcmp(blocks[j], w, 256)) break;
+    if (j == nblocks) memcpy(blocks[nblocks++], w, 256);
+    index_[b] = j;
+  }
+  if (nblocks > 256) {
+    fprintf(stderr, "wcwidth_tbl: %d blocks do not fit an unsigned char index\n", nblocks);
+    return 1;
+  }
+  printf("/* Widths of the Unicode characters, as returned by mk_wcwidth().\n"
+         " * Generated by utils/wcwidth_tbl.c - do not edit!\n"
+         " * The width of character ucs is\n"
+         " *   wcwidth_blocks[wcwidth_index[ucs >> 8]][ucs & 0xff]\n"
+         " */\n\n");
+  printf("static const unsigned char wcwidth_index[%d] = {", NBLOCKS);
+  for (b = 0; b < NBLOCKS; b++)
+    printf("%s%d%s", b % 16 ? "" : "\n  ", index_[b], b < NBLOCKS - 1 ? "," : "\n");
+  printf("};\n\n");
+  printf("static const signed char wcwidth_blocks[%d][256] = {\n", nblocks);
+  for (j = 0; j < nblocks; j++) {
+    printf("  { /* block %d */", j);
+    for (i = 0; i < 256; i++)
+      printf("%s%d%s", i % 32 ? "" : "\n    ", blocks[j][i], i < 255 ? "," : "\n");
+    printf("  }%s\n", j < nblocks - 1 ? "," : "");
+  }
+  printf("};\n");
+  return 0;
+}
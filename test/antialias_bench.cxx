@@ -0,0 +1,186 @@
+//
+// Anti-aliased drawing benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2020 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+//
+// Draws the shapes affected by fl_antialias() many times, with
+// anti-aliasing off and on, and reports the time per frame for each kind
+// of shape. The left half of the window is drawn with anti-aliasing off,
+// the right half with anti-aliasing on, to compare the results. Click
+// into the window to show the next kind of shape.
+//
+// Usage: antialias_bench [frames]
+//
+
+#include <FL/Fl.H>
+#include <FL/Fl_Double_Window.H>
+#include <FL/Fl_Box.H>
+#include <FL/fl_draw.H>
+#include <FL/math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench_timer.h"
+
+#define W 300
+#define H 300
+#define N 12            // shapes per row and column
+
+enum { LINES, POLYGONS, COMPLEX, CIRCLES, ARCS, PIES, NSHAPES };
+static const char *shape_names[NSHAPES] = {
+  "fl_begin_line", "fl_begin_polygon", "fl_begin_complex_polygon",
+  "fl_circle", "fl_arc", "fl_pie"
+};
+
+// Draws N x N shapes of one kind in the area X, Y, W, H
+static void draw_shapes(int shape, int X, int Y) {
+  const int s = W / N;
+  for (int r = 0; r < N; r++) {
+    for (int c = 0; c < N; c++) {
+      double x = X + c * s, y = Y + r * s, a = (r * N + c) * 7.0;
+      fl_color((r + c) & 1 ? FL_DARK_BLUE : FL_DARK_RED);
+      switch (shape) {
+        case LINES:
+          fl_begin_line();
+          for (int i = 0; i < 4; i++)
+            fl_vertex(x + 2 + (s - 4) * (i & 1), y + 2 + (s - 4) * i / 3.0);
+          fl_end_line();
+          break;
+        case POLYGONS:
+          fl_begin_polygon();
+          for (int i = 0; i < 5; i++) {
+            double t = (a + i * 72) * M_PI / 180;
+            fl_vertex(x + s / 2 + cos(t) * (s / 2 - 2), y + s / 2 + sin(t) * (s / 2 - 2));
+          }
+          fl_end_polygon();
+          break;
+        case COMPLEX:
+          fl_begin_complex_polygon();
+          for (int i = 0; i < 5; i++) { // a star with a hole
+            double t = (a + i * 144) * M_PI / 180;
+            fl_vertex(x + s / 2 + cos(t) * (s / 2 - 2), y + s / 2 + sin(t) * (s / 2 - 2));
+          }
+          fl_end_complex_polygon();
+          break;
+        case CIRCLES:
+          fl_begin_polygon();
+          fl_circle(x + s / 2, y + s / 2, s / 2 - 2);
+          fl_end_polygon();
+          break;
+        case ARCS:
+          fl_arc(int(x) + 2, int(y) + 2, s - 4, s - 4, a, a + 270);
+          break;
+        case PIES:
+          fl_pie(int(x) + 2, int(y) + 2, s - 4, s - 4, a, a + 270);
+          break;
+      }
+    }
+  }
+}
+
+class Canvas : public Fl_Widget {
+public:
+  int shape;
+  Canvas(int x, int y, int w, int h) : Fl_Widget(x, y, w, h), shape(0) {}
+  int handle(int e) {
+    if (e != FL_PUSH) return Fl_Widget::handle(e);
+    shape = (shape + 1) % NSHAPES;
+    redraw();
+    return 1;
+  }
+  void draw() {
+    fl_color(FL_WHITE);
+    fl_rectf(x(), y(), w(), h());
+    int aa = fl_antialias();
+    fl_antialias(0);
+    draw_shapes(shape, x(), y());
+    fl_antialias(1);
+    draw_shapes(shape, x() + W, y());
+    fl_antialias(aa);
+  }
+};
+
+// Draws N x N shapes of one kind with the current anti-aliasing
+class Timed : public Fl_Widget {
+public:
+  int shape;
+  Timed(int x, int y, int w, int h) : Fl_Widget(x, y, w, h), shape(0) {}
+  void draw() {
+    fl_color(FL_WHITE);
+    fl_rectf(x(), y(), w(), h());
+    draw_shapes(shape, x(), y());
+  }
+};
+
+static Fl_Double_Window *window;
+static Fl_Box *result;
+static Canvas *canvas;
+static Timed *timed;
+static int frames = 100;
+
+// Redraws the timed widget 'frames' times and returns the time per frame in ms
+static double time_frames() {
+  uchar pixel[3];
+  double t0 = seconds();
+  for (int i = 0; i < frames; i++) {
+    timed->damage(FL_DAMAGE_ALL);
+    Fl::flush();
+  }
+  window->make_current();
+  fl_read_image(pixel, 0, 0, 1, 1); // wait until the window system is done
+  return (seconds() - t0) * 1000.0 / frames;
+}
+
+static void run(void *) {
+  static char text[1000];
+  char *p = text;
+  p += sprintf(p, "%d frames of %d shapes\n", frames, N * N);
+  timed->show();
+  for (int i = 0; i < NSHAPES; i++) {
+    timed->shape = i;
+    fl_antialias(0);
+    time_frames(); // warm up
+    double off = time_frames();
+    fl_antialias(1);
+    if (!fl_antialias()) {
+      p += sprintf(p, "fl_antialias() is not supported on this platform\n");
+      break;
+    }
+    time_frames();
+    double on = time_frames();
+    fl_antialias(0);
+    p += sprintf(p, "%-25s  off %7.3f ms  on %7.3f ms\n", shape_names[i], off, on);
+  }
+  timed->hide();
+  printf("%s", text);
+  result->label(text);
+  window->redraw();
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1) frames = atoi(argv[1]);
+  if (frames < 1) frames = 1;
+  window = new Fl_Double_Window(2 * W, H + 120, "Anti-aliased drawing benchmark");
+  canvas = new Canvas(0, 0, 2 * W, H);
+  timed = new Timed(0, 0, W, H);
+  timed->hide();
+  result = new Fl_Box(10, H, window->w() - 20, 120, "running...");
+  result->labelfont(FL_COURIER);
+  result->labelsize(12);
+  result->align(FL_ALIGN_INSIDE | FL_ALIGN_LEFT);
+  window->end();
+  window->show();
+  Fl::add_timeout(0.5, run);
+  return Fl::run();
+}
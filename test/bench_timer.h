@@ -0,0 +1,39 @@
+//
+// Benchmark timer header for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2020 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#ifndef bench_timer_h
+#  define bench_timer_h
+#  ifdef _WIN32
+#    include <windows.h>
+#  else
+#    include <sys/time.h>
+#  endif
+
+// Returns the wall clock time in seconds, used by the benchmark programs
+static double seconds() {
+#  ifdef _WIN32
+  LARGE_INTEGER count, freq;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&freq);
+  return (double)count.QuadPart / freq.QuadPart;
+#  else
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+#  endif
+}
+
+#endif // !bench_timer_h
@@ -0,0 +1,137 @@
+//
+// Box drawing benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2020 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+//
+// Draws the shaded box types of all schemes many times, with and without
+// the cache of box tiles (see Fl::box_cache_size()), and reports the time
+// per frame for each scheme. On X11 it also reports the number of X
+// requests sent per frame.
+//
+// Usage: boxtype_bench [frames]
+//
+
+#include <FL/Fl.H>
+#include <FL/Fl_Double_Window.H>
+#include <FL/Fl_Box.H>
+#include <FL/fl_draw.H>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench_timer.h"
+#if !defined(_WIN32) && !defined(__APPLE__)
+#include <FL/platform.H>
+#define HAVE_X_REQUESTS 1
+#endif
+
+#define W 160
+#define H 24
+#define COLS 5
+#define ROWS 18
+
+static const Fl_Boxtype types[] = {
+  FL_UP_BOX, FL_DOWN_BOX, FL_THIN_UP_BOX, FL_THIN_DOWN_BOX,
+  FL_ROUND_UP_BOX, FL_ROUND_DOWN_BOX
+};
+static const int ntypes = sizeof(types) / sizeof(types[0]);
+
+// Draws the box types of the current scheme in a grid of various widths and colors
+class Canvas : public Fl_Widget {
+public:
+  Canvas(int x, int y, int w, int h) : Fl_Widget(x, y, w, h) {}
+  void draw() {
+    fl_color(FL_BACKGROUND_COLOR);
+    fl_rectf(x(), y(), w(), h());
+    int n = 0;
+    for (int r = 0; r < ROWS; r++) {
+      for (int c = 0; c < COLS; c++, n++) {
+        Fl_Boxtype t = types[n % ntypes];
+        Fl_Color col = (r & 1) ? FL_BACKGROUND_COLOR : FL_SELECTION_COLOR;
+        int bw = W - 10 - (n % 7) * 10;
+        fl_draw_box(t, x() + c * W + 5, y() + r * (H + 6) + 3, bw, H, col);
+      }
+    }
+  }
+};
+
+// Returns the number of X requests sent so far, or 0 if not using X11
+static unsigned long requests() {
+#ifdef HAVE_X_REQUESTS
+  return XNextRequest(fl_display);
+#else
+  return 0;
+#endif
+}
+
+static Fl_Double_Window *window;
+static Fl_Box *result;
+static Canvas *canvas;
+static int frames = 200;
+
+// Redraws the canvas 'frames' times and returns the time per frame in ms.
+// Sets *req to the number of X requests per frame.
+static double time_frames(unsigned long *req) {
+  uchar pixel[3];
+  unsigned long r0 = requests();
+  double t0 = seconds();
+  for (int i = 0; i < frames; i++) {
+    canvas->damage(FL_DAMAGE_ALL);
+    Fl::flush();
+  }
+  window->make_current();
+  fl_read_image(pixel, 0, 0, 1, 1); // wait until the window system is done
+  double t = seconds() - t0;
+  *req = (requests() - r0) / frames;
+  return t * 1000.0 / frames;
+}
+
+static void run(void *) {
+  static const char *schemes[] = {"base", "plastic", "gtk+", "gleam"};
+  static char text[1000];
+  char *p = text;
+  p += sprintf(p, "%d frames of %d boxes\n", frames, ROWS * COLS);
+  for (int i = 0; i < 4; i++) {
+    Fl::scheme(schemes[i]);
+    unsigned long direct_req, cached_req;
+    Fl::box_cache_size(0);
+    time_frames(&direct_req); // warm up
+    double direct = time_frames(&direct_req);
+    Fl::box_cache_size(64);
+    time_frames(&cached_req);
+    double cached = time_frames(&cached_req);
+    p += sprintf(p, "%-8s  direct %7.3f ms  cached %7.3f ms  (x%.1f)",
+                 schemes[i], direct, cached, cached > 0 ? direct / cached : 0.0);
+#ifdef HAVE_X_REQUESTS
+    p += sprintf(p, "  X requests %lu / %lu", direct_req, cached_req);
+#endif
+    p += sprintf(p, "\n");
+  }
+  printf("%s", text);
+  result->label(text);
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1) frames = atoi(argv[1]);
+  if (frames < 1) frames = 1;
+  window = new Fl_Double_Window(COLS * W, ROWS * (H + 6) + 90, "Box drawing benchmark");
+  canvas = new Canvas(0, 0, COLS * W, ROWS * (H + 6));
+  result = new Fl_Box(10, canvas->h(), window->w() - 20, 90, "running...");
+  result->labelfont(FL_COURIER);
+  result->labelsize(12);
+  result->align(FL_ALIGN_INSIDE | FL_ALIGN_LEFT);
+  window->end();
+  window->show();
+  Fl::add_timeout(0.5, run);
+  return Fl::run();
+}
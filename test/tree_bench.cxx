@@ -0,0 +1,127 @@
+//
+// Fl_Tree memory and traversal benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2020 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+//
+// Builds a large tree (1000 folders with 1000 items each by default)
+// with and without Fl_Tree_Item::use_pool(1), and reports the time and
+// memory used to create, traverse and delete it.
+//
+// Usage: tree_bench [folders [items-per-folder]]
+//
+// The tree built with the item pool is then shown in a window,
+// so scrolling and opening/closing can be tried interactively.
+//
+
+#include <FL/Fl.H>
+#include <FL/Fl_Double_Window.H>
+#include <FL/Fl_Tree.H>
+#include <FL/Fl_Box.H>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_timer.h"
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+// Heap memory allocated by this process in KB, or -1 if unknown.
+// Unlike the resident size, this goes down when memory is freed, so
+// both trees can be measured in the same process.
+static long allocated_kb() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+  struct mallinfo2 mi = mallinfo2();
+  return (long)((mi.uordblks + mi.hblkhd) / 1024);
+#elif defined(__GLIBC__)
+  struct mallinfo mi = mallinfo();      // wraps above 2 GB
+  return ((long)(unsigned)mi.uordblks + (long)(unsigned)mi.hblkhd) / 1024;
+#else
+  return -1;
+#endif
+}
+
+// Build, traverse and delete a tree, print results; returns the tree if 'keep' is set
+static Fl_Tree *bench(int pool, int nfolders, int nitems, int keep, char *result, int rsize) {
+  char s[80];
+  Fl_Tree_Item::use_pool(pool);
+  Fl_Tree *tree = new Fl_Tree(10, 40, 380, 350);
+  tree->showroot(0);
+
+  // Create
+  long mem0 = allocated_kb();
+  double t0 = seconds();
+  for (int f = 0; f < nfolders; f++) {
+    sprintf(s, "Folder %04d", f);
+    Fl_Tree_Item *folder = tree->add(tree->root(), s);
+    for (int i = 0; i < nitems; i++) {
+      sprintf(s, "file%03d.txt", i % 1000);     // labels repeat across folders
+      tree->add(folder, s);
+    }
+    folder->close();
+  }
+  double t_create = seconds() - t0;
+  long mem = mem0 < 0 ? -1 : allocated_kb() - mem0;
+
+  // Traverse all items (5 passes)
+  t0 = seconds();
+  long count = 0, chars = 0;       // summing label lengths makes sure labels are read
+  for (int pass = 0; pass < 5; pass++) {
+    for (Fl_Tree_Item *item = tree->first(); item; item = item->next()) {
+      count++;
+      if (item->label()) chars += (long)strlen(item->label());
+    }
+  }
+  double t_walk = (seconds() - t0) / 5;
+
+  // Delete
+  double t_delete = 0;
+  if (!keep) {
+    t0 = seconds();
+    delete tree;
+    tree = 0;
+    t_delete = seconds() - t0;
+  }
+
+  char del[24], kb[24];
+  if (keep) strcpy(del, "   -   "); else snprintf(del, sizeof(del), "%6.3fs", t_delete);
+  if (mem < 0) strcpy(kb, "n/a"); else snprintf(kb, sizeof(kb), "%ld KB", mem);
+  snprintf(result, rsize, "%-7s %8ld items  create %6.3fs  walk %6.3fs  delete %s  memory %s",
+           pool ? "pooled" : "default", count / 5, t_create, t_walk, del, kb);
+  printf("%s (%ld label bytes)\n", result, chars / 5);
+  return tree;
+}
+
+int main(int argc, char **argv) {
+  int nfolders = argc > 1 ? atoi(argv[1]) : 1000;
+  int nitems   = argc > 2 ? atoi(argv[2]) : 1000;
+  if (nfolders < 1) nfolders = 1;
+  if (nitems < 0) nitems = 0;
+
+  static char r1[200], r2[200];
+  Fl_Double_Window *win = new Fl_Double_Window(400, 400, "Fl_Tree benchmark");
+  bench(0, nfolders, nitems, 0, r1, sizeof(r1));
+  Fl_Tree *tree = bench(1, nfolders, nitems, 1, r2, sizeof(r2));
+  Fl_Box *box = new Fl_Box(10, 5, 380, 30);
+  static char label[420];
+  snprintf(label, sizeof(label), "%s\n%s", r1, r2);
+  box->label(label);
+  box->labelsize(9);
+  box->labelfont(FL_COURIER);
+  box->align(FL_ALIGN_INSIDE | FL_ALIGN_LEFT);
+  win->end();
+  win->resizable(tree);
+  win->show();
+  return Fl::run();
+}
@@ -0,0 +1,265 @@
+//
+// Unit tests for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2020 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include <FL/Fl_Group.H>
+#include <FL/Fl_Button.H>
+#include <FL/Fl_Image_Surface.H>
+#include <FL/fl_draw.H>
+#include <FL/math.h>
+
+//
+//------- test the coverage of anti-aliased shapes ----------
+//
+// Draws shapes with fl_antialias(1) into an image and compares each pixel
+// with the coverage found by sampling 16 x 16 points per pixel. Overlapping
+// parts of a line (segments, joins and caps) and self-intersecting polygons
+// must cover each pixel once, as the fill rule says.
+//
+#define AA_SIZE     40          // size of the test image
+#define AA_SAMPLES  16          // samples per pixel in each direction
+#define AA_MAXERROR 32          // largest difference allowed, out of 255
+#define AA_MAXPARTS 1000
+
+// The convex parts of the reference shape, or the contour of a polygon,
+// with up to 8 vertices each and their bounding boxes
+static float aa_parts[AA_MAXPARTS][16];
+static int aa_nvert[AA_MAXPARTS];
+static float aa_bbox[AA_MAXPARTS][4];
+static int aa_nparts;
+
+static void aa_add_part(const float *xy, int n) {
+  if (aa_nparts >= AA_MAXPARTS || n > 8) return;
+  float *b = aa_bbox[aa_nparts];
+  b[0] = b[2] = xy[0]; b[1] = b[3] = xy[1];
+  for (int i = 0; i < n; i++) {
+    aa_parts[aa_nparts][2*i] = xy[2*i];
+    aa_parts[aa_nparts][2*i+1] = xy[2*i+1];
+    if (xy[2*i] < b[0]) b[0] = xy[2*i];
+    if (xy[2*i+1] < b[1]) b[1] = xy[2*i+1];
+    if (xy[2*i] > b[2]) b[2] = xy[2*i];
+    if (xy[2*i+1] > b[3]) b[3] = xy[2*i+1];
+  }
+  aa_nvert[aa_nparts++] = n;
+}
+
+// Adds the rectangle of a line from a to b with half width hw, extended
+// by ext at both ends
+static void aa_add_segment(const float *a, const float *b, float hw, float ext) {
+  float dx = b[0] - a[0], dy = b[1] - a[1];
+  float len = (float)sqrt(dx * dx + dy * dy);
+  dx /= len; dy /= len;
+  float nx = -dy * hw, ny = dx * hw, ex = dx * ext, ey = dy * ext;
+  float q[8] = { a[0] + nx - ex, a[1] + ny - ey, b[0] + nx + ex, b[1] + ny + ey,
+                 b[0] - nx + ex, b[1] - ny + ey, a[0] - nx - ex, a[1] - ny - ey };
+  aa_add_part(q, 4);
+}
+
+// Returns 1 if x, y is inside the convex part p
+static int aa_in_convex(int p, float x, float y) {
+  const float *q = aa_parts[p];
+  int n = aa_nvert[p], pos = 0, neg = 0;
+  for (int i = 0; i < n; i++) {
+    int j = (i + 1) % n;
+    float c = (q[2*j] - q[2*i]) * (y - q[2*i+1]) - (q[2*j+1] - q[2*i+1]) * (x - q[2*i]);
+    if (c > 0) pos = 1; else if (c < 0) neg = 1;
+  }
+  return !(pos && neg);
+}
+
+// Returns 1 if x, y is inside polygon p with the even-odd rule
+static int aa_in_polygon(int p, float x, float y) {
+  const float *q = aa_parts[p];
+  int n = aa_nvert[p], in = 0;
+  for (int i = 0; i < n; i++) {
+    int j = (i + 1) % n;
+    if ((q[2*i+1] <= y) != (q[2*j+1] <= y) &&
+        q[2*i] + (y - q[2*i+1]) * (q[2*j] - q[2*i]) / (q[2*j+1] - q[2*i+1]) < x)
+      in = !in;
+  }
+  return in;
+}
+
+// Returns the coverage of pixel x, y by the reference shape from 0 to 255
+static int aa_reference(int x, int y, int polygon) {
+  int near[AA_MAXPARTS], nnear = 0, count = 0, p;
+  for (p = 0; p < aa_nparts; p++) {
+    const float *b = aa_bbox[p];
+    if (b[0] < x + 1 && b[2] > x && b[1] < y + 1 && b[3] > y) near[nnear++] = p;
+  }
+  for (int sy = 0; sy < AA_SAMPLES; sy++) {
+    for (int sx = 0; sx < AA_SAMPLES; sx++) {
+      float px = x + (sx + 0.5f) / AA_SAMPLES, py = y + (sy + 0.5f) / AA_SAMPLES;
+      for (p = 0; p < nnear; p++) {
+        if (polygon ? aa_in_polygon(near[p], px, py) : aa_in_convex(near[p], px, py)) {
+          count++;
+          break;
+        }
+      }
+    }
+  }
+  return (count * 255 + AA_SAMPLES * AA_SAMPLES / 2) / (AA_SAMPLES * AA_SAMPLES);
+}
+
+// Simple random numbers, so that every run draws the same shapes
+static unsigned aa_seed;
+static float aa_random(float lo, float hi) {
+  aa_seed = aa_seed * 1103515245 + 12345;
+  return lo + (hi - lo) * ((aa_seed >> 8) & 0xffff) / 65535.0f;
+}
+
+class AntialiasTest : public Fl_Group {
+  CheckList *results;
+  enum { SEGMENT_1, SEGMENT_4, POLYLINE, POLYGONS };
+  // Draws a shape with the current color
+  static void draw_shape(int shape, const float *xy, int n) {
+    int i;
+    switch (shape) {
+      case SEGMENT_1:
+      case SEGMENT_4:
+        fl_line_style(FL_SOLID | FL_CAP_SQUARE, shape == SEGMENT_1 ? 1 : 4);
+        fl_begin_line();
+        fl_vertex(xy[0], xy[1]);
+        fl_vertex(xy[2], xy[3]);
+        fl_end_line();
+        break;
+      case POLYLINE:
+        fl_line_style(FL_SOLID | FL_CAP_FLAT | FL_JOIN_BEVEL, 1);
+        fl_begin_line();
+        for (i = 0; i < n; i++) fl_vertex(xy[2*i], xy[2*i+1]);
+        fl_end_line();
+        break;
+      case POLYGONS:
+        fl_begin_complex_polygon();
+        for (i = 0; i < n; i++) fl_vertex(xy[2*i], xy[2*i+1]);
+        fl_end_complex_polygon();
+        break;
+    }
+    fl_line_style(0);
+  }
+  // Sets the parts of the reference of a shape, in the coordinates of the
+  // rasterizer: lines are drawn through the centers of the pixels
+  static void reference_shape(int shape, const float *xy, int n) {
+    float c[2 * 200];
+    int i;
+    aa_nparts = 0;
+    if (shape == POLYGONS) {
+      aa_add_part(xy, n);
+      return;
+    }
+    for (i = 0; i < 2 * n; i++) c[i] = xy[i] + 0.5f;
+    if (shape != POLYLINE) {
+      float hw = shape == SEGMENT_1 ? 0.5f : 2.0f;
+      aa_add_segment(c, c + 2, hw, hw);
+      return;
+    }
+    for (i = 0; i < n - 1; i++) aa_add_segment(c + 2*i, c + 2*i + 2, 0.5f, 0);
+    for (i = 1; i < n - 1; i++) {       // bevel joins
+      const float *a = c + 2*i;
+      float d0x = a[0] - a[-2], d0y = a[1] - a[-1];
+      float d1x = a[2] - a[0], d1y = a[3] - a[1];
+      float l0 = (float)sqrt(d0x * d0x + d0y * d0y), l1 = (float)sqrt(d1x * d1x + d1y * d1y);
+      d0x /= l0; d0y /= l0; d1x /= l1; d1y /= l1;
+      float s = d0x * d1y - d0y * d1x > 0 ? -0.5f : 0.5f;
+      float t[6] = { a[0], a[1], a[0] - d0y * s, a[1] + d0x * s, a[0] - d1y * s, a[1] + d1x * s };
+      aa_add_part(t, 3);
+    }
+  }
+  // Draws a shape into an image and returns the largest difference from
+  // the reference, or -1 if anti-aliasing is not supported
+  static int max_error(int shape, const float *xy, int n) {
+    Fl_Image_Surface *surf = new Fl_Image_Surface(AA_SIZE, AA_SIZE);
+    Fl_Surface_Device::push_current(surf);
+    fl_color(FL_WHITE);
+    fl_rectf(0, 0, AA_SIZE, AA_SIZE);
+    fl_antialias(1);
+    int supported = fl_antialias();
+    fl_color(FL_BLACK);
+    if (supported) draw_shape(shape, xy, n);
+    fl_antialias(0);
+    Fl_RGB_Image *img = surf->image();
+    Fl_Surface_Device::pop_current();
+    delete surf;
+    int worst = -1;
+    if (supported && img->w() == AA_SIZE && img->h() == AA_SIZE) {
+      reference_shape(shape, xy, n);
+      const uchar *p = (const uchar*)img->data()[0];
+      worst = 0;
+      for (int y = 0; y < AA_SIZE; y++) {
+        for (int x = 0; x < AA_SIZE; x++) {
+          int got = 255 - p[(y * AA_SIZE + x) * img->d()];
+          int d = got - aa_reference(x, y, shape == POLYGONS);
+          if (d < 0) d = -d;
+          if (d > worst) worst = d;
+        }
+      }
+    }
+    delete img;
+    return worst;
+  }
+  static void run_cb(Fl_Widget*, void *data) {
+    ((AntialiasTest*)data)->run();
+  }
+  void check(const char *what, int error) {
+    char s[120];
+    sprintf(s, "%s (error %d/255)", what, error);
+    results->check(s, error <= AA_MAXERROR);
+  }
+  void run() {
+    float xy[2 * 200];
+    int i, t, e, worst;
+    results->start();
+    xy[0] = 5.3f; xy[1] = 7.2f; xy[2] = 30.6f; xy[3] = 22.8f;
+    e = max_error(SEGMENT_1, xy, 2);
+    if (e < 0) {
+      results->add("fl_antialias() is not supported on this platform");
+      return;
+    }
+    check("line with square caps, width 1", e);
+    check("line with square caps, width 4", max_error(SEGMENT_4, xy, 2));
+
+    aa_seed = 1;
+    for (i = 0; i < 2 * 200; i++) xy[i] = aa_random(4, AA_SIZE - 4);
+    check("200 points line with bevel joins, width 1", max_error(POLYLINE, xy, 200));
+
+    worst = 0;
+    for (t = 0; t < 10; t++) {
+      for (i = 0; i < 2 * 7; i++) xy[i] = aa_random(2, AA_SIZE - 2);
+      e = max_error(POLYGONS, xy, 7);
+      if (e > worst) worst = e;
+    }
+    check("self-intersecting polygons, even-odd rule", worst);
+    results->finish();
+  }
+public:
+  static Fl_Widget *create() {
+    return new AntialiasTest(TESTAREA_X, TESTAREA_Y, TESTAREA_W, TESTAREA_H);
+  }
+  AntialiasTest(int x, int y, int w, int h) : Fl_Group(x, y, w, h) {
+    Fl_Button *button = new Fl_Button(x, y, 120, 25, "Run checks");
+    button->callback(run_cb, (void*)this);
+    results = new CheckList(x, y + 35, w, h - 35);
+    end();
+  }
+  void show() {
+    Fl_Group::show();
+    Fl::add_timeout(0.1, run_timeout, (void*)this);
+  }
+  static void run_timeout(void *data) {
+    ((AntialiasTest*)data)->run();
+  }
+};
+
+UnitTest antialias("antialiasing", AntialiasTest::create);
@@ -0,0 +1,116 @@
+//
+// Unit tests for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2020 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include <FL/Fl_Group.H>
+#include <FL/Fl_Box.H>
+#include <FL/Fl_Button.H>
+
+//
+//------- test Fl_Group::cached() ----------
+//
+// Checks that the children of a cached group are only drawn again when
+// they or the group are damaged, and that the image is rebuilt when the
+// group is resized or cached() is turned off. The checks run each time
+// the page is shown, since they need to draw the window.
+//
+
+// A box that counts how often it is drawn
+class CountBox : public Fl_Box {
+public:
+  int drawn;
+  CountBox(int X, int Y, int W, int H, const char *L)
+    : Fl_Box(FL_UP_BOX, X, Y, W, H, L), drawn(0) { }
+  void draw() { drawn++; Fl_Box::draw(); }
+};
+
+class GroupCacheTest : public Fl_Group {
+  Fl_Group *group;
+  CountBox *a, *b, *c;
+  CheckList *results;
+  void reset() { a->drawn = b->drawn = c->drawn = 0; }
+  static void run_cb(Fl_Widget*, void *data) {
+    ((GroupCacheTest*)data)->run();
+  }
+  static void run_timeout(void *data) {
+    ((GroupCacheTest*)data)->run();
+  }
+  void run() {
+    Fl_Window *win = window();
+    if (!win || !win->shown() || !visible_r()) return;
+    results->start();
+    Fl::flush();
+
+    reset();
+    win->redraw();
+    Fl::flush();
+    results->check("redrawing the window copies the cached group",
+                   a->drawn == 0 && b->drawn == 0 && c->drawn == 1);
+
+    reset();
+    a->redraw();
+    Fl::flush();
+    results->check("redrawing a child draws only this child",
+                   a->drawn == 1 && b->drawn == 0 && c->drawn == 0);
+
+    reset();
+    group->redraw();
+    Fl::flush();
+    results->check("redrawing the group draws all its children",
+                   a->drawn == 1 && b->drawn == 1 && c->drawn == 0);
+
+    reset();
+    group->size(group->w(), group->h() - 10);
+    win->redraw();
+    Fl::flush();
+    results->check("resizing the group draws its children again",
+                   a->drawn == 1 && b->drawn == 1 && c->drawn == 1);
+    group->size(group->w(), group->h() + 10);
+
+    reset();
+    group->cached(0);
+    win->redraw();
+    Fl::flush();
+    results->check("with cached(0) redrawing the window draws the children",
+                   a->drawn == 1 && b->drawn == 1 && c->drawn == 1);
+    group->cached(1);
+
+    results->finish();
+    win->redraw();
+  }
+public:
+  static Fl_Widget *create() {
+    return new GroupCacheTest(TESTAREA_X, TESTAREA_Y, TESTAREA_W, TESTAREA_H);
+  }
+  GroupCacheTest(int x, int y, int w, int h) : Fl_Group(x, y, w, h) {
+    group = new Fl_Group(x, y, 280, 100);
+    group->box(FL_DOWN_BOX);
+    a = new CountBox(x + 10, y + 10, 120, 80, "cached A");
+    b = new CountBox(x + 150, y + 10, 120, 80, "cached B");
+    group->end();
+    group->cached(1);
+    c = new CountBox(x, y + 110, 280, 60, "not cached");
+    Fl_Button *button = new Fl_Button(x + 300, y, 120, 25, "Run checks");
+    button->callback(run_cb, (void*)this);
+    results = new CheckList(x, y + 180, w, h - 180);
+    end();
+  }
+  void show() {
+    Fl_Group::show();
+    Fl::add_timeout(0.1, run_timeout, (void*)this);
+  }
+};
+
+UnitTest group_cache("group cache", GroupCacheTest::create);
@@ -0,0 +1,103 @@
+//
+// Unit tests for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2020 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include <FL/Fl_Group.H>
+#include <FL/Fl_Tree.H>
+#include <FL/Fl_Button.H>
+
+//
+//------- test Fl_Tree children created on demand ----------
+//
+// Checks that Fl_Tree_Item::children_pending() and
+// Fl_Tree::item_populate_callback() create each child exactly once,
+// also for items that already had children and with unload_closed().
+//
+#define TREE_NCHILDREN 5
+
+class TreePopulateTest : public Fl_Group {
+  Fl_Tree *tree;
+  CheckList *results;
+  int populated;                        // number of populate callbacks
+  static void populate_cb(Fl_Tree_Item *item, void *data) {
+    TreePopulateTest *t = (TreePopulateTest*)data;
+    char s[20];
+    t->populated++;
+    for (int i = 0; i < TREE_NCHILDREN; i++) {
+      sprintf(s, "child %d", i);
+      t->tree->add(item, s);
+    }
+  }
+  static void run_cb(Fl_Widget*, void *data) {
+    ((TreePopulateTest*)data)->run();
+  }
+  void run() {
+    tree->clear();
+    tree->unload_closed(0);
+    populated = 0;
+    results->start();
+
+    // An item that already has children
+    Fl_Tree_Item *item = tree->add("Folder");
+    tree->add(item, "old 1");
+    tree->add(item, "old 2");
+    item->children_pending(1);
+    results->check("children_pending(1) deletes existing children",
+                   item->children() == 0 && item->children_pending() && item->is_close());
+
+    item->open();
+    results->check("first open() populates once",
+                   populated == 1 && item->children() == TREE_NCHILDREN);
+
+    item->close();
+    item->open();
+    results->check("reopening without unload_closed() keeps the children",
+                   populated == 1 && item->children() == TREE_NCHILDREN);
+
+    tree->unload_closed(1);
+    item->close();
+    results->check("close() with unload_closed() deletes the children",
+                   item->children() == 0 && item->children_pending());
+
+    item->open();
+    results->check("reopening with unload_closed() populates again",
+                   populated == 2 && item->children() == TREE_NCHILDREN);
+
+    tree->unload_closed(0);
+    item->children_pending(0);
+    item->close();
+    item->open();
+    results->check("children_pending(0) keeps the children, stops populating",
+                   populated == 2 && item->children() == TREE_NCHILDREN && !item->children_pending());
+    results->finish();
+    tree->redraw();
+  }
+public:
+  static Fl_Widget *create() {
+    return new TreePopulateTest(TESTAREA_X, TESTAREA_Y, TESTAREA_W, TESTAREA_H);
+  }
+  TreePopulateTest(int x, int y, int w, int h) : Fl_Group(x, y, w, h), populated(0) {
+    tree = new Fl_Tree(x, y, w, 150);
+    tree->showroot(0);
+    tree->item_populate_callback(populate_cb, (void*)this);
+    Fl_Button *b = new Fl_Button(x, y + 160, 120, 25, "Run checks");
+    b->callback(run_cb, (void*)this);
+    results = new CheckList(x, y + 195, w, h - 195);
+    end();
+    run();
+  }
+};
+
+UnitTest tree_populate("tree populate", TreePopulateTest::create);
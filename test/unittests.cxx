@@ -24,11 +24,13 @@
 #include <FL/Fl.H>
 #include <FL/Fl_Double_Window.H>
 #include <FL/Fl_Hold_Browser.H>
+#include <FL/Fl_Browser.H>
 #include <FL/Fl_Help_View.H>
 #include <FL/Fl_Group.H>
 #include <FL/Fl_Box.H>
 #include <FL/fl_draw.H>         // fl_text_extents()
 #include <FL/fl_string.h>       // fl_strdup()
+#include <stdio.h>
 
 // WINDOW/WIDGET SIZES
 #define MAINWIN_W       700                             // main window w()
@@ -94,6 +96,38 @@ int UnitTest::nTest = 0;
 UnitTest *UnitTest::fTest[200];
 
 
+// Lists the results of the checks of a non-visual test, one line per check.
+// Tests that verify behavior rather than drawing use it to show their results.
+class CheckList : public Fl_Browser {
+public:
+  CheckList(int x, int y, int w, int h, const char *l=0L) :
+    Fl_Browser(x, y, w, h, l),
+    fFailed(0)
+  {
+    textfont(FL_COURIER);
+    textsize(12);
+  }
+  // remove the results of the previous run
+  void start() {
+    clear();
+    fFailed = 0;
+  }
+  // add the result of one check
+  void check(const char *what, int ok) {
+    char line[200];
+    sprintf(line, "%s%-6s %.150s", ok ? "" : "@C1", ok ? "ok" : "FAILED", what);
+    add(line);
+    if (!ok) fFailed++;
+  }
+  // add a summary line after the last check
+  void finish() {
+    add(fFailed ? "@C1@bSome checks FAILED" : "@bAll checks passed");
+  }
+  int failed() const { return fFailed; }
+private:
+  int fFailed;
+};
+
 // The main window needs an additional drawing feature in order to support
 // the viewport alignment test.
 class MainWindow : public Fl_Double_Window {
@@ -153,6 +187,9 @@ public:
 #include "unittest_scrollbarsize.cxx"
 #include "unittest_schemes.cxx"
 #include "unittest_simple_terminal.cxx"
+#include "unittest_tree.cxx"
+#include "unittest_group_cache.cxx"
+#include "unittest_antialias.cxx"
 
 // callback whenever the browser value changes
 void Browser_CB(Fl_Widget*, void*) {
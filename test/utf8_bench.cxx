@@ -0,0 +1,197 @@
+//
+// UTF-8 conversion benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2020 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+//
+// First compares fl_utf_nb_char(), fl_utf8test(), fl_utf8toUtf16(),
+// fl_utf8toa() and fl_utf8towc() with simple character by character
+// versions on many random strings of ASCII, multibyte and invalid UTF-8,
+// with all output buffer sizes. Then reports the time these functions
+// need for a large text that is mostly ASCII and for a text without ASCII.
+//
+// Usage: utf8_bench [megabytes]
+//
+
+#include <FL/fl_utf8.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_timer.h"
+
+// Reference versions, one character at a time
+
+static int ref_nb_char(const unsigned char *buf, int len) {
+  int i = 0, nbc = 0;
+  while (i < len) {
+    int cl = fl_utf8len(buf[i]);
+    if (cl < 1) cl = 1;
+    nbc++;
+    i += cl;
+  }
+  return nbc;
+}
+
+static int ref_test(const char *src, unsigned srclen) {
+  int ret = 1;
+  const char *p = src, *e = src + srclen;
+  while (p < e) {
+    if (*p & 0x80) {
+      int len; fl_utf8decode(p, e, &len);
+      if (len < 2) return 0;
+      if (len > ret) ret = len;
+      p += len;
+    } else {
+      p++;
+    }
+  }
+  return ret;
+}
+
+// Converts to UCS-4 and ISO-8859-1 and returns the number of characters
+static unsigned ref_ucs(const char *src, unsigned srclen, unsigned *dst, char *latin1) {
+  const char *p = src, *e = src + srclen;
+  unsigned n = 0;
+  while (p < e) {
+    int len;
+    dst[n] = fl_utf8decode(p, e, &len);
+    if ((unsigned char)*p >= 0x80 && (unsigned char)*p < 0xc2) latin1[n] = *p; // kept as is
+    else latin1[n] = dst[n] < 0x100 ? (char)dst[n] : '?';
+    n++;
+    p += len;
+  }
+  return n;
+}
+
+// Random text: ASCII, 2, 3 and 4 byte characters, and some invalid bytes
+static void random_text(char *buf, int len, int ascii_percent, int invalid = 1) {
+  int i = 0;
+  while (i < len) {
+    int r = rand() % 100;
+    char tmp[8];
+    int n;
+    if (r < ascii_percent) {
+      tmp[0] = (char)(32 + rand() % 95); n = 1;
+    } else if (!invalid || r < ascii_percent + (100 - ascii_percent) * 9 / 10) {
+      static const unsigned ranges[] = {0x80, 0x800, 0x10000, 0x110000};
+      unsigned lo = ranges[rand() % 3], ucs = lo + rand() % (lo * 3);
+      if (ucs >= 0xd800 && ucs < 0xe000) ucs = 0xe000;
+      n = fl_utf8encode(ucs, tmp);
+    } else {
+      tmp[0] = (char)(0x80 + rand() % 128); n = 1;
+    }
+    for (int j = 0; j < n && i < len; j++) buf[i++] = tmp[j];
+  }
+}
+
+static int errors = 0;
+
+static void check(const char *what, const char *s, int len, long got, long expected) {
+  if (got == expected) return;
+  if (++errors < 20)
+    printf("%s mismatch for %d bytes: %ld instead of %ld\n", what, len, got, expected);
+}
+
+static void compare(const char *s, int len) {
+  unsigned ucs[300];
+  unsigned short u16[600];
+  char a[300], latin1[300];
+  wchar_t wc[600];
+  unsigned n = ref_ucs(s, len, ucs, latin1);
+  unsigned n16 = 0;
+  for (unsigned i = 0; i < n; i++) n16 += ucs[i] >= 0x10000 ? 2 : 1;
+
+  check("fl_utf_nb_char", s, len, fl_utf_nb_char((const unsigned char *)s, len),
+        ref_nb_char((const unsigned char *)s, len));
+  check("fl_utf8test", s, len, fl_utf8test(s, len), ref_test(s, len));
+  check("fl_utf8toa", s, len, fl_utf8toa(s, len, 0, 0), n);
+  check("fl_utf8toUtf16", s, len, fl_utf8toUtf16(s, len, 0, 0), n16);
+  check("fl_utf8towc", s, len, fl_utf8towc(s, len, 0, 0), sizeof(wchar_t) == 2 ? n16 : n);
+
+  for (unsigned dstlen = 1; dstlen <= n + 1; dstlen++) {
+    // all characters that fit in dstlen-1 places are converted
+    check("fl_utf8toa length", s, len, fl_utf8toa(s, len, a, dstlen), n);
+    unsigned i;
+    for (i = 0; i + 1 < dstlen && i < n; i++)
+      check("fl_utf8toa char", s, len, a[i], latin1[i]);
+    check("fl_utf8toa nul", s, len, a[i], 0);
+    check("fl_utf8towc length", s, len, fl_utf8towc(s, len, wc, dstlen), sizeof(wchar_t) == 2 ? n16 : n);
+    if (sizeof(wchar_t) == 4) {
+      for (i = 0; i + 1 < dstlen && i < n; i++)
+        check("fl_utf8towc char", s, len, wc[i], ucs[i]);
+      check("fl_utf8towc nul", s, len, wc[i], 0);
+    }
+    unsigned m = fl_utf8toUtf16(s, len, u16, dstlen);
+    check("fl_utf8toUtf16 length", s, len, m, n16);
+    unsigned k = 0;
+    for (i = 0; k < n && i + 1 < dstlen; k++) {
+      if (ucs[k] < 0x10000) {
+        check("fl_utf8toUtf16 char", s, len, u16[i++], ucs[k]);
+      } else {
+        if (i + 2 >= dstlen) break;
+        check("fl_utf8toUtf16 pair", s, len, u16[i], (((ucs[k] - 0x10000) >> 10) & 0x3ff) | 0xd800);
+        i += 2;
+      }
+    }
+    check("fl_utf8toUtf16 nul", s, len, u16[i], 0);
+  }
+}
+
+static void bench(const char *title, const char *s, unsigned len) {
+  unsigned short *u16 = new unsigned short[len + 1];
+  wchar_t *wc = new wchar_t[len + 1];
+  char *a = new char[len + 1];
+  double mb = len / 1048576.0, t;
+  long sum = 0;
+  printf("%s (%.1f MB):\n", title, mb);
+  t = seconds(); sum += fl_utf_nb_char((const unsigned char *)s, len);
+  printf("  fl_utf_nb_char  %8.1f MB/s\n", mb / (seconds() - t + 1e-9));
+  t = seconds(); sum += fl_utf8test(s, len);
+  printf("  fl_utf8test     %8.1f MB/s\n", mb / (seconds() - t + 1e-9));
+  t = seconds(); sum += fl_utf8toUtf16(s, len, u16, len + 1);
+  printf("  fl_utf8toUtf16  %8.1f MB/s\n", mb / (seconds() - t + 1e-9));
+  t = seconds(); sum += fl_utf8towc(s, len, wc, len + 1);
+  printf("  fl_utf8towc     %8.1f MB/s\n", mb / (seconds() - t + 1e-9));
+  t = seconds(); sum += fl_utf8toa(s, len, a, len + 1);
+  printf("  fl_utf8toa      %8.1f MB/s\n", mb / (seconds() - t + 1e-9));
+  t = seconds(); sum += ref_nb_char((const unsigned char *)s, len);
+  printf("  (one character at a time: %.1f MB/s)\n", mb / (seconds() - t + 1e-9));
+  if (sum == 42) printf(" ");
+  delete[] u16;
+  delete[] wc;
+  delete[] a;
+}
+
+int main(int argc, char **argv) {
+  int megabytes = argc > 1 ? atoi(argv[1]) : 64;
+  if (megabytes < 1) megabytes = 1;
+  char buf[300];
+
+  srand(1);
+  for (int i = 0; i < 20000; i++) {
+    int len = rand() % 200;
+    random_text(buf, len, (i % 5) * 25);
+    compare(buf, len);
+  }
+  printf("%d mismatches in 20000 random strings\n", errors);
+
+  unsigned len = megabytes * 1048576;
+  char *text = new char[len];
+  random_text(text, len, 98, 0);
+  bench("Mostly ASCII text", text, len);
+  random_text(text, len, 0, 0);
+  bench("Text without ASCII", text, len);
+  delete[] text;
+  return errors ? 1 : 0;
+}